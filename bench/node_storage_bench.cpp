@@ -0,0 +1,198 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+/**
+ * Compares node_group storage policies for inserting, looking up and erasing
+ * nodes, on a densely populated square and on nodes scattered sparsely over a
+ * large area.
+ *
+ * Not part of the test suite; build it with optimizations enabled, and link
+ * it against cartograph, boost_thread and boost_system.
+ **/
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cartograph/node_group.h>
+#include <cartograph/node_storage.h>
+#include <cartograph/tile_traits.h>
+
+namespace cg = cartograph;
+
+namespace {
+
+struct bench_node
+{
+  bench_node(int value = 0)
+    : m_value(value)
+  {
+  }
+
+  int m_value;
+};
+
+
+class stopwatch
+{
+public:
+  stopwatch()
+    : m_start(boost::posix_time::microsec_clock::universal_time())
+  {
+  }
+
+  long
+  elapsed_ms() const
+  {
+    return (boost::posix_time::microsec_clock::universal_time()
+        - m_start).total_milliseconds();
+  }
+
+private:
+  boost::posix_time::ptime m_start;
+};
+
+
+/**
+ * Positions of a square of side * side nodes.
+ **/
+std::vector<cg::vector_t>
+dense_positions(int side)
+{
+  std::vector<cg::vector_t> ret;
+  for (int y = 0 ; y < side ; ++y) {
+    for (int x = 0 ; x < side ; ++x) {
+      ret.push_back(cg::vector_t(x, y));
+    }
+  }
+  return ret;
+}
+
+
+/**
+ * Pseudo-random positions within +/- range of the origin.
+ **/
+std::vector<cg::vector_t>
+sparse_positions(int count, int range)
+{
+  std::vector<cg::vector_t> ret;
+  unsigned int seed = 42;
+  for (int i = 0 ; i < count ; ++i) {
+    seed = seed * 1103515245 + 12345;
+    int x = int(seed % (2 * range)) - range;
+    seed = seed * 1103515245 + 12345;
+    int y = int(seed % (2 * range)) - range;
+    ret.push_back(cg::vector_t(x, y));
+  }
+  return ret;
+}
+
+
+template <
+  typename storageT
+>
+void
+run(std::string const & name, std::vector<cg::vector_t> const & positions)
+{
+  typedef cg::node_group<
+    bench_node,
+    cg::rectangular_tile_traits,
+    cg::simple_id_generator,
+    storageT
+  > map_t;
+  map_t m;
+
+  // Insert each position, look each up a few times, as pathfinding would,
+  // look up as many empty positions and finally erase all nodes.
+  stopwatch insert_time;
+  for (std::size_t i = 0 ; i < positions.size() ; ++i) {
+    m(positions[i]) = bench_node(int(i));
+  }
+  long insert_ms = insert_time.elapsed_ms();
+
+  long sum = 0;
+  stopwatch lookup_time;
+  for (int round = 0 ; round < 4 ; ++round) {
+    for (std::size_t i = 0 ; i < positions.size() ; ++i) {
+      if (!m.is_empty(positions[i])) {
+        sum += m(positions[i])->m_value;
+      }
+    }
+  }
+  long lookup_ms = lookup_time.elapsed_ms();
+
+  cg::vector_t offset(0, m.max_coords().m_y - m.min_coords().m_y + 1);
+  stopwatch miss_time;
+  for (std::size_t i = 0 ; i < positions.size() ; ++i) {
+    sum += m.is_empty(positions[i] + offset) ? 0 : 1;
+  }
+  long miss_ms = miss_time.elapsed_ms();
+
+  stopwatch erase_time;
+  for (std::size_t i = 0 ; i < positions.size() ; ++i) {
+    m.erase(positions[i]);
+  }
+  long erase_ms = erase_time.elapsed_ms();
+
+  std::cout << std::setw(10) << name
+    << std::setw(10) << insert_ms
+    << std::setw(10) << lookup_ms
+    << std::setw(10) << miss_ms
+    << std::setw(10) << erase_ms
+    << "   (" << sum << ")" << std::endl;
+}
+
+
+void
+header(std::string const & title)
+{
+  std::cout << std::endl << title << std::endl
+    << std::setw(10) << "storage"
+    << std::setw(10) << "insert"
+    << std::setw(10) << "lookup"
+    << std::setw(10) << "miss"
+    << std::setw(10) << "erase"
+    << "   [ms]" << std::endl;
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+  std::vector<cg::vector_t> dense = dense_positions(512);
+  header("dense, 512x512 nodes");
+  run<cg::map_storage>("map", dense);
+  run<cg::chunked_storage>("chunked", dense);
+  run<cg::hash_storage>("hash", dense);
+
+  // The chunked storage would allocate a chunk for nearly every node here,
+  // which takes more memory than is sensible; it's meant for dense groups.
+  std::vector<cg::vector_t> sparse = sparse_positions(262144, 1 << 20);
+  header("sparse, 262144 nodes within +/- 2^20");
+  run<cg::map_storage>("map", sparse);
+  run<cg::hash_storage>("hash", sparse);
+
+  return 0;
+}
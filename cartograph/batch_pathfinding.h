@@ -0,0 +1,157 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_BATCH_PATHFINDING_H
+#define CG_BATCH_PATHFINDING_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * A single query for the batch_pathfinder below. Fill in start and end; the
+ * batch_pathfinder fills in the result and error, which are the same as the
+ * result and return value of a_star().
+ **/
+struct path_query
+{
+  path_query(vector_t const & start = invalid_vector,
+      vector_t const & end = invalid_vector);
+
+  vector_t              m_start;
+  vector_t              m_end;
+
+  std::deque<vector_t>  m_result;
+  error_t               m_error;
+};
+
+
+
+/**
+ * The batch_pathfinder runs a_star() for many queries against the same
+ * node_group, spread over a number of worker threads. The threads are started
+ * in the constructor and kept around until the batch_pathfinder is destroyed,
+ * as is the memory they use for searching.
+ *
+ * Each thread uses it's own copy of the traversal traits and heuristic, so the
+ * traversal traits must satisfy the CloneableTraversalTraitsConcept: copies
+ * must not share any state that they modify. Each thread prepares it's
+ * heuristic once per query (see heuristic_function).
+ *
+ * The node_group is accessed from all threads at once, and must not be
+ * modified while find_paths() runs. Reading from a node_group concurrently is
+ * fine, with one exception: retrieving a node with the node_group's function
+ * call operator for a position that's empty modifies the node_group. Your
+ * traversal traits should therefore look nodes up with try_get_relative() or
+ * try_get(), which never modify the node_group.
+ *
+ * Using the batch_pathfinder requires linking against boost_thread.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class batch_pathfinder
+  : private boost::noncopyable
+{
+public:
+  /**
+   * See a_star() for details on the parameters.
+   *
+   * @param num_threads Number of worker threads to start; if zero, one thread
+   *    per CPU core is started.
+   **/
+  batch_pathfinder(node_groupT const & group,
+      traversal_traitsT const & traversal_traits, heuristicT const & heuristic,
+      std::size_t num_threads = 0);
+
+  /**
+   * Stops the worker threads.
+   **/
+  ~batch_pathfinder();
+
+  /**
+   * Runs a_star() for each of the queries, and returns once all are done.
+   * Several threads may call this function, but batches are processed one at
+   * a time.
+   *
+   * If a query throws, e.g. because the traversal traits retrieve a node for
+   * invalid coordinates, its error is set to the exception's error code, or
+   * CG_UNEXPECTED for exceptions of other types; the remaining queries are
+   * processed as usual.
+   **/
+  void find_paths(std::vector<path_query> & queries,
+      search_limits const & limits = search_limits());
+
+  /**
+   * Returns the number of worker threads.
+   **/
+  std::size_t num_threads() const;
+
+private:
+  struct worker
+  {
+    worker(traversal_traitsT const & traversal_traits,
+        heuristicT const & heuristic);
+
+    traversal_traitsT m_traversal_traits;
+    heuristicT        m_heuristic;
+    search_context    m_context;
+  };
+
+  void run(worker & w);
+  void stop();
+
+  node_groupT const &                     m_group;
+  std::vector<boost::shared_ptr<worker> > m_workers;
+  boost::thread_group                     m_threads;
+
+  // Serializes calls to find_paths()
+  boost::mutex                            m_batch_mutex;
+
+  // Protects the members below.
+  boost::mutex                            m_mutex;
+  boost::condition_variable               m_work_available;
+  boost::condition_variable               m_work_done;
+
+  std::vector<path_query> *               m_queries;
+  search_limits                           m_limits;
+  std::size_t                             m_next;
+  std::size_t                             m_pending;
+  bool                                    m_shutdown;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/batch_pathfinding.tcc>
+
+#endif // guard
@@ -0,0 +1,182 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_CONTRACTION_HIERARCHY_H
+#define CG_CONTRACTION_HIERARCHY_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+namespace detail {
+
+// See detail/contraction_hierarchy.tcc
+struct ch_edge_t;
+struct ch_search_t;
+
+} // namespace detail
+
+
+/**
+ * A contraction_hierarchy answers path queries on maps that don't change,
+ * in a fraction of the time a_star() would take, by doing most of the work
+ * up front.
+ *
+ * Computing it turns the node_group into a graph of the nodes and the moves
+ * between them, and then removes ("contracts") the nodes one by one, in an
+ * order that keeps the graph sparse. Whenever removing a node would make the
+ * remaining nodes more expensive to travel between, a shortcut edge that
+ * skips the node is added. Each node keeps the edges to the nodes contracted
+ * after it, split into an upward graph of the edges leaving the node and a
+ * downward graph of the edges entering it. Any cheapest path then climbs the
+ * upward graph from the start node and descends the downward graph to the end
+ * node, so queries only search upwards from both ends, which touches very few
+ * nodes. Shortcuts remember which node they skip, so found paths can be
+ * unpacked into tiles.
+ *
+ * Computing the hierarchy takes a while for large maps; the work is spread
+ * over a number of threads, and the result can be saved to and loaded from a
+ * file. The hierarchy refers to the node_group passed to the constructor,
+ * and describes the node_group and traversal traits at the time it was
+ * computed. If either changes, compute it again.
+ *
+ * Computing the hierarchy requires linking against boost_thread.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class contraction_hierarchy
+  : private boost::noncopyable
+{
+public:
+  /**
+   * Creates an empty hierarchy; use compute() or load() to fill it.
+   **/
+  explicit contraction_hierarchy(node_groupT const & group);
+  ~contraction_hierarchy();
+
+  /**
+   * Computes the hierarchy for the node_group. The traversal traits are
+   * copied and only used while computing the graph.
+   *
+   * @param num_threads Number of threads to use for contraction; if zero,
+   *    one thread per CPU core is used.
+   *
+   * @return CG_OK on success, or CG_INVALID_VALUE if the node_group is empty.
+   **/
+  error_t compute(traversal_traitsT const & traversal_traits,
+      std::size_t num_threads = 0);
+
+  /**
+   * Saves the hierarchy to the given file. The file can only be loaded on
+   * platforms with the same byte order and unit_t size.
+   *
+   * @return CG_OK on success, or CG_IO_ERROR if the file could not be written.
+   **/
+  error_t save(std::string const & filename) const;
+
+  /**
+   * Loads a hierarchy saved with save() above. The node_group's bounds must be
+   * the same as when the hierarchy was computed, and the nodes it contains
+   * must still be part of the node_group. If loading fails, the hierarchy is
+   * left unchanged.
+   *
+   * @return CG_OK on success, CG_IO_ERROR if the file could not be read, or
+   *    CG_INVALID_VALUE if it does not contain a hierarchy for this
+   *    node_group.
+   **/
+  error_t load(std::string const & filename);
+
+  /**
+   * Fills result with the cheapest path from start to end, in the same manner
+   * as a_star(). Queries reuse buffers held by the hierarchy, so concurrent
+   * queries on the same hierarchy are not possible.
+   *
+   * @return CG_OK if a path was found, CG_INVALID_COORDS if start or end are
+   *    not part of the hierarchy, CG_NO_PATH if there is no path, or
+   *    CG_INVALID_VALUE if the path's shortcuts can't be unpacked, which
+   *    load() guards against.
+   **/
+  error_t find_path(std::deque<vector_t> & result, vector_t const & start,
+      vector_t const & end);
+
+  /**
+   * Returns the costs of the cheapest path from start to end, or invalid_unit
+   * if there is no such path, or either node is not part of the hierarchy.
+   **/
+  unit_t path_cost(vector_t const & start, vector_t const & end);
+
+  /**
+   * Returns the number of nodes, and the number of edges including shortcuts
+   * in the upward and downward graphs.
+   **/
+  std::size_t node_count() const;
+  std::size_t edge_count() const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  unit_t query(uint32_t source, uint32_t target, uint32_t & meeting);
+  bool unpack(uint32_t source, uint32_t meeting,
+      std::deque<vector_t> & result) const;
+
+  uint32_t id_of(vector_t const & coords) const;
+  std::size_t index_of(vector_t const & coords) const;
+
+  node_groupT const &             m_group;
+
+  // Bounds of the node_group when the hierarchy was computed; see
+  // node_group::min_coords() and max_coords().
+  vector_t                        m_min;
+  vector_t                        m_max;
+
+  // For each position within the bounds, the node's id, and for each node
+  // it's coordinates.
+  std::vector<uint32_t>           m_ids;
+  std::vector<vector_t>           m_coords;
+
+  // The edges of node i in the upward and downward graphs are those in
+  // [offsets[i], offsets[i + 1]). Upward edges lead from node i, downward
+  // edges lead to it.
+  std::vector<uint32_t>           m_up_offsets;
+  std::vector<detail::ch_edge_t>  m_up;
+  std::vector<uint32_t>           m_down_offsets;
+  std::vector<detail::ch_edge_t>  m_down;
+
+  // Query state for the search from the start and end node respectively.
+  boost::scoped_ptr<detail::ch_search_t>  m_forward;
+  boost::scoped_ptr<detail::ch_search_t>  m_backward;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/contraction_hierarchy.tcc>
+
+#endif // guard
@@ -0,0 +1,211 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_D_STAR_LITE_H
+#define CG_D_STAR_LITE_H
+
+#include <deque>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * A d_star_lite planner keeps the path from a moving start node to a fixed
+ * goal up to date while the node_group or traversal traits change, using the
+ * D* Lite algorithm. It searches backwards from the goal, and keeps the
+ * costs it determined between calls; when nodes change, replanning only
+ * revisits the nodes whose costs are affected by the change, and only as many
+ * of those as are needed to find the path from the current start node.
+ *
+ * Use it for units that follow a path while the map changes under them: call
+ * compute() once, then move_start() whenever the unit moves and invalidate()
+ * for every node that was added, removed or modified, and update() before the
+ * unit needs to know where to go next.
+ *
+ * The heuristic estimates the costs between the start node and other nodes,
+ * and is called with start and end swapped, as in bidirectional_a_star(). It
+ * must be consistent, i.e. never estimate more than the costs of moving to a
+ * neighbour plus the estimate for that neighbour. Rather than once per
+ * search, it's prepared again each time update() finds that the start node
+ * has moved; see heuristic_function for the heuristicT parameter.
+ *
+ * The planner refers to the node_group and traversal traits passed to it's
+ * constructor for as long as it exists, and requires memory for two costs and
+ * a queue key for each position within the node_group's bounds. Start and end
+ * node must be part of the node_group, and moves into a node that's not part
+ * of it are impossible; otherwise the traversal traits' is_impassable() and
+ * traversal_cost() determine the moves.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class d_star_lite
+  : private boost::noncopyable
+{
+public:
+  d_star_lite(node_groupT const & group, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic);
+
+  /**
+   * Plans a path from start to goal from scratch.
+   *
+   * @return CG_OK if there is a path, CG_INVALID_COORDS if start or goal are
+   *    not part of the node_group, or CG_NO_PATH if the goal cannot be reached
+   *    from the start node.
+   **/
+  error_t compute(vector_t const & start, vector_t const & goal);
+
+  /**
+   * Moves the start node, e.g. because the unit following the path moved.
+   * This is cheap; the path from the new start node is determined by the next
+   * call to update().
+   *
+   * @return CG_OK, or CG_INVALID_COORDS if the start node lies outside the
+   *    bounds of the node_group at the time of the last compute().
+   **/
+  error_t move_start(vector_t const & start);
+
+  /**
+   * Marks the given node, or all nodes within the given bounds (max being
+   * exclusive, as with node_group::max_coords()), as changed. Call this
+   * whenever a node is added, removed or modified in ways that affect
+   * pathfinding.
+   **/
+  void invalidate(vector_t const & coords);
+  void invalidate(vector_t const & min, vector_t const & max);
+
+  /**
+   * Replans the path from the start node, taking into account the nodes
+   * marked via invalidate(). If the node_group has grown beyond it's previous
+   * bounds, the path is planned from scratch.
+   *
+   * @return The same values as compute().
+   **/
+  error_t update();
+
+  /**
+   * Returns the start and goal nodes, or invalid_vector if compute() was not
+   * called yet.
+   **/
+  vector_t start() const;
+  vector_t goal() const;
+
+  /**
+   * Returns the costs of the cheapest path from the start node to the goal as
+   * of the last update(), or invalid_unit if there is no such path.
+   **/
+  unit_t cost() const;
+
+  /**
+   * Returns the node to move to from the start node, or invalid_vector if
+   * there is no path, or the start node is the goal.
+   **/
+  vector_t next() const;
+
+  /**
+   * Fills result with the path from the start node to the goal, in the same
+   * manner as a_star().
+   *
+   * @return CG_OK, or CG_NO_PATH if there is no path.
+   **/
+  error_t path(std::deque<vector_t> & result) const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  // Queue keys are compared lexicographically; the queue holds the node's
+  // index along with it's key, and entries for nodes whose key has changed
+  // since are skipped.
+  typedef std::pair<unit_t, unit_t>         key_t;
+  typedef std::pair<key_t, std::size_t>     queue_entry_t;
+  typedef std::priority_queue<
+    queue_entry_t,
+    std::vector<queue_entry_t>,
+    std::greater<queue_entry_t>
+  >                                         queue_t;
+
+  void reset();
+
+  key_t calculate_key(std::size_t index) const;
+  void update_node(std::size_t index);
+  void update_rhs(std::size_t index);
+  void compute_shortest_path();
+  bool top(queue_entry_t & entry);
+
+  std::size_t best_successor(std::size_t index, unit_t & cost) const;
+
+  std::size_t index_of(vector_t const & coords) const;
+  vector_t coords_of(std::size_t index) const;
+
+  node_groupT const &       m_group;
+  traversal_traitsT &       m_traversal_traits;
+  join_t                    m_join_types;
+
+  // The heuristic, prepared with the goal as start and the start node as end.
+  // Plain heuristics aren't necessarily callable when const.
+  mutable detail::bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  >                         m_heuristic;
+
+  vector_t                  m_start;
+  vector_t                  m_goal;
+
+  // The start node as of the last update, and the sum of the heuristic's
+  // estimates between all start nodes so far; both serve to keep the keys of
+  // queued nodes valid when the start node moves.
+  vector_t                  m_last_start;
+  unit_t                    m_key_modifier;
+
+  // Bounds of the node_group when the path was computed; see
+  // node_group::min_coords() and max_coords().
+  vector_t                  m_min;
+  vector_t                  m_max;
+
+  // For each position within the bounds, the costs of the cheapest path to
+  // the goal as determined so far (G), and as determined from the neighbours'
+  // G (RHS). Nodes where the two differ are queued with the given key.
+  std::vector<unit_t>       m_g;
+  std::vector<unit_t>       m_rhs;
+  std::vector<key_t>        m_keys;
+  std::vector<bool>         m_queued;
+  queue_t                   m_queue;
+
+  // Nodes marked by invalidate() since the last update.
+  std::vector<vector_t>     m_dirty;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/d_star_lite.tcc>
+
+#endif // guard
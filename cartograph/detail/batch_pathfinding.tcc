@@ -0,0 +1,229 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <boost/bind/bind.hpp>
+
+
+namespace cartograph {
+namespace pathfinding {
+
+/*****************************************************************************
+ * struct path_query
+ */
+
+inline
+path_query::path_query(vector_t const & start /* = invalid_vector */,
+    vector_t const & end /* = invalid_vector */)
+  : m_start(start)
+  , m_end(end)
+  , m_error(CG_OK)
+{
+}
+
+
+
+/*****************************************************************************
+ * class batch_pathfinder
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+batch_pathfinder<node_groupT, traversal_traitsT, heuristicT>::worker::worker(
+    traversal_traitsT const & traversal_traits, heuristicT const & heuristic)
+  : m_traversal_traits(traversal_traits)
+  , m_heuristic(heuristic)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+batch_pathfinder<node_groupT, traversal_traitsT, heuristicT>::batch_pathfinder(
+    node_groupT const & group, traversal_traitsT const & traversal_traits,
+    heuristicT const & heuristic, std::size_t num_threads /* = 0 */)
+  : m_group(group)
+  , m_queries(0)
+  , m_next(0)
+  , m_pending(0)
+  , m_shutdown(false)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::CloneableTraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  if (!num_threads) {
+    num_threads = boost::thread::hardware_concurrency();
+  }
+  if (!num_threads) {
+    num_threads = 1;
+  }
+
+  try {
+    for (std::size_t i = 0 ; i < num_threads ; ++i) {
+      m_workers.push_back(boost::shared_ptr<worker>(
+            new worker(traversal_traits, heuristic)));
+      m_threads.create_thread(boost::bind(&batch_pathfinder::run, this,
+            boost::ref(*m_workers.back())));
+    }
+  } catch (...) {
+    // The destructor won't run, so the threads started so far must be
+    // stopped here.
+    stop();
+    throw;
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+batch_pathfinder<node_groupT, traversal_traitsT,
+  heuristicT>::~batch_pathfinder()
+{
+  stop();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+batch_pathfinder<node_groupT, traversal_traitsT, heuristicT>::find_paths(
+    std::vector<path_query> & queries,
+    search_limits const & limits /* = search_limits() */)
+{
+  if (queries.empty()) {
+    return;
+  }
+
+  boost::mutex::scoped_lock batch_lock(m_batch_mutex);
+
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_queries = &queries;
+  m_limits = limits;
+  m_next = 0;
+  m_pending = queries.size();
+  m_work_available.notify_all();
+
+  while (m_pending) {
+    m_work_done.wait(lock);
+  }
+  m_queries = 0;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+std::size_t
+batch_pathfinder<node_groupT, traversal_traitsT,
+  heuristicT>::num_threads() const
+{
+  return m_workers.size();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+batch_pathfinder<node_groupT, traversal_traitsT, heuristicT>::run(worker & w)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  while (true) {
+    while (!m_shutdown && (!m_queries || m_next >= m_queries->size())) {
+      m_work_available.wait(lock);
+    }
+    if (m_shutdown) {
+      return;
+    }
+
+    // Claim the next query, and process it without holding the lock.
+    path_query & query = (*m_queries)[m_next++];
+    search_limits limits = m_limits;
+    lock.unlock();
+
+    query.m_result.clear();
+    try {
+      query.m_error = a_star(query.m_result, m_group, query.m_start,
+          query.m_end, w.m_traversal_traits, w.m_heuristic, limits,
+          w.m_context);
+    } catch (exception const & ex) {
+      query.m_result.clear();
+      query.m_error = ex;
+    } catch (...) {
+      query.m_result.clear();
+      query.m_error = CG_UNEXPECTED;
+    }
+
+    lock.lock();
+    if (!--m_pending) {
+      m_work_done.notify_all();
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+batch_pathfinder<node_groupT, traversal_traitsT, heuristicT>::stop()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_work_available.notify_all();
+  m_threads.join_all();
+}
+
+
+}} // namespace cartograph::pathfinding
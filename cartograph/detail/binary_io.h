@@ -0,0 +1,107 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_DETAIL_BINARY_IO_H
+#define CG_DETAIL_BINARY_IO_H
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#include <cartograph/error.h>
+#include <cartograph/types.h>
+
+namespace cartograph {
+namespace pathfinding {
+namespace detail {
+
+/**
+ * Helpers for the files written by landmark_table, contraction_hierarchy and
+ * the like. Values are written as they are in memory, so such files can only
+ * be read on platforms with the same byte order and type sizes; the file
+ * headers record both.
+ **/
+template <typename valueT>
+inline void
+write_value(std::ostream & os, valueT const & value)
+{
+  os.write(reinterpret_cast<char const *>(&value), sizeof(valueT));
+}
+
+
+template <typename valueT>
+inline void
+read_value(std::istream & is, valueT & value)
+{
+  is.read(reinterpret_cast<char *>(&value), sizeof(valueT));
+}
+
+
+// Written as is, so that files with a different byte order can be detected.
+static const uint32_t FILE_BYTE_ORDER = 0x01020304;
+
+
+/**
+ * Writes the file header: the file type's magic and version, followed by the
+ * byte order and the size of unit_t.
+ **/
+inline void
+write_header(std::ostream & os, char const (&magic)[4], uint32_t version)
+{
+  os.write(magic, sizeof(magic));
+  write_value(os, version);
+  write_value(os, FILE_BYTE_ORDER);
+  write_value(os, uint32_t(sizeof(unit_t)));
+}
+
+
+/**
+ * Reads the file header written by write_header(), and returns CG_IO_ERROR if
+ * it can't be read, or CG_INVALID_VALUE if it doesn't match the given magic
+ * and version, or this platform.
+ **/
+inline error_t
+read_header(std::istream & is, char const (&magic)[4], uint32_t version)
+{
+  char file_magic[sizeof(magic)];
+  uint32_t file_version = 0;
+  uint32_t byte_order = 0;
+  uint32_t unit_size = 0;
+  is.read(file_magic, sizeof(file_magic));
+  read_value(is, file_version);
+  read_value(is, byte_order);
+  read_value(is, unit_size);
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+  if (0 != std::memcmp(file_magic, magic, sizeof(magic))
+      || file_version != version
+      || byte_order != FILE_BYTE_ORDER
+      || unit_size != sizeof(unit_t))
+  {
+    return CG_INVALID_VALUE;
+  }
+  return CG_OK;
+}
+
+}}} // namespace cartograph::pathfinding::detail
+
+#endif // guard
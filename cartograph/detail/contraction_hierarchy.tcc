@@ -0,0 +1,1110 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <utility>
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cartograph/detail/binary_io.h>
+
+
+namespace cartograph {
+namespace pathfinding {
+
+namespace detail {
+
+// File format version written by contraction_hierarchy::save()
+static const uint32_t CH_FILE_VERSION = 1;
+
+static char const CH_FILE_MAGIC[4] = { 'C', 'G', 'C', 'H' };
+
+// Node ids are indices into the hierarchy's node list.
+static const uint32_t ch_invalid_node
+  = boost::integer_traits<uint32_t>::const_max;
+
+// Witness searches give up after settling this many nodes, and assume there
+// is no witness. That only adds shortcuts that aren't strictly necessary.
+// Priorities are estimates anyway, so their searches give up sooner.
+static const std::size_t CH_WITNESS_SETTLE_LIMIT = 500;
+static const std::size_t CH_PRIORITY_SETTLE_LIMIT = 10;
+
+// Nodes are handed to the contracting threads in chunks of this size.
+static const std::size_t CH_CHUNK_SIZE = 64;
+
+
+/**
+ * An edge to or from the given node; shortcuts skip the middle node, other
+ * edges have ch_invalid_node there.
+ **/
+struct ch_edge_t
+{
+  ch_edge_t(uint32_t node = ch_invalid_node, unit_t cost = 0,
+      uint32_t middle = ch_invalid_node)
+    : m_node(node)
+    , m_cost(cost)
+    , m_middle(middle)
+  {
+  }
+
+  uint32_t  m_node;
+  unit_t    m_cost;
+  uint32_t  m_middle;
+};
+
+typedef std::vector<ch_edge_t> ch_edges_t;
+
+
+/**
+ * Returns the edge of the given node to or from other, or 0 if there is none.
+ * The edges of node i are those in [offsets[i], offsets[i + 1]).
+ **/
+inline ch_edge_t const *
+ch_find_edge(std::vector<uint32_t> const & offsets,
+    std::vector<ch_edge_t> const & edges, uint32_t node, uint32_t other)
+{
+  for (uint32_t i = offsets[node] ; i < offsets[node + 1] ; ++i) {
+    if (edges[i].m_node == other) {
+      return &edges[i];
+    }
+  }
+  return 0;
+}
+
+
+/**
+ * Dijkstra's algorithm over node ids, with a binary heap that skips stale
+ * entries. Costs are kept for all nodes, and reset only for those touched by
+ * the previous search.
+ **/
+struct ch_search_t
+{
+  typedef std::pair<unit_t, uint32_t> entry_t;
+
+  void reset(std::size_t num_nodes)
+  {
+    if (m_cost.size() != num_nodes) {
+      m_cost.assign(num_nodes, infinite_cost);
+      m_parent.resize(num_nodes);
+    }
+    else {
+      for (std::size_t i = 0 ; i < m_touched.size() ; ++i) {
+        m_cost[m_touched[i]] = infinite_cost;
+      }
+    }
+    m_touched.clear();
+    m_heap.clear();
+  }
+
+
+  void push(uint32_t node, unit_t cost, ch_edge_t const & parent)
+  {
+    if (cost >= m_cost[node]) {
+      return;
+    }
+    if (infinite_cost == m_cost[node]) {
+      m_touched.push_back(node);
+    }
+    m_cost[node] = cost;
+    m_parent[node] = parent;
+    m_heap.push_back(entry_t(cost, node));
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<entry_t>());
+  }
+
+
+  // Lower bound for the costs of the next node pop() returns.
+  unit_t top() const
+  {
+    return m_heap.empty() ? infinite_cost : m_heap.front().first;
+  }
+
+
+  bool pop(uint32_t & node)
+  {
+    while (!m_heap.empty()) {
+      entry_t entry = m_heap.front();
+      std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<entry_t>());
+      m_heap.pop_back();
+      if (entry.first == m_cost[entry.second]) {
+        node = entry.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+  std::vector<unit_t>     m_cost;
+  // The edge via which each node was reached: from the node in the forward
+  // search, and to it in the backward search.
+  std::vector<ch_edge_t>  m_parent;
+  std::vector<uint32_t>   m_touched;
+  std::vector<entry_t>    m_heap;
+};
+
+
+/**
+ * A shortcut to be added when the middle node is contracted.
+ **/
+struct ch_shortcut_t
+{
+  ch_shortcut_t(uint32_t from, uint32_t to, unit_t cost)
+    : m_from(from)
+    , m_to(to)
+    , m_cost(cost)
+  {
+  }
+
+  uint32_t  m_from;
+  uint32_t  m_to;
+  unit_t    m_cost;
+};
+
+typedef std::vector<ch_shortcut_t> ch_shortcuts_t;
+
+
+/**
+ * Contracts a graph given by add_edge() and produces the upward and
+ * downward graphs of the contraction_hierarchy.
+ *
+ * Nodes are ordered by their edge difference, i.e. the number of shortcuts
+ * contracting them would add less the number of edges it removes, plus the
+ * number of their neighbours that were contracted already, which spreads
+ * contraction evenly over the map. Each round contracts all nodes whose
+ * priority is lower than that of their neighbours; as those are independent
+ * of each other, their shortcuts and their neighbours' new priorities are
+ * computed in parallel.
+ **/
+class ch_builder
+  : private boost::noncopyable
+{
+public:
+  explicit ch_builder(std::size_t num_nodes)
+    : m_out(num_nodes)
+    , m_in(num_nodes)
+    , m_up(num_nodes)
+    , m_down(num_nodes)
+  {
+  }
+
+
+  void add_edge(uint32_t from, uint32_t to, unit_t cost)
+  {
+    add_shortcut(from, to, cost, ch_invalid_node);
+  }
+
+
+  void contract(std::size_t num_threads)
+  {
+    std::size_t const num_nodes = m_out.size();
+    m_priority.assign(num_nodes, 0);
+    m_deleted.assign(num_nodes, 0);
+    m_contracted.assign(num_nodes, 0);
+    m_contracting.assign(num_nodes, 0);
+    m_searches.assign(num_threads, ch_search_t());
+
+    std::vector<uint32_t> remaining(num_nodes);
+    for (std::size_t i = 0 ; i < num_nodes ; ++i) {
+      remaining[i] = uint32_t(i);
+    }
+    run(remaining, false);
+
+    std::vector<uint32_t> batch;
+    std::vector<uint32_t> neighbours;
+    while (!remaining.empty()) {
+      // There always is at least one such node, namely the one with the
+      // lowest priority.
+      batch.clear();
+      for (std::size_t i = 0 ; i < remaining.size() ; ++i) {
+        if (is_local_minimum(remaining[i])) {
+          batch.push_back(remaining[i]);
+          m_contracting[remaining[i]] = 1;
+        }
+      }
+
+      m_shortcuts.assign(batch.size(), ch_shortcuts_t());
+      run(batch, true);
+
+      neighbours.clear();
+      for (std::size_t i = 0 ; i < batch.size() ; ++i) {
+        apply(batch[i], m_shortcuts[i], neighbours);
+      }
+      for (std::size_t i = 0 ; i < batch.size() ; ++i) {
+        m_contracting[batch[i]] = 0;
+        m_contracted[batch[i]] = 1;
+      }
+
+      std::sort(neighbours.begin(), neighbours.end());
+      neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+          neighbours.end());
+      run(neighbours, false);
+
+      std::size_t kept = 0;
+      for (std::size_t i = 0 ; i < remaining.size() ; ++i) {
+        if (!m_contracted[remaining[i]]) {
+          remaining[kept++] = remaining[i];
+        }
+      }
+      remaining.resize(kept);
+    }
+
+    m_shortcuts.clear();
+    m_searches.clear();
+  }
+
+
+  // Edges leading from and to each node respectively, to nodes contracted
+  // after it.
+  ch_edges_t const & up(uint32_t node) const
+  {
+    return m_up[node];
+  }
+
+
+  ch_edges_t const & down(uint32_t node) const
+  {
+    return m_down[node];
+  }
+
+private:
+  struct work_state
+  {
+    work_state()
+      : m_next(0)
+    {
+    }
+
+    std::size_t   m_next;
+    boost::mutex  m_mutex;
+  };
+
+
+  bool has_lower_priority(uint32_t first, uint32_t second) const
+  {
+    return m_priority[first] < m_priority[second]
+      || (m_priority[first] == m_priority[second] && first < second);
+  }
+
+
+  bool is_local_minimum(uint32_t node) const
+  {
+    for (std::size_t i = 0 ; i < m_out[node].size() ; ++i) {
+      if (has_lower_priority(m_out[node][i].m_node, node)) {
+        return false;
+      }
+    }
+    for (std::size_t i = 0 ; i < m_in[node].size() ; ++i) {
+      if (has_lower_priority(m_in[node][i].m_node, node)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+  /**
+   * Either computes the shortcuts for contracting each of the given nodes, or
+   * their priorities, using as many threads as there are searches.
+   **/
+  void run(std::vector<uint32_t> const & nodes, bool shortcuts)
+  {
+    std::size_t num_threads = std::min(m_searches.size(),
+        (nodes.size() + CH_CHUNK_SIZE - 1) / CH_CHUNK_SIZE);
+
+    work_state state;
+    if (num_threads <= 1) {
+      work(&nodes, shortcuts, &state, &m_searches[0]);
+      return;
+    }
+
+    boost::thread_group threads;
+    for (std::size_t i = 0 ; i < num_threads ; ++i) {
+      threads.create_thread(boost::bind(&ch_builder::work, this, &nodes,
+            shortcuts, &state, &m_searches[i]));
+    }
+    threads.join_all();
+  }
+
+
+  void work(std::vector<uint32_t> const * nodes, bool shortcuts,
+      work_state * state, ch_search_t * search)
+  {
+    ch_shortcuts_t scratch;
+
+    while (true) {
+      std::size_t begin = 0;
+      {
+        boost::mutex::scoped_lock lock(state->m_mutex);
+        begin = state->m_next;
+        state->m_next += CH_CHUNK_SIZE;
+      }
+      if (begin >= nodes->size()) {
+        return;
+      }
+
+      std::size_t end = std::min(begin + CH_CHUNK_SIZE, nodes->size());
+      for (std::size_t i = begin ; i < end ; ++i) {
+        uint32_t node = (*nodes)[i];
+        if (shortcuts) {
+          find_shortcuts(*search, node, CH_WITNESS_SETTLE_LIMIT,
+              m_shortcuts[i]);
+          continue;
+        }
+
+        scratch.clear();
+        find_shortcuts(*search, node, CH_PRIORITY_SETTLE_LIMIT, scratch);
+        m_priority[node] = long(scratch.size())
+          - long(m_out[node].size() + m_in[node].size())
+          + long(m_deleted[node]);
+      }
+    }
+  }
+
+
+  /**
+   * Finds the shortcuts needed to contract the given node: for each pair of
+   * edges entering and leaving it, one is needed unless a witness search finds
+   * a path between the other ends that avoids the node (and any other node
+   * contracted in the same round) and is no more expensive.
+   **/
+  void find_shortcuts(ch_search_t & search, uint32_t node,
+      std::size_t settle_limit, ch_shortcuts_t & result) const
+  {
+    ch_edges_t const & in = m_in[node];
+    ch_edges_t const & out = m_out[node];
+
+    for (std::size_t i = 0 ; i < in.size() ; ++i) {
+      uint32_t from = in[i].m_node;
+
+      unit_t limit = -1;
+      for (std::size_t j = 0 ; j < out.size() ; ++j) {
+        if (out[j].m_node != from) {
+          limit = std::max(limit, in[i].m_cost + out[j].m_cost);
+        }
+      }
+      if (limit < 0) {
+        continue;
+      }
+
+      witness_search(search, from, node, limit, settle_limit);
+
+      for (std::size_t j = 0 ; j < out.size() ; ++j) {
+        uint32_t to = out[j].m_node;
+        unit_t cost = in[i].m_cost + out[j].m_cost;
+        if (to != from && search.m_cost[to] > cost) {
+          result.push_back(ch_shortcut_t(from, to, cost));
+        }
+      }
+    }
+  }
+
+
+  void witness_search(ch_search_t & search, uint32_t source, uint32_t avoid,
+      unit_t limit, std::size_t settle_limit) const
+  {
+    search.reset(m_out.size());
+    search.push(source, 0, ch_edge_t());
+
+    std::size_t settled = 0;
+    uint32_t node = ch_invalid_node;
+    while (search.top() <= limit && settled++ < settle_limit
+        && search.pop(node))
+    {
+      unit_t cost = search.m_cost[node];
+      ch_edges_t const & out = m_out[node];
+      for (std::size_t i = 0 ; i < out.size() ; ++i) {
+        uint32_t next = out[i].m_node;
+        if (next != avoid && !m_contracting[next]) {
+          search.push(next, cost + out[i].m_cost, ch_edge_t());
+        }
+      }
+    }
+  }
+
+
+  void apply(uint32_t node, ch_shortcuts_t const & shortcuts,
+      std::vector<uint32_t> & neighbours)
+  {
+    m_up[node].swap(m_out[node]);
+    m_down[node].swap(m_in[node]);
+
+    for (std::size_t i = 0 ; i < m_up[node].size() ; ++i) {
+      uint32_t to = m_up[node][i].m_node;
+      remove_edge(m_in[to], node);
+      ++m_deleted[to];
+      neighbours.push_back(to);
+    }
+    for (std::size_t i = 0 ; i < m_down[node].size() ; ++i) {
+      uint32_t from = m_down[node][i].m_node;
+      remove_edge(m_out[from], node);
+      ++m_deleted[from];
+      neighbours.push_back(from);
+    }
+
+    for (std::size_t i = 0 ; i < shortcuts.size() ; ++i) {
+      add_shortcut(shortcuts[i].m_from, shortcuts[i].m_to,
+          shortcuts[i].m_cost, node);
+    }
+  }
+
+
+  static void remove_edge(ch_edges_t & edges, uint32_t node)
+  {
+    for (std::size_t i = 0 ; i < edges.size() ; ++i) {
+      if (edges[i].m_node == node) {
+        edges[i] = edges.back();
+        edges.pop_back();
+        return;
+      }
+    }
+  }
+
+
+  // Adds the edge, or replaces an existing edge between the same nodes if
+  // it's cheaper.
+  void add_shortcut(uint32_t from, uint32_t to, unit_t cost, uint32_t middle)
+  {
+    ch_edges_t & out = m_out[from];
+    for (std::size_t i = 0 ; i < out.size() ; ++i) {
+      if (out[i].m_node != to) {
+        continue;
+      }
+      if (cost < out[i].m_cost) {
+        out[i] = ch_edge_t(to, cost, middle);
+        ch_edges_t & in = m_in[to];
+        for (std::size_t j = 0 ; j < in.size() ; ++j) {
+          if (in[j].m_node == from) {
+            in[j] = ch_edge_t(from, cost, middle);
+          }
+        }
+      }
+      return;
+    }
+
+    out.push_back(ch_edge_t(to, cost, middle));
+    m_in[to].push_back(ch_edge_t(from, cost, middle));
+  }
+
+
+  // The graph of nodes not yet contracted.
+  std::vector<ch_edges_t>     m_out;
+  std::vector<ch_edges_t>     m_in;
+
+  std::vector<ch_edges_t>     m_up;
+  std::vector<ch_edges_t>     m_down;
+
+  std::vector<long>           m_priority;
+  std::vector<uint32_t>       m_deleted;
+  std::vector<char>           m_contracted;
+  std::vector<char>           m_contracting;
+
+  // Per round, the shortcuts for each contracted node; and per thread, the
+  // witness search.
+  std::vector<ch_shortcuts_t> m_shortcuts;
+  std::vector<ch_search_t>    m_searches;
+};
+
+
+/**
+ * Writes edges and their offsets, or reads them and checks that they refer to
+ * the given number of nodes.
+ **/
+inline void
+ch_write_edges(std::ostream & os, std::vector<uint32_t> const & offsets,
+    std::vector<ch_edge_t> const & edges)
+{
+  write_value(os, uint64_t(edges.size()));
+  for (std::size_t i = 0 ; i < offsets.size() ; ++i) {
+    write_value(os, offsets[i]);
+  }
+  for (std::size_t i = 0 ; i < edges.size() ; ++i) {
+    write_value(os, edges[i].m_node);
+    write_value(os, edges[i].m_cost);
+    write_value(os, edges[i].m_middle);
+  }
+}
+
+
+inline bool
+ch_read_edges(std::istream & is, std::size_t num_nodes,
+    std::vector<uint32_t> & offsets, std::vector<ch_edge_t> & edges)
+{
+  uint64_t count = 0;
+  read_value(is, count);
+  if (!is) {
+    return false;
+  }
+
+  offsets.resize(num_nodes + 1);
+  for (std::size_t i = 0 ; i < offsets.size() && is ; ++i) {
+    read_value(is, offsets[i]);
+    if (offsets[i] > count || (i && offsets[i] < offsets[i - 1])) {
+      return false;
+    }
+  }
+  if (!is || offsets[0] != 0 || offsets[num_nodes] != count) {
+    return false;
+  }
+
+  edges.clear();
+  for (uint64_t i = 0 ; i < count && is ; ++i) {
+    ch_edge_t edge;
+    read_value(is, edge.m_node);
+    read_value(is, edge.m_cost);
+    read_value(is, edge.m_middle);
+    if (edge.m_node >= num_nodes
+        || (edge.m_middle != ch_invalid_node && edge.m_middle >= num_nodes))
+    {
+      return false;
+    }
+    edges.push_back(edge);
+  }
+  return !is.fail();
+}
+
+
+/**
+ * Checks that the edges the given shortcut from one node to another skips
+ * exist, and add up to its cost: the edge to the middle node is a downward
+ * edge of the middle node, the edge from it an upward edge. Edges that aren't
+ * shortcuts always pass.
+ **/
+inline bool
+ch_check_shortcut(std::vector<uint32_t> const & up_offsets,
+    std::vector<ch_edge_t> const & up,
+    std::vector<uint32_t> const & down_offsets,
+    std::vector<ch_edge_t> const & down, uint32_t from, uint32_t to,
+    ch_edge_t const & edge)
+{
+  if (edge.m_middle == ch_invalid_node) {
+    return true;
+  }
+  ch_edge_t const * first = ch_find_edge(down_offsets, down, edge.m_middle,
+      from);
+  ch_edge_t const * second = ch_find_edge(up_offsets, up, edge.m_middle, to);
+  return first && second && first->m_cost + second->m_cost == edge.m_cost;
+}
+
+} // namespace detail
+
+
+/*****************************************************************************
+ * class contraction_hierarchy
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+contraction_hierarchy<node_groupT, traversal_traitsT>::contraction_hierarchy(
+    node_groupT const & group)
+  : m_group(group)
+  , m_min(invalid_vector)
+  , m_max(invalid_vector)
+  , m_forward(new detail::ch_search_t())
+  , m_backward(new detail::ch_search_t())
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+contraction_hierarchy<node_groupT, traversal_traitsT>::~contraction_hierarchy()
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::compute(
+    traversal_traitsT const & traversal_traits,
+    std::size_t num_threads /* = 0 */)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::CloneableTraversalTraitsConcept<traversal_traitsT>
+  >();
+#endif
+
+  if (!m_group.size()) {
+    return CG_INVALID_VALUE;
+  }
+
+  m_min = m_group.min_coords();
+  m_max = m_group.max_coords();
+
+  std::size_t cells = std::size_t(m_max.m_x - m_min.m_x)
+    * std::size_t(m_max.m_y - m_min.m_y);
+  m_ids.assign(cells, detail::ch_invalid_node);
+  m_coords.clear();
+
+  for (unit_t y = m_min.m_y ; y < m_max.m_y ; ++y) {
+    for (unit_t x = m_min.m_x ; x < m_max.m_x ; ++x) {
+      vector_t coords(x, y);
+      if (!m_group.is_empty(coords)) {
+        m_ids[index_of(coords)] = uint32_t(m_coords.size());
+        m_coords.push_back(coords);
+      }
+    }
+  }
+
+  // The graph is built with a single copy of the traversal traits; only
+  // contraction, which doesn't need them, is spread over threads.
+  traversal_traitsT traits(traversal_traits);
+  join_t const join_types = traits.join_types();
+
+  detail::ch_builder builder(m_coords.size());
+  for (uint32_t id = 0 ; id < m_coords.size() ; ++id) {
+    vector_t const & coords = m_coords[id];
+    directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+        join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      uint32_t neighbour = id_of(tile_traits_t::get_relative(coords, *d));
+      if (neighbour == detail::ch_invalid_node
+          || traits.is_impassable(coords, *d))
+      {
+        continue;
+      }
+      builder.add_edge(id, neighbour, traits.traversal_cost(coords, *d));
+    }
+  }
+
+  if (!num_threads) {
+    num_threads = boost::thread::hardware_concurrency();
+  }
+  builder.contract(std::max(std::size_t(1), num_threads));
+
+  m_up_offsets.assign(1, 0);
+  m_down_offsets.assign(1, 0);
+  m_up.clear();
+  m_down.clear();
+  for (uint32_t id = 0 ; id < m_coords.size() ; ++id) {
+    m_up.insert(m_up.end(), builder.up(id).begin(), builder.up(id).end());
+    m_down.insert(m_down.end(), builder.down(id).begin(),
+        builder.down(id).end());
+    m_up_offsets.push_back(uint32_t(m_up.size()));
+    m_down_offsets.push_back(uint32_t(m_down.size()));
+  }
+
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::save(
+    std::string const & filename) const
+{
+  std::ofstream os(filename.c_str(),
+      std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os) {
+    return CG_IO_ERROR;
+  }
+
+  detail::write_header(os, detail::CH_FILE_MAGIC,
+      detail::CH_FILE_VERSION);
+
+  detail::write_value(os, m_min.m_x);
+  detail::write_value(os, m_min.m_y);
+  detail::write_value(os, m_max.m_x);
+  detail::write_value(os, m_max.m_y);
+
+  detail::write_value(os, uint64_t(m_coords.size()));
+  for (std::size_t i = 0 ; i < m_coords.size() ; ++i) {
+    detail::write_value(os, m_coords[i].m_x);
+    detail::write_value(os, m_coords[i].m_y);
+  }
+
+  if (!m_coords.empty()) {
+    detail::ch_write_edges(os, m_up_offsets, m_up);
+    detail::ch_write_edges(os, m_down_offsets, m_down);
+  }
+
+  os.close();
+  return os ? CG_OK : CG_IO_ERROR;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::load(
+    std::string const & filename)
+{
+  std::ifstream is(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+
+  error_t err = detail::read_header(is, detail::CH_FILE_MAGIC,
+      detail::CH_FILE_VERSION);
+  if (CG_OK != err) {
+    return err;
+  }
+
+  vector_t min;
+  vector_t max;
+  detail::read_value(is, min.m_x);
+  detail::read_value(is, min.m_y);
+  detail::read_value(is, max.m_x);
+  detail::read_value(is, max.m_y);
+
+  uint64_t count = 0;
+  detail::read_value(is, count);
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+  if (min != m_group.min_coords() || max != m_group.max_coords()) {
+    return CG_INVALID_VALUE;
+  }
+
+  std::size_t cells = std::size_t(max.m_x - min.m_x)
+    * std::size_t(max.m_y - min.m_y);
+  if (count > cells) {
+    return CG_INVALID_VALUE;
+  }
+
+  std::vector<vector_t> coords;
+  for (uint64_t i = 0 ; i < count && is ; ++i) {
+    vector_t node;
+    detail::read_value(is, node.m_x);
+    detail::read_value(is, node.m_y);
+    coords.push_back(node);
+  }
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+
+  // The nodes must still be there, and each must be listed once.
+  std::vector<uint32_t> ids(cells, detail::ch_invalid_node);
+  for (std::size_t i = 0 ; i < coords.size() ; ++i) {
+    vector_t const & node = coords[i];
+    if (node.m_x < min.m_x || node.m_x >= max.m_x
+        || node.m_y < min.m_y || node.m_y >= max.m_y
+        || m_group.is_empty(node))
+    {
+      return CG_INVALID_VALUE;
+    }
+
+    uint32_t & id = ids[std::size_t(node.m_y - min.m_y)
+      * std::size_t(max.m_x - min.m_x) + std::size_t(node.m_x - min.m_x)];
+    if (id != detail::ch_invalid_node) {
+      return CG_INVALID_VALUE;
+    }
+    id = uint32_t(i);
+  }
+
+  std::vector<uint32_t> up_offsets(1, 0);
+  std::vector<uint32_t> down_offsets(1, 0);
+  std::vector<detail::ch_edge_t> up;
+  std::vector<detail::ch_edge_t> down;
+  if (!coords.empty()) {
+    if (!detail::ch_read_edges(is, coords.size(), up_offsets, up)
+        || !detail::ch_read_edges(is, coords.size(), down_offsets, down))
+    {
+      return is ? CG_INVALID_VALUE : CG_IO_ERROR;
+    }
+  }
+
+  // Shortcuts must be unpackable; see unpack().
+  for (uint32_t node = 0 ; node < coords.size() ; ++node) {
+    for (uint32_t i = up_offsets[node] ; i < up_offsets[node + 1] ; ++i) {
+      if (!detail::ch_check_shortcut(up_offsets, up, down_offsets, down,
+            node, up[i].m_node, up[i]))
+      {
+        return CG_INVALID_VALUE;
+      }
+    }
+    for (uint32_t i = down_offsets[node] ; i < down_offsets[node + 1] ; ++i) {
+      if (!detail::ch_check_shortcut(up_offsets, up, down_offsets, down,
+            down[i].m_node, node, down[i]))
+      {
+        return CG_INVALID_VALUE;
+      }
+    }
+  }
+
+  m_min = min;
+  m_max = max;
+  m_ids.swap(ids);
+  m_coords.swap(coords);
+  m_up_offsets.swap(up_offsets);
+  m_down_offsets.swap(down_offsets);
+  m_up.swap(up);
+  m_down.swap(down);
+
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::find_path(
+    std::deque<vector_t> & result, vector_t const & start,
+    vector_t const & end)
+{
+  uint32_t source = id_of(start);
+  uint32_t target = id_of(end);
+  if (source == detail::ch_invalid_node || target == detail::ch_invalid_node) {
+    return CG_INVALID_COORDS;
+  }
+
+  uint32_t meeting = detail::ch_invalid_node;
+  if (detail::infinite_cost == query(source, target, meeting)) {
+    return CG_NO_PATH;
+  }
+
+  if (!unpack(source, meeting, result)) {
+    result.clear();
+    return CG_INVALID_VALUE;
+  }
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::path_cost(
+    vector_t const & start, vector_t const & end)
+{
+  uint32_t source = id_of(start);
+  uint32_t target = id_of(end);
+  if (source == detail::ch_invalid_node || target == detail::ch_invalid_node) {
+    return invalid_unit;
+  }
+
+  uint32_t meeting = detail::ch_invalid_node;
+  unit_t cost = query(source, target, meeting);
+  return detail::infinite_cost == cost ? invalid_unit : cost;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::node_count() const
+{
+  return m_coords.size();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::edge_count() const
+{
+  return m_up.size() + m_down.size();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::query(uint32_t source,
+    uint32_t target, uint32_t & meeting)
+{
+  // Dijkstra's algorithm upwards from both ends, alternating between the
+  // searches by whichever has the cheaper node to process next. Once neither
+  // search has nodes cheaper than the best path found, that's the cheapest.
+  detail::ch_search_t & forward = *m_forward;
+  detail::ch_search_t & backward = *m_backward;
+  forward.reset(m_coords.size());
+  backward.reset(m_coords.size());
+  forward.push(source, 0, detail::ch_edge_t());
+  backward.push(target, 0, detail::ch_edge_t());
+
+  unit_t best = detail::infinite_cost;
+  while (std::min(forward.top(), backward.top()) < best) {
+    bool is_forward = forward.top() <= backward.top();
+    detail::ch_search_t & search = is_forward ? forward : backward;
+    detail::ch_search_t const & other = is_forward ? backward : forward;
+
+    uint32_t node = detail::ch_invalid_node;
+    if (!search.pop(node)) {
+      continue;
+    }
+
+    unit_t cost = search.m_cost[node];
+    if (detail::infinite_cost != other.m_cost[node]
+        && cost + other.m_cost[node] < best)
+    {
+      best = cost + other.m_cost[node];
+      meeting = node;
+    }
+
+    std::vector<uint32_t> const & offsets = is_forward ? m_up_offsets
+      : m_down_offsets;
+    std::vector<detail::ch_edge_t> const & edges = is_forward ? m_up : m_down;
+    for (uint32_t i = offsets[node] ; i < offsets[node + 1] ; ++i) {
+      detail::ch_edge_t const & edge = edges[i];
+      search.push(edge.m_node, cost + edge.m_cost,
+          detail::ch_edge_t(node, edge.m_cost, edge.m_middle));
+    }
+  }
+
+  return best;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+bool
+contraction_hierarchy<node_groupT, traversal_traitsT>::unpack(uint32_t source,
+    uint32_t meeting, std::deque<vector_t> & result) const
+{
+  // Collect the edges from the start node to the meeting node and on to the
+  // end node, as (from, edge to) pairs.
+  typedef std::pair<uint32_t, detail::ch_edge_t> arc_t;
+  std::vector<arc_t> arcs;
+
+  for (uint32_t node = meeting ; node != source ; ) {
+    detail::ch_edge_t const & parent = m_forward->m_parent[node];
+    arcs.push_back(arc_t(parent.m_node,
+          detail::ch_edge_t(node, parent.m_cost, parent.m_middle)));
+    node = parent.m_node;
+  }
+  std::reverse(arcs.begin(), arcs.end());
+
+  for (uint32_t node = meeting ; ; ) {
+    detail::ch_edge_t const & parent = m_backward->m_parent[node];
+    if (parent.m_node == detail::ch_invalid_node) {
+      break;
+    }
+    arcs.push_back(arc_t(node, parent));
+    node = parent.m_node;
+  }
+
+  // Replace shortcuts by the two edges they skip until only edges between
+  // neighbours remain. The edge to the middle node is a downward edge of the
+  // middle node, the edge from it an upward edge.
+  result.clear();
+  result.push_back(m_coords[source]);
+
+  // Each arc on the stack adds at least one node to the path, which visits
+  // each node at most once; if it would get longer, the shortcuts loop.
+  std::vector<arc_t> stack(arcs.rbegin(), arcs.rend());
+  while (!stack.empty()) {
+    if (result.size() + stack.size() > m_coords.size()) {
+      return false;
+    }
+
+    arc_t arc = stack.back();
+    stack.pop_back();
+
+    uint32_t middle = arc.second.m_middle;
+    if (middle == detail::ch_invalid_node) {
+      result.push_back(m_coords[arc.second.m_node]);
+      continue;
+    }
+
+    detail::ch_edge_t const * second = detail::ch_find_edge(m_up_offsets,
+        m_up, middle, arc.second.m_node);
+    detail::ch_edge_t const * first = detail::ch_find_edge(m_down_offsets,
+        m_down, middle, arc.first);
+    if (!first || !second) {
+      return false;
+    }
+
+    stack.push_back(arc_t(middle, *second));
+    stack.push_back(arc_t(arc.first,
+          detail::ch_edge_t(middle, first->m_cost, first->m_middle)));
+  }
+  return true;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline uint32_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::id_of(
+    vector_t const & coords) const
+{
+  std::size_t index = index_of(coords);
+  if (index == std::size_t(-1)) {
+    return detail::ch_invalid_node;
+  }
+  return m_ids[index];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline std::size_t
+contraction_hierarchy<node_groupT, traversal_traitsT>::index_of(
+    vector_t const & coords) const
+{
+  if (m_ids.empty()
+      || coords.m_x < m_min.m_x || coords.m_x >= m_max.m_x
+      || coords.m_y < m_min.m_y || coords.m_y >= m_max.m_y)
+  {
+    return std::size_t(-1);
+  }
+
+  return std::size_t(coords.m_y - m_min.m_y)
+    * std::size_t(m_max.m_x - m_min.m_x)
+    + std::size_t(coords.m_x - m_min.m_x);
+}
+
+}} // namespace cartograph::pathfinding
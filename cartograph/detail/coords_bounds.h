@@ -0,0 +1,316 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_DETAIL_COORDS_BOUNDS_H
+#define CG_DETAIL_COORDS_BOUNDS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <cartograph/types.h>
+#include <cartograph/detail/coords_hash.h>
+
+namespace cartograph {
+namespace detail {
+
+/**
+ * Tracks the bounding box of a set of coordinates as coordinates are added
+ * and removed, as node_group::min_coords() and max_coords() report it.
+ *
+ * The number of coordinates in each occupied column and row is counted, so
+ * that the box can shrink when the last coordinates of a boundary column or
+ * row are removed. Querying the box, and adding and removing coordinates
+ * take constant time, except that shrinking the box takes time proportional
+ * to the distance to the next occupied column or row, but never more than
+ * the number of occupied columns or rows.
+ **/
+class coords_bounds
+{
+public:
+  void
+  add(vector_t const & coords)
+  {
+    m_columns.add(coords.m_x);
+    m_rows.add(coords.m_y);
+  }
+
+
+  void
+  remove(vector_t const & coords)
+  {
+    m_columns.remove(coords.m_x);
+    m_rows.remove(coords.m_y);
+  }
+
+
+  void
+  clear()
+  {
+    m_columns.clear();
+    m_rows.clear();
+  }
+
+
+  vector_t
+  min_coords() const
+  {
+    if (m_columns.empty()) {
+      return invalid_vector;
+    }
+    return vector_t(m_columns.min(), m_rows.min());
+  }
+
+
+  vector_t
+  max_coords() const
+  {
+    if (m_columns.empty()) {
+      return vector_t(invalid_unit + 1, invalid_unit + 1);
+    }
+
+    // for STL-/pointer-like iteration
+    return vector_t(m_columns.max() + 1, m_rows.max() + 1);
+  }
+
+private:
+  /**
+   * Counts per value of one axis, in a hash table using linear probing, and
+   * the lowest and highest value with a count.
+   **/
+  class axis_counts
+  {
+  public:
+    axis_counts()
+      : m_size(0)
+      , m_min(0)
+      , m_max(0)
+    {
+    }
+
+
+    void
+    add(unit_t value)
+    {
+      std::size_t slot = find(value);
+      if (slot != NO_SLOT) {
+        ++m_slots[slot].m_count;
+        return;
+      }
+
+      // Keep the table at most half full, so probe sequences stay short.
+      if ((m_size + 1) * 2 > m_slots.size()) {
+        std::vector<count_slot> slots(std::max<std::size_t>(MIN_TABLE_SIZE,
+              m_slots.size() * 2));
+        for (std::size_t i = 0 ; i < m_slots.size() ; ++i) {
+          if (m_slots[i].m_count) {
+            slots[free_slot(slots, m_slots[i].m_value)] = m_slots[i];
+          }
+        }
+        m_slots.swap(slots);
+      }
+
+      slot = free_slot(m_slots, value);
+      m_slots[slot].m_value = value;
+      m_slots[slot].m_count = 1;
+
+      if (!m_size) {
+        m_min = m_max = value;
+      }
+      else {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+      }
+      ++m_size;
+    }
+
+
+    void
+    remove(unit_t value)
+    {
+      std::size_t slot = find(value);
+      if (slot == NO_SLOT || --m_slots[slot].m_count) {
+        return;
+      }
+
+      erase(slot);
+      if (m_size && value == m_min) {
+        m_min = next(value, 1);
+      }
+      if (m_size && value == m_max) {
+        m_max = next(value, -1);
+      }
+    }
+
+
+    void
+    clear()
+    {
+      m_slots.clear();
+      m_size = 0;
+    }
+
+
+    bool
+    empty() const
+    {
+      return !m_size;
+    }
+
+
+    unit_t
+    min() const
+    {
+      return m_min;
+    }
+
+
+    unit_t
+    max() const
+    {
+      return m_max;
+    }
+
+  private:
+    enum
+    {
+      MIN_TABLE_SIZE = 16,
+    };
+
+    static std::size_t const NO_SLOT = ~std::size_t(0);
+
+    // Slots without a count are unused.
+    struct count_slot
+    {
+      count_slot()
+        : m_value(0)
+        , m_count(0)
+      {
+      }
+
+      unit_t      m_value;
+      std::size_t m_count;
+    };
+
+
+    static std::size_t
+    hash(unit_t value)
+    {
+      return mix_coords_key(uint64_t(value));
+    }
+
+
+    std::size_t
+    find(unit_t value) const
+    {
+      if (m_slots.empty()) {
+        return NO_SLOT;
+      }
+
+      std::size_t mask = m_slots.size() - 1;
+      for (std::size_t i = hash(value) & mask ; m_slots[i].m_count
+          ; i = (i + 1) & mask)
+      {
+        if (m_slots[i].m_value == value) {
+          return i;
+        }
+      }
+      return NO_SLOT;
+    }
+
+
+    static std::size_t
+    free_slot(std::vector<count_slot> const & slots, unit_t value)
+    {
+      std::size_t mask = slots.size() - 1;
+      std::size_t i = hash(value) & mask;
+      while (slots[i].m_count) {
+        i = (i + 1) & mask;
+      }
+      return i;
+    }
+
+
+    void
+    erase(std::size_t slot)
+    {
+      // Shift following entries of the probe sequence back into the freed
+      // slot where that doesn't move them before their home slot, so that
+      // lookups can stop at the first unused slot.
+      std::size_t mask = m_slots.size() - 1;
+      for (std::size_t i = (slot + 1) & mask ; m_slots[i].m_count
+          ; i = (i + 1) & mask)
+      {
+        std::size_t home = hash(m_slots[i].m_value) & mask;
+        if (((i - home) & mask) < ((i - slot) & mask)) {
+          continue;
+        }
+        m_slots[slot] = m_slots[i];
+        slot = i;
+      }
+
+      m_slots[slot].m_count = 0;
+      --m_size;
+    }
+
+
+    // Returns the next value with a count after the given one, in the given
+    // direction; there must be one.
+    unit_t
+    next(unit_t value, unit_t step) const
+    {
+      // Step over the gap while that's cheaper than scanning the table.
+      for (std::size_t i = 0 ; i < m_size ; ++i) {
+        value += step;
+        if (find(value) != NO_SLOT) {
+          return value;
+        }
+      }
+
+      bool found = false;
+      for (std::size_t i = 0 ; i < m_slots.size() ; ++i) {
+        if (!m_slots[i].m_count) {
+          continue;
+        }
+        unit_t candidate = m_slots[i].m_value;
+        if (!found || (step > 0 ? candidate < value : candidate > value)) {
+          value = candidate;
+          found = true;
+        }
+      }
+      return value;
+    }
+
+
+    std::vector<count_slot> m_slots;
+    std::size_t             m_size;
+    unit_t                  m_min;
+    unit_t                  m_max;
+  };
+
+
+  axis_counts m_columns;
+  axis_counts m_rows;
+};
+
+}} // namespace cartograph::detail
+
+#endif // guard
@@ -0,0 +1,84 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_DETAIL_COORDS_HASH_H
+#define CG_DETAIL_COORDS_HASH_H
+
+#include <cstddef>
+
+#include <cartograph/types.h>
+
+namespace cartograph {
+namespace detail {
+
+/**
+ * Coordinates are hashed by packing both components into a 64 bit key, x in
+ * the upper and y in the lower half, and scrambling that key so that
+ * neighbouring coordinates spread across a hash table.
+ *
+ * Components outside the range of a 32 bit integer are truncated, so distinct
+ * coordinates only map to distinct keys if coords_key_fits() is true for them.
+ **/
+inline uint64_t
+coords_key(vector_t const & coords)
+{
+  return (uint64_t(coords.m_x) << 32) ^ (uint64_t(coords.m_y) & 0xffffffffULL);
+}
+
+
+/**
+ * Returns true if coords_key() is lossless for the coordinates. The smallest
+ * 32 bit value is excluded as well, so that the key of (INT32_MIN, INT32_MIN)
+ * can mark unused slots in hash tables.
+ **/
+inline bool
+coords_key_fits(vector_t const & coords)
+{
+  int64_t const min = -int64_t(0x7fffffffLL) - 1;
+  int64_t const max = int64_t(0x7fffffffLL);
+  return int64_t(coords.m_x) > min && int64_t(coords.m_x) <= max
+    && int64_t(coords.m_y) > min && int64_t(coords.m_y) <= max;
+}
+
+
+/**
+ * A key no coordinates passing coords_key_fits() produce.
+ **/
+static uint64_t const coords_key_unused = 0x8000000080000000ULL;
+
+
+/**
+ * Scrambles a key with the finalizer of MurmurHash3.
+ **/
+inline std::size_t
+mix_coords_key(uint64_t key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return std::size_t(key);
+}
+
+}} // namespace cartograph::detail
+
+#endif // guard
@@ -0,0 +1,566 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+
+namespace cartograph {
+namespace pathfinding {
+
+/*****************************************************************************
+ * class d_star_lite
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::d_star_lite(
+    node_groupT const & group, traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic)
+  : m_group(group)
+  , m_traversal_traits(traversal_traits)
+  , m_join_types(traversal_traits.join_types())
+  , m_heuristic(heuristic)
+  , m_start(invalid_vector)
+  , m_goal(invalid_vector)
+  , m_last_start(invalid_vector)
+  , m_key_modifier(0)
+  , m_min(invalid_vector)
+  , m_max(invalid_vector)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::compute(
+    vector_t const & start, vector_t const & goal)
+{
+  if (m_group.is_empty(start) || m_group.is_empty(goal)) {
+    return CG_INVALID_COORDS;
+  }
+
+  m_start = start;
+  m_last_start = start;
+  m_goal = goal;
+  m_heuristic.prepare(m_group, m_goal, m_start, m_traversal_traits);
+  m_dirty.clear();
+  reset();
+
+  // Only the goal is known to be inconsistent at first.
+  update_rhs(index_of(m_goal));
+  compute_shortest_path();
+
+  return (invalid_unit == cost()) ? CG_NO_PATH : CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::move_start(
+    vector_t const & start)
+{
+  if (index_of(start) == std::size_t(-1)) {
+    return CG_INVALID_COORDS;
+  }
+
+  m_start = start;
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::invalidate(
+    vector_t const & coords)
+{
+  m_dirty.push_back(coords);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::invalidate(
+    vector_t const & min, vector_t const & max)
+{
+  for (unit_t y = min.m_y ; y < max.m_y ; ++y) {
+    for (unit_t x = min.m_x ; x < max.m_x ; ++x) {
+      m_dirty.push_back(vector_t(x, y));
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::update()
+{
+  if (m_goal == invalid_vector) {
+    return CG_INVALID_COORDS;
+  }
+
+  // If the bounds have changed, the tables no longer fit.
+  if (m_group.min_coords() != m_min || m_group.max_coords() != m_max) {
+    return compute(m_start, m_goal);
+  }
+
+  // Rather than recomputing the keys of all queued nodes when the start node
+  // moves, raise the keys of all nodes queued from now on by (at most) the
+  // amount the keys of already queued nodes are too high.
+  if (m_start != m_last_start) {
+    m_heuristic.prepare(m_group, m_goal, m_start, m_traversal_traits);
+    m_key_modifier += m_heuristic(m_last_start);
+    m_last_start = m_start;
+  }
+
+  // A change to a node may affect any move into or out of it, so the RHS of
+  // the node and it's neighbours needs to be determined again.
+  for (std::size_t i = 0 ; i < m_dirty.size() ; ++i) {
+    std::size_t index = index_of(m_dirty[i]);
+    if (index == std::size_t(-1)) {
+      continue;
+    }
+    update_rhs(index);
+
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        m_dirty[i], m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      std::size_t n_index = index_of(tile_traits_t::get_relative(m_dirty[i],
+            *d));
+      if (n_index != std::size_t(-1)) {
+        update_rhs(n_index);
+      }
+    }
+  }
+  m_dirty.clear();
+
+  compute_shortest_path();
+
+  return (invalid_unit == cost()) ? CG_NO_PATH : CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+vector_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::start() const
+{
+  return m_start;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+vector_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::goal() const
+{
+  return m_goal;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+unit_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::cost() const
+{
+  std::size_t index = index_of(m_start);
+  if (index == std::size_t(-1) || detail::infinite_cost == m_rhs[index]) {
+    return invalid_unit;
+  }
+  return m_rhs[index];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+vector_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::next() const
+{
+  if (invalid_unit == cost() || m_start == m_goal) {
+    return invalid_vector;
+  }
+  unit_t cost = 0;
+  return coords_of(best_successor(index_of(m_start), cost));
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::path(
+    std::deque<vector_t> & result) const
+{
+  if (invalid_unit == cost()) {
+    return CG_NO_PATH;
+  }
+
+  // Each step leads to a node with lower G, so no path can be longer than
+  // there are nodes.
+  std::size_t index = index_of(m_start);
+  unit_t cost = 0;
+  result.push_back(m_start);
+  for (std::size_t i = 0 ; i < m_g.size() && result.back() != m_goal ; ++i) {
+    index = best_successor(index, cost);
+    if (index == std::size_t(-1)) {
+      break;
+    }
+    result.push_back(coords_of(index));
+  }
+
+  return (result.back() == m_goal) ? CG_OK : CG_NO_PATH;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::reset()
+{
+  m_min = m_group.min_coords();
+  m_max = m_group.max_coords();
+  m_join_types = m_traversal_traits.join_types();
+  m_key_modifier = 0;
+
+  std::size_t cells = 0;
+  if (m_min != invalid_vector && m_max != invalid_vector) {
+    cells = std::size_t(m_max.m_x - m_min.m_x)
+      * std::size_t(m_max.m_y - m_min.m_y);
+  }
+  m_g.assign(cells, detail::infinite_cost);
+  m_rhs.assign(cells, detail::infinite_cost);
+  m_keys.assign(cells, key_t());
+  m_queued.assign(cells, false);
+  m_queue = queue_t();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+typename d_star_lite<node_groupT, traversal_traitsT, heuristicT>::key_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::calculate_key(
+    std::size_t index) const
+{
+  unit_t cost = std::min(m_g[index], m_rhs[index]);
+  if (detail::infinite_cost == cost) {
+    return key_t(cost, cost);
+  }
+
+  unit_t h_cost = m_heuristic(coords_of(index));
+  return key_t(cost + h_cost + m_key_modifier, cost);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::update_node(
+    std::size_t index)
+{
+  if (m_g[index] == m_rhs[index]) {
+    m_queued[index] = false;
+    return;
+  }
+
+  key_t key = calculate_key(index);
+  if (m_queued[index] && m_keys[index] == key) {
+    return;
+  }
+
+  m_keys[index] = key;
+  m_queued[index] = true;
+  m_queue.push(queue_entry_t(key, index));
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::update_rhs(
+    std::size_t index)
+{
+  vector_t coords = coords_of(index);
+  if (coords == m_goal) {
+    m_rhs[index] = m_group.is_empty(coords) ? detail::infinite_cost : 0;
+  }
+  else {
+    best_successor(index, m_rhs[index]);
+  }
+  update_node(index);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::compute_shortest_path()
+{
+  std::size_t start_index = index_of(m_start);
+
+  queue_entry_t entry;
+  while (top(entry)) {
+    // Once the start node is consistent and no queued node could lead to a
+    // cheaper path, we're done.
+    if (!(entry.first < calculate_key(start_index))
+        && m_rhs[start_index] <= m_g[start_index])
+    {
+      break;
+    }
+
+    std::size_t index = entry.second;
+    m_queue.pop();
+    m_queued[index] = false;
+
+    // The start node has moved since the node was queued.
+    key_t key = calculate_key(index);
+    if (entry.first < key) {
+      update_node(index);
+      continue;
+    }
+
+    vector_t coords = coords_of(index);
+    unit_t old_g = m_g[index];
+    bool cheaper = (m_g[index] > m_rhs[index]);
+    if (cheaper) {
+      m_g[index] = m_rhs[index];
+    }
+    else {
+      m_g[index] = detail::infinite_cost;
+      update_rhs(index);
+    }
+
+    // Pass the new G on to the nodes that can move into this one.
+    if (m_group.is_empty(coords)) {
+      continue;
+    }
+    directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+        m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      vector_t n_coords = tile_traits_t::get_relative(coords, *d);
+      std::size_t n_index = index_of(n_coords);
+      if (n_index == std::size_t(-1) || n_coords == m_goal
+          || m_group.is_empty(n_coords))
+      {
+        continue;
+      }
+
+      unit_t cost = 0;
+      if (!detail::reverse_traversal_cost<tile_traits_t>(m_traversal_traits,
+            m_join_types, coords, n_coords, cost))
+      {
+        continue;
+      }
+
+      if (cheaper) {
+        // Cheaper; the neighbour can only get cheaper, too.
+        if (cost + m_g[index] < m_rhs[n_index]) {
+          m_rhs[n_index] = cost + m_g[index];
+          update_node(n_index);
+        }
+      }
+      else if (m_rhs[n_index] == cost + old_g) {
+        // More expensive; if the neighbour's RHS came from this node, it
+        // needs to be determined again.
+        update_rhs(n_index);
+      }
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+bool
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::top(
+    queue_entry_t & entry)
+{
+  // Drop entries whose node was dequeued or queued again with another key.
+  while (!m_queue.empty()) {
+    entry = m_queue.top();
+    if (m_queued[entry.second] && m_keys[entry.second] == entry.first) {
+      return true;
+    }
+    m_queue.pop();
+  }
+  return false;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+std::size_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::best_successor(
+    std::size_t index, unit_t & best_cost) const
+{
+  std::size_t best = std::size_t(-1);
+  best_cost = detail::infinite_cost;
+
+  vector_t coords = coords_of(index);
+  if (m_group.is_empty(coords)) {
+    return best;
+  }
+
+  directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+      m_join_types);
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    vector_t n_coords = tile_traits_t::get_relative(coords, *d);
+    std::size_t n_index = index_of(n_coords);
+    if (n_index == std::size_t(-1)
+        || detail::infinite_cost == m_g[n_index]
+        || m_group.is_empty(n_coords)
+        || m_traversal_traits.is_impassable(coords, *d))
+    {
+      continue;
+    }
+
+    unit_t cost = m_traversal_traits.traversal_cost(coords, *d)
+      + m_g[n_index];
+    if (cost < best_cost) {
+      best = n_index;
+      best_cost = cost;
+    }
+  }
+
+  return best;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+inline std::size_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::index_of(
+    vector_t const & coords) const
+{
+  if (m_g.empty()
+      || coords.m_x < m_min.m_x || coords.m_x >= m_max.m_x
+      || coords.m_y < m_min.m_y || coords.m_y >= m_max.m_y)
+  {
+    return std::size_t(-1);
+  }
+
+  return std::size_t(coords.m_y - m_min.m_y)
+    * std::size_t(m_max.m_x - m_min.m_x)
+    + std::size_t(coords.m_x - m_min.m_x);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+inline vector_t
+d_star_lite<node_groupT, traversal_traitsT, heuristicT>::coords_of(
+    std::size_t index) const
+{
+  std::size_t width = std::size_t(m_max.m_x - m_min.m_x);
+  return vector_t(m_min.m_x + unit_t(index % width),
+      m_min.m_y + unit_t(index / width));
+}
+
+}} // namespace cartograph::pathfinding
@@ -0,0 +1,447 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+namespace cartograph {
+namespace pathfinding {
+
+/*****************************************************************************
+ * class flow_field
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+flow_field<node_groupT, traversal_traitsT>::flow_field(
+    node_groupT const & group, traversal_traitsT & traversal_traits)
+  : m_group(group)
+  , m_traversal_traits(traversal_traits)
+  , m_join_types(traversal_traits.join_types())
+  , m_goal(invalid_vector)
+  , m_min(invalid_vector)
+  , m_max(invalid_vector)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+#endif
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+flow_field<node_groupT, traversal_traitsT>::compute(vector_t const & goal)
+{
+  if (m_group.is_empty(goal)) {
+    return CG_INVALID_COORDS;
+  }
+
+  m_goal = goal;
+  m_dirty.clear();
+  reset();
+
+  std::size_t index = index_of(m_goal);
+  m_costs[index] = 0;
+  push(m_goal, 0);
+  propagate();
+
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::invalidate(vector_t const & coords)
+{
+  m_dirty.push_back(coords);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::invalidate(vector_t const & min,
+    vector_t const & max)
+{
+  for (unit_t y = min.m_y ; y < max.m_y ; ++y) {
+    for (unit_t x = min.m_x ; x < max.m_x ; ++x) {
+      m_dirty.push_back(vector_t(x, y));
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::update()
+{
+  if (m_dirty.empty() || m_goal == invalid_vector) {
+    m_dirty.clear();
+    return;
+  }
+
+  // Without the goal, there are no paths at all.
+  if (m_group.is_empty(m_goal)) {
+    m_dirty.clear();
+    reset();
+    return;
+  }
+
+  // If the bounds have changed, the tables no longer fit.
+  if (m_group.min_coords() != m_min || m_group.max_coords() != m_max) {
+    compute(m_goal);
+    return;
+  }
+
+  // Nodes whose path to the goal leads through a changed node need to be
+  // recomputed; all others keep their costs, unless a change opened up a
+  // cheaper path - those are found by propagating from the changed nodes.
+  std::vector<bool> affected(m_costs.size(), false);
+  for (std::size_t i = 0 ; i < m_dirty.size() ; ++i) {
+    std::size_t index = index_of(m_dirty[i]);
+    if (index != std::size_t(-1)) {
+      affected[index] = true;
+    }
+  }
+  m_dirty.clear();
+  mark_affected(affected);
+
+  for (std::size_t i = 0 ; i < affected.size() ; ++i) {
+    if (affected[i]) {
+      m_costs[i] = invalid_unit;
+      m_directions[i] = DIR_END;
+    }
+  }
+
+  m_workspace.reset();
+  m_workspace.m_dense_lookup.reset(m_min, m_max);
+
+  // Start from the cheapest path to a neighbour that's not affected.
+  for (std::size_t i = 0 ; i < affected.size() ; ++i) {
+    if (!affected[i]) {
+      continue;
+    }
+
+    vector_t coords = coords_of(i);
+    if (coords == m_goal) {
+      m_costs[i] = 0;
+      push(coords, 0);
+    }
+    else if (!m_group.is_empty(coords)) {
+      seed(i, coords);
+    }
+  }
+
+  propagate();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+vector_t
+flow_field<node_groupT, traversal_traitsT>::goal() const
+{
+  return m_goal;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+flow_field<node_groupT, traversal_traitsT>::cost(vector_t const & coords) const
+{
+  std::size_t index = index_of(coords);
+  if (index == std::size_t(-1)) {
+    return invalid_unit;
+  }
+  return m_costs[index];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+directions_t
+flow_field<node_groupT, traversal_traitsT>::direction(
+    vector_t const & coords) const
+{
+  std::size_t index = index_of(coords);
+  if (index == std::size_t(-1)) {
+    return DIR_END;
+  }
+  return m_directions[index];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+vector_t
+flow_field<node_groupT, traversal_traitsT>::next(vector_t const & coords) const
+{
+  directions_t dir = direction(coords);
+  if (DIR_END == dir) {
+    return invalid_vector;
+  }
+  return tile_traits_t::get_relative(coords, dir);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::reset()
+{
+  m_min = m_group.min_coords();
+  m_max = m_group.max_coords();
+  m_join_types = m_traversal_traits.join_types();
+
+  std::size_t cells = 0;
+  if (m_min != invalid_vector && m_max != invalid_vector) {
+    cells = std::size_t(m_max.m_x - m_min.m_x)
+      * std::size_t(m_max.m_y - m_min.m_y);
+  }
+  m_costs.assign(cells, invalid_unit);
+  m_directions.assign(cells, DIR_END);
+
+  m_workspace.reset();
+  m_workspace.m_dense_lookup.reset(m_min, m_max);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::mark_affected(
+    std::vector<bool> & affected) const
+{
+  // Follow the directions from each node until we reach a node we already
+  // know about, the goal, or a node without a path to the goal. Every node on
+  // the way shares the outcome.
+  enum { UNKNOWN = 0, UNAFFECTED, AFFECTED };
+  std::vector<char> state(affected.size(), UNKNOWN);
+  for (std::size_t i = 0 ; i < affected.size() ; ++i) {
+    if (affected[i]) {
+      state[i] = AFFECTED;
+    }
+  }
+
+  std::vector<std::size_t> trail;
+  for (std::size_t i = 0 ; i < state.size() ; ++i) {
+    std::size_t index = i;
+    while (UNKNOWN == state[index] && DIR_END != m_directions[index]) {
+      trail.push_back(index);
+      index = index_of(tile_traits_t::get_relative(coords_of(index),
+            m_directions[index]));
+    }
+
+    char outcome = (UNKNOWN == state[index]) ? char(UNAFFECTED) : state[index];
+    state[index] = outcome;
+    for (std::size_t j = 0 ; j < trail.size() ; ++j) {
+      state[trail[j]] = outcome;
+    }
+    trail.clear();
+  }
+
+  for (std::size_t i = 0 ; i < state.size() ; ++i) {
+    affected[i] = (AFFECTED == state[i]);
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::seed(std::size_t index,
+    vector_t const & coords)
+{
+  directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+      m_join_types);
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    vector_t n_coords = tile_traits_t::get_relative(coords, *d);
+    if (m_group.is_empty(n_coords)) {
+      continue;
+    }
+
+    unit_t n_cost = m_costs[index_of(n_coords)];
+    if (invalid_unit == n_cost
+        || m_traversal_traits.is_impassable(coords, *d))
+    {
+      continue;
+    }
+
+    unit_t cost = n_cost + m_traversal_traits.traversal_cost(coords, *d);
+    if (invalid_unit == m_costs[index] || cost < m_costs[index]) {
+      m_costs[index] = cost;
+      m_directions[index] = *d;
+    }
+  }
+
+  if (invalid_unit != m_costs[index]) {
+    push(coords, m_costs[index]);
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::push(vector_t const & coords,
+    unit_t const & cost)
+{
+  detail::node_index_t index = m_workspace.m_dense_lookup.find(coords);
+  if (index == detail::invalid_node_index) {
+    index = m_workspace.m_arena.allocate(coords, cost, cost,
+        detail::invalid_node_index);
+    m_workspace.m_dense_lookup.insert(coords, index);
+    m_workspace.m_open_list.push(index);
+    return;
+  }
+
+  detail::search_node_t & node = m_workspace.m_arena[index];
+  if (!node.m_closed && cost < node.m_g_cost) {
+    node.m_g_cost = cost;
+    m_workspace.m_open_list.decrease_key(index, cost);
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+flow_field<node_groupT, traversal_traitsT>::propagate()
+{
+  // Dijkstra's algorithm, following moves backwards. m_costs holds the best
+  // costs known so far for every node, the open list the nodes whose costs
+  // have changed.
+  while (!m_workspace.m_open_list.empty()) {
+    detail::node_index_t current_index = m_workspace.m_open_list.pop();
+    detail::search_node_t & current = m_workspace.m_arena[current_index];
+    current.m_closed = true;
+
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        current.m_coords, m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      vector_t n_coords = tile_traits_t::get_relative(current.m_coords, *d);
+      if (n_coords == m_goal || m_group.is_empty(n_coords)) {
+        continue;
+      }
+
+      unit_t cost = 0;
+      directions_t dir = DIR_END;
+      if (!detail::reverse_traversal_cost<tile_traits_t>(m_traversal_traits,
+            m_join_types, current.m_coords, n_coords, cost, &dir))
+      {
+        continue;
+      }
+
+      std::size_t n_index = index_of(n_coords);
+      unit_t n_cost = current.m_g_cost + cost;
+      if (invalid_unit != m_costs[n_index] && m_costs[n_index] <= n_cost) {
+        continue;
+      }
+
+      m_costs[n_index] = n_cost;
+      m_directions[n_index] = dir;
+      push(n_coords, n_cost);
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline std::size_t
+flow_field<node_groupT, traversal_traitsT>::index_of(
+    vector_t const & coords) const
+{
+  if (m_costs.empty()
+      || coords.m_x < m_min.m_x || coords.m_x >= m_max.m_x
+      || coords.m_y < m_min.m_y || coords.m_y >= m_max.m_y)
+  {
+    return std::size_t(-1);
+  }
+
+  return std::size_t(coords.m_y - m_min.m_y)
+    * std::size_t(m_max.m_x - m_min.m_x)
+    + std::size_t(coords.m_x - m_min.m_x);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline vector_t
+flow_field<node_groupT, traversal_traitsT>::coords_of(
+    std::size_t index) const
+{
+  std::size_t width = std::size_t(m_max.m_x - m_min.m_x);
+  return vector_t(m_min.m_x + unit_t(index % width),
+      m_min.m_y + unit_t(index / width));
+}
+
+}} // namespace cartograph::pathfinding
@@ -26,10 +26,60 @@ namespace cartograph {
 namespace pathfinding {
 namespace heuristics {
 
+/*****************************************************************************
+ * Prepared heuristics
+ */
+
+template <
+  typename derivedT,
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t
+prepared_heuristic<derivedT, node_groupT, traversal_traitsT>::operator()(
+    node_groupT const & group, vector_t const & start,
+    vector_t const & current, vector_t const & end,
+    traversal_traitsT & traversal_traits) const
+{
+  derivedT h(static_cast<derivedT const &>(*this));
+  h.prepare(group, start, end, traversal_traits);
+  return h(current);
+}
+
+
+
 /*****************************************************************************
  * "Dijkstra heuristics"
  */
 
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline void
+dijkstra_heuristic<node_groupT, traversal_traitsT>::prepare(
+    node_groupT const & /* group */, vector_t const & /* start */,
+    vector_t const & /* end */, traversal_traitsT & /* traversal_traits */)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t
+dijkstra_heuristic<node_groupT, traversal_traitsT>::operator()(
+    vector_t const & /* current */) const
+{
+  // Dijkstra's algorithm is essentially A* without a heuristic - so if we
+  // always return zero for the heuristic function, we get Dijkstra's algorithm.
+  return unit_t();
+}
+
+
+
 template <
   typename node_groupT,
   typename traversal_traitsT
@@ -39,8 +89,6 @@ dijkstra(node_groupT const & group, vector_t const & start,
     vector_t const & current, vector_t const & end,
     traversal_traitsT & traversal_traits)
 {
-  // Dijkstra's algorithm is essentially A* without a heuristic - so if we
-  // always return zero for the heuristic function, we get Dijkstra's algorithm.
   return unit_t();
 }
 
@@ -75,17 +123,46 @@ template <
   typename node_groupT,
   typename traversal_traitsT
 >
-unit_t
-manhattan(node_groupT const & group, vector_t const & start,
-    vector_t const & current, vector_t const & end,
-    traversal_traitsT & traversal_traits)
+inline void
+manhattan_heuristic<node_groupT, traversal_traitsT>::prepare(
+    node_groupT const & /* group */, vector_t const & /* start */,
+    vector_t const & end, traversal_traitsT & traversal_traits)
 {
   BOOST_STATIC_ASSERT(sizeof(detail::manhattan_is_specialized<
         typename node_groupT::tile_traits_t
       >) != 0);
 
-  return traversal_traits.average_traversal_cost()
-    * std::abs(end.m_x - current.m_x) + std::abs(end.m_y - current.m_y);
+  m_end = end;
+  m_average_cost = traversal_traits.average_traversal_cost();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t
+manhattan_heuristic<node_groupT, traversal_traitsT>::operator()(
+    vector_t const & current) const
+{
+  return m_average_cost
+    * std::abs(m_end.m_x - current.m_x) + std::abs(m_end.m_y - current.m_y);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+manhattan(node_groupT const & group, vector_t const & start,
+    vector_t const & current, vector_t const & end,
+    traversal_traitsT & traversal_traits)
+{
+  return manhattan_heuristic<node_groupT, traversal_traitsT>()(group, start,
+      current, end, traversal_traits);
 }
 
 
@@ -96,7 +173,7 @@ manhattan(node_groupT const & group, vector_t const & start,
 namespace detail {
 // Diagonal heuristics need to be specialized for each shape tile, as that
 // strongly influences the possible directions in which one can move, and
-// their relative weight.
+// their relative weight. The costs are looked up once per search in prepare().
 template <
   typename tile_traitsT,
   typename node_groupT,
@@ -118,23 +195,28 @@ struct diagonal<
   traversal_traitsT
 >
 {
+  inline void
+  prepare(traversal_traitsT & traversal_traits)
+  {
+    m_s_cost = traversal_traits.traversal_cost(vector_t(0, 0), NORTH);
+    m_d_cost = traversal_traits.traversal_cost(vector_t(0, 0), NORTH_EAST);
+  }
+
   inline unit_t
-  operator()(node_groupT const & group, vector_t const & start,
-    vector_t const & current, vector_t const & end,
-    traversal_traitsT & traversal_traits)
+  operator()(vector_t const & current, vector_t const & end) const
   {
     unit_t x_diff = std::abs(current.m_x - end.m_x);
     unit_t y_diff = std::abs(current.m_y - end.m_y);
     unit_t h_diagonal = std::min(x_diff, y_diff);
     unit_t h_straight = x_diff + y_diff;
 
-    unit_t s_cost = traversal_traits.traversal_cost(vector_t(0, 0), NORTH);
-    unit_t d_cost = traversal_traits.traversal_cost(vector_t(0, 0), NORTH_EAST);
-
     // Assume that we walk as much as possible diagonally at d_cost, then the
     // remainder at s_cost.
-    return (d_cost * h_diagonal) + (s_cost * (h_straight - 2 * h_diagonal));
+    return (m_d_cost * h_diagonal) + (m_s_cost * (h_straight - 2 * h_diagonal));
   }
+
+  unit_t  m_s_cost;
+  unit_t  m_d_cost;
 };
 
 
@@ -148,10 +230,14 @@ struct diagonal<
   traversal_traitsT
 >
 {
+  inline void
+  prepare(traversal_traitsT & traversal_traits)
+  {
+    m_average_cost = traversal_traits.average_traversal_cost();
+  }
+
   inline unit_t
-  operator()(node_groupT const & group, vector_t const & start,
-    vector_t const & current, vector_t const & end,
-    traversal_traitsT & traversal_traits)
+  operator()(vector_t const & current, vector_t const & end) const
   {
     // For once, hexagonal tiles actually make things a bit tricky, because
     // they do not allow horizontal movement (in our model alignment). On the
@@ -185,8 +271,10 @@ struct diagonal<
     }
 
     // Now the cost for each tile-to-tile movement is actually the same...
-    return traversal_traits.average_traversal_cost() * (h_diagonal + h_straight);
+    return m_average_cost * (h_diagonal + h_straight);
   }
+
+  unit_t  m_average_cost;
 };
 
 
@@ -201,10 +289,14 @@ struct diagonal<
   traversal_traitsT
 >
 {
+  inline void
+  prepare(traversal_traitsT & traversal_traits)
+  {
+    m_average_cost = traversal_traits.average_traversal_cost();
+  }
+
   inline unit_t
-  operator()(node_groupT const & group, vector_t const & start,
-    vector_t const & current, vector_t const & end,
-    traversal_traitsT & traversal_traits)
+  operator()(vector_t const & current, vector_t const & end) const
   {
     // For triangular tiles, we make the simplifying assumption that the
     // shortest path follows exclusively along edge neighbours. This is likely
@@ -215,9 +307,11 @@ struct diagonal<
     // Given that assumption, if we walk diagonally as far as we can, the
     // resultant path costs would actually be the same as the manhattan
     // distance would be, if we allowed corner movement as well.
-    return traversal_traits.average_traversal_cost()
+    return m_average_cost
         * std::abs(end.m_x - current.m_x) + std::abs(end.m_y - current.m_y);
   }
+
+  unit_t  m_average_cost;
 };
 
 
@@ -225,6 +319,35 @@ struct diagonal<
 } // namespace detail
 
 
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline void
+diagonal_heuristic<node_groupT, traversal_traitsT>::prepare(
+    node_groupT const & /* group */, vector_t const & /* start */,
+    vector_t const & end, traversal_traitsT & traversal_traits)
+{
+  m_end = end;
+  m_estimate.prepare(traversal_traits);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t
+diagonal_heuristic<node_groupT, traversal_traitsT>::operator()(
+    vector_t const & current) const
+{
+  return m_estimate(current, m_end);
+}
+
+
+
 template <
   typename node_groupT,
   typename traversal_traitsT
@@ -234,12 +357,8 @@ diagonal(node_groupT const & group, vector_t const & start,
     vector_t const & current, vector_t const & end,
     traversal_traitsT & traversal_traits)
 {
-  detail::diagonal<
-    typename node_groupT::tile_traits_t,
-    node_groupT,
-    traversal_traitsT
-  > d;
-  return d(group, start, current, end, traversal_traits);
+  return diagonal_heuristic<node_groupT, traversal_traitsT>()(group, start,
+      current, end, traversal_traits);
 }
 
 
@@ -262,49 +381,70 @@ line_of_sight_crossproduct(vector_t const & start, vector_t const & current,
   return std::abs((dx1 * dy2) - (dx2 * dy1));
 }
 
+} // namespace detail
+
+
 
 template <
   typename node_groupT,
   typename traversal_traitsT,
   typename heuristicT
 >
-inline
-unit_t
-generic_tiebreaker(node_groupT const & group, vector_t const & start,
-    vector_t const & current, vector_t const & end,
-    traversal_traitsT & traversal_traits, heuristicT const & _heuristic)
+tiebreaker_heuristic<node_groupT, traversal_traitsT,
+  heuristicT>::tiebreaker_heuristic(
+    heuristicT const & heuristic /* = heuristicT() */)
+  : m_heuristic(heuristic)
 {
-  typedef boost::function<
-    unit_t (node_groupT const &, vector_t const &, vector_t const &,
-        vector_t const &, traversal_traitsT &)
-  > heuristic_t;
+}
 
-  heuristic_t heuristic = _heuristic;
 
-  unit_t h = heuristic(group, start, current, end, traversal_traits);
 
-  unit_t cross = line_of_sight_crossproduct(start, current, end);
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+inline void
+tiebreaker_heuristic<node_groupT, traversal_traitsT, heuristicT>::prepare(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits)
+{
+  m_heuristic.prepare(group, start, end, traversal_traits);
+  m_start = start;
+  m_end = end;
 
   // The cross product should weigh in at around 1/1000 if a step costs 1 at
   // minimum, and the number of steps is estimated to not exceed 1000. We'll be
-  // a bit more generic here (and more computing intensive) by instead picking
-  // the average traversal cost as the step cost, and the same heuristic method
-  // using at each step applied to the total path as the maximum.
-  unit_t total = heuristic(group, start, start, end, traversal_traits);
+  // a bit more generic here by instead picking the average traversal cost as
+  // the step cost, and the same heuristic method using at each step applied to
+  // the total path as the maximum.
+  m_total = m_heuristic(start);
+  m_average_cost = traversal_traits.average_traversal_cost();
+}
+
 
-  unit_t avg = traversal_traits.average_traversal_cost();
 
-  h = (h * (total + avg)) / avg;
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+inline unit_t
+tiebreaker_heuristic<node_groupT, traversal_traitsT, heuristicT>::operator()(
+    vector_t const & current) const
+{
+  unit_t h = m_heuristic(current);
+
+  unit_t cross = detail::line_of_sight_crossproduct(m_start, current, m_end);
+
+  h = (h * (m_total + m_average_cost)) / m_average_cost;
   h += cross;
-  h = (h * avg) / (total + avg);
+  h = (h * m_average_cost) / (m_total + m_average_cost);
 
   return h;
 }
 
 
-} // namespace detail
-
-
 
 
 template <
@@ -316,8 +456,8 @@ manhattan_tiebreaker(node_groupT const & group, vector_t const & start,
     vector_t const & current, vector_t const & end,
     traversal_traitsT & traversal_traits)
 {
-  return detail::generic_tiebreaker(group, start, current, end, traversal_traits,
-      &manhattan<node_groupT, traversal_traitsT>);
+  return manhattan_tiebreaker_heuristic<node_groupT, traversal_traitsT>()(
+      group, start, current, end, traversal_traits);
 }
 
 
@@ -331,8 +471,8 @@ diagonal_tiebreaker(node_groupT const & group, vector_t const & start,
     vector_t const & current, vector_t const & end,
     traversal_traitsT & traversal_traits)
 {
-  return detail::generic_tiebreaker(group, start, current, end, traversal_traits,
-      &diagonal<node_groupT, traversal_traitsT>);
+  return diagonal_tiebreaker_heuristic<node_groupT, traversal_traitsT>()(
+      group, start, current, end, traversal_traits);
 }
 
 
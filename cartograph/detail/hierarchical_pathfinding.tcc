@@ -0,0 +1,948 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace cartograph {
+namespace pathfinding {
+
+
+namespace detail {
+
+/**
+ * Wraps the user's traversal traits, but considers any move out of the given
+ * bounds to be impassable. That restricts searches to a single cluster.
+ **/
+template <
+  typename traversal_traitsT,
+  typename tile_traitsT
+>
+struct cluster_traversal_traits
+{
+  cluster_traversal_traits(traversal_traitsT & traversal_traits,
+      vector_t const & min, vector_t const & max)
+    : m_traversal_traits(traversal_traits)
+    , m_min(min)
+    , m_max(max)
+  {
+  }
+
+
+  join_t join_types()
+  {
+    return m_traversal_traits.join_types();
+  }
+
+
+  bool is_impassable(vector_t const & coords, directions_t const & d)
+  {
+    vector_t target = tile_traitsT::get_relative(coords, d);
+    if (target.m_x < m_min.m_x || target.m_x >= m_max.m_x
+        || target.m_y < m_min.m_y || target.m_y >= m_max.m_y)
+    {
+      return true;
+    }
+    return m_traversal_traits.is_impassable(coords, d);
+  }
+
+
+  unit_t traversal_cost(vector_t const & coords, directions_t const & d)
+  {
+    return m_traversal_traits.traversal_cost(coords, d);
+  }
+
+
+  unit_t average_traversal_cost()
+  {
+    return m_traversal_traits.average_traversal_cost();
+  }
+
+
+  traversal_traitsT & m_traversal_traits;
+  vector_t            m_min;
+  vector_t            m_max;
+};
+
+
+
+/**
+ * Passes the user's traversal traits rather than the cluster_traversal_traits
+ * above to the user's heuristic.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename cluster_traitsT,
+  typename heuristicT
+>
+struct cluster_heuristic
+  : public heuristics::prepared_heuristic_tag
+{
+  explicit cluster_heuristic(heuristicT const & heuristic)
+    : m_bound(heuristic)
+  {
+  }
+
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, cluster_traitsT & traversal_traits)
+  {
+    m_bound.prepare(group, start, end, traversal_traits.m_traversal_traits);
+  }
+
+
+  unit_t operator()(vector_t const & current) const
+  {
+    return m_bound(current);
+  }
+
+
+  // Plain heuristics aren't necessarily callable when const.
+  mutable bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  > m_bound;
+};
+
+
+
+/**
+ * Rounds towards negative infinity, unlike the / operator.
+ **/
+inline unit_t
+floor_divide(unit_t const & value, unit_t const & divisor)
+{
+  unit_t result = value / divisor;
+  if ((value % divisor) != 0 && ((value < 0) != (divisor < 0))) {
+    --result;
+  }
+  return result;
+}
+
+} // namespace detail
+
+
+
+/*****************************************************************************
+ * class hierarchical_map - helper structs
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::edge_t::edge_t(
+    vector_t const & to, unit_t const & cost)
+  : m_to(to)
+  , m_cost(cost)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+hierarchical_map<node_groupT, traversal_traitsT,
+  heuristicT>::abstract_node_t::abstract_node_t()
+  : m_refcount(0)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+hierarchical_map<node_groupT, traversal_traitsT,
+  heuristicT>::cluster_t::cluster_t()
+  : m_dirty(false)
+{
+}
+
+
+
+/*****************************************************************************
+ * class hierarchical_map
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::hierarchical_map(
+    node_groupT const & group, traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, unit_t const & cluster_size /* = 16 */)
+  : m_group(group)
+  , m_traversal_traits(traversal_traits)
+  , m_heuristic(heuristic)
+  , m_cluster_size(cluster_size)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  // Smaller clusters would mean that a node's neighbours might lie in
+  // clusters that don't border the node's cluster.
+  if (m_cluster_size < 2) {
+    throw exception(CG_INVALID_VALUE);
+  }
+
+  rebuild();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::invalidate(
+    vector_t const & coords)
+{
+  // Only the cluster containing the node needs to be rebuilt; entrances on
+  // it's borders are rebuilt along with it, and that takes care of the
+  // neighbouring clusters.
+  m_clusters[cluster_of(coords)].m_dirty = true;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::update()
+{
+  std::set<vector_t> dirty;
+  for (typename cluster_map_t::iterator iter = m_clusters.begin()
+      ; iter != m_clusters.end() ; ++iter)
+  {
+    if (iter->second.m_dirty) {
+      dirty.insert(iter->first);
+      iter->second.m_dirty = false;
+    }
+  }
+
+  if (dirty.empty()) {
+    return;
+  }
+
+  // Find all borders of the dirty clusters.
+  std::set<border_t> borders;
+  for (std::set<vector_t>::const_iterator iter = dirty.begin()
+      ; iter != dirty.end() ; ++iter)
+  {
+    for (unit_t x = -1 ; x <= 1 ; ++x) {
+      for (unit_t y = -1 ; y <= 1 ; ++y) {
+        if (!x && !y) {
+          continue;
+        }
+        vector_t other = *iter + vector_t(x, y);
+        if (other < *iter) {
+          borders.insert(border_t(other, *iter));
+        }
+        else {
+          borders.insert(border_t(*iter, other));
+        }
+      }
+    }
+  }
+
+  // Rebuild the entrances on those borders. Any cluster that gains or loses
+  // entrances in the process needs it's intra-cluster edges rebuilt, as well
+  // as the dirty clusters themselves.
+  std::set<vector_t> changed = dirty;
+  for (typename std::set<border_t>::const_iterator iter = borders.begin()
+      ; iter != borders.end() ; ++iter)
+  {
+    remove_border(*iter, changed);
+  }
+  for (typename std::set<border_t>::const_iterator iter = borders.begin()
+      ; iter != borders.end() ; ++iter)
+  {
+    build_border(*iter, changed);
+  }
+
+  for (std::set<vector_t>::const_iterator iter = changed.begin()
+      ; iter != changed.end() ; ++iter)
+  {
+    // Drop entrances no longer part of any transition.
+    cluster_t & cluster = m_clusters[*iter];
+    for (std::set<vector_t>::iterator n_iter = cluster.m_nodes.begin()
+        ; n_iter != cluster.m_nodes.end() ; )
+    {
+      typename node_map_t::iterator node = m_nodes.find(*n_iter);
+      assert(node != m_nodes.end());
+      if (node->second.m_refcount) {
+        ++n_iter;
+        continue;
+      }
+      m_nodes.erase(node);
+      cluster.m_nodes.erase(n_iter++);
+    }
+
+    build_intra_edges(*iter);
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::rebuild()
+{
+  m_clusters.clear();
+  m_nodes.clear();
+  m_borders.clear();
+
+  if (!m_group.size()) {
+    return;
+  }
+
+  // Note that max_coords() is one past the maximum.
+  vector_t min = cluster_of(m_group.min_coords());
+  vector_t max = cluster_of(m_group.max_coords() - vector_t(1, 1));
+  for (unit_t x = min.m_x ; x <= max.m_x ; ++x) {
+    for (unit_t y = min.m_y ; y <= max.m_y ; ++y) {
+      m_clusters[vector_t(x, y)].m_dirty = true;
+    }
+  }
+
+  update();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+hierarchical_map<node_groupT, traversal_traitsT,
+  heuristicT>::find_abstract_path(
+    std::deque<vector_t> & waypoints, vector_t const & start,
+    vector_t const & end)
+{
+  // Prevent bogus input.
+  if (!m_group.is_valid(start) || !m_group.is_valid(end)) {
+    return CG_INVALID_COORDS;
+  }
+
+  if (start == end) {
+    waypoints.push_back(start);
+    return CG_OK;
+  }
+
+  update();
+
+  // Temporarily connect start and end to the entrances of their clusters,
+  // and to each other if they share a cluster.
+  extra_edges_t extra;
+  connect(start, true, extra);
+  connect(end, false, extra);
+  if (cluster_of(start) == cluster_of(end)) {
+    std::deque<vector_t> path;
+    unit_t cost = 0;
+    if (CG_OK == search_in_cluster(path, cluster_of(start), start, end)
+        && path_cost(path, cost))
+    {
+      extra[start].push_back(edge_t(end, cost));
+    }
+  }
+
+  // A* on the abstract graph. The node lookup's bounds don't matter for the
+  // map_node_lookup.
+  detail::search_workspace & ws = m_context.workspace();
+  ws.reset();
+  ws.m_map_lookup.reset(start, end);
+
+  detail::node_arena & arena = ws.m_arena;
+  detail::open_list_t & open_list = ws.m_open_list;
+  detail::map_node_lookup & nodes = ws.m_map_lookup;
+
+  detail::bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  > heuristic(m_heuristic);
+  heuristic.prepare(m_group, start, end, m_traversal_traits);
+
+  detail::node_index_t index = arena.allocate(start, 0, heuristic(start),
+      detail::invalid_node_index);
+  nodes.insert(start, index);
+  open_list.push(index);
+
+  while (!open_list.empty()) {
+    detail::node_index_t current_index = open_list.pop();
+    detail::search_node_t & current = arena[current_index];
+    current.m_closed = true;
+
+    if (current.m_coords == end) {
+      while (current_index != detail::invalid_node_index) {
+        waypoints.push_front(arena[current_index].m_coords);
+        current_index = arena[current_index].m_parent;
+      }
+      return CG_OK;
+    }
+
+    // Gather the edge lists to follow from here.
+    edge_list_t const * lists[3] = { 0, 0, 0 };
+    typename node_map_t::const_iterator node = m_nodes.find(current.m_coords);
+    if (node != m_nodes.end()) {
+      lists[0] = &node->second.m_inter;
+      lists[1] = &node->second.m_intra;
+    }
+    typename extra_edges_t::const_iterator e_iter
+      = extra.find(current.m_coords);
+    if (e_iter != extra.end()) {
+      lists[2] = &e_iter->second;
+    }
+
+    for (std::size_t i = 0 ; i < 3 ; ++i) {
+      if (!lists[i]) {
+        continue;
+      }
+
+      for (typename edge_list_t::const_iterator edge = lists[i]->begin()
+          ; edge != lists[i]->end() ; ++edge)
+      {
+        detail::node_index_t n_index = nodes.find(edge->m_to);
+        if (n_index != detail::invalid_node_index && arena[n_index].m_closed) {
+          continue;
+        }
+
+        unit_t g_cost = current.m_g_cost + edge->m_cost;
+
+        if (n_index != detail::invalid_node_index) {
+          detail::search_node_t & n_node = arena[n_index];
+          if (n_node.m_g_cost > g_cost) {
+            unit_t f_cost = g_cost + (n_node.m_f_cost - n_node.m_g_cost);
+            n_node.m_g_cost = g_cost;
+            n_node.m_parent = current_index;
+            open_list.decrease_key(n_index, f_cost);
+          }
+          continue;
+        }
+
+        unit_t h_cost = heuristic(edge->m_to);
+        n_index = arena.allocate(edge->m_to, g_cost, g_cost + h_cost,
+            current_index);
+        nodes.insert(edge->m_to, n_index);
+        open_list.push(n_index);
+      }
+    }
+  }
+
+  return CG_NO_PATH;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::refine_segment(
+    std::deque<vector_t> & result, vector_t const & from,
+    vector_t const & to)
+{
+  std::deque<vector_t> path;
+
+  if (from == to) {
+    path.push_back(from);
+  }
+  else if (cluster_of(from) == cluster_of(to)) {
+    error_t err = search_in_cluster(path, cluster_of(from), from, to);
+    unit_t cost = 0;
+    if (CG_OK != err) {
+      return err;
+    }
+    if (!path_cost(path, cost)) {
+      return CG_NO_PATH;
+    }
+  }
+  else if (is_neighbour(from, to)) {
+    unit_t cost = 0;
+    if (!step_cost(from, to, cost)) {
+      return CG_NO_PATH;
+    }
+    path.push_back(from);
+    path.push_back(to);
+  }
+  else {
+    return CG_INVALID_COORDS;
+  }
+
+  if (!result.empty() && result.back() == from) {
+    path.pop_front();
+  }
+  result.insert(result.end(), path.begin(), path.end());
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::find_path(
+    std::deque<vector_t> & result, vector_t const & start,
+    vector_t const & end)
+{
+  std::deque<vector_t> waypoints;
+  error_t err = find_abstract_path(waypoints, start, end);
+  if (CG_OK != err) {
+    return err;
+  }
+
+  result.push_back(waypoints.front());
+  for (std::size_t i = 1 ; i < waypoints.size() ; ++i) {
+    err = refine_segment(result, waypoints[i - 1], waypoints[i]);
+    if (CG_OK != err) {
+      return err;
+    }
+  }
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+vector_t
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::cluster_of(
+    vector_t const & coords) const
+{
+  return vector_t(detail::floor_divide(coords.m_x, m_cluster_size),
+      detail::floor_divide(coords.m_y, m_cluster_size));
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+std::size_t
+hierarchical_map<node_groupT, traversal_traitsT,
+  heuristicT>::abstract_node_count() const
+{
+  return m_nodes.size();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::remove_border(
+    border_t const & border, std::set<vector_t> & changed)
+{
+  typename border_map_t::iterator b_iter = m_borders.find(border);
+  if (b_iter == m_borders.end()) {
+    return;
+  }
+
+  for (typename transition_list_t::const_iterator iter = b_iter->second.begin()
+      ; iter != b_iter->second.end() ; ++iter)
+  {
+    vector_t const * ends[2] = { &iter->m_first, &iter->m_second };
+    for (std::size_t i = 0 ; i < 2 ; ++i) {
+      abstract_node_t & node = m_nodes[*ends[i]];
+      vector_t const & other = *ends[1 - i];
+
+      for (typename edge_list_t::iterator e_iter = node.m_inter.begin()
+          ; e_iter != node.m_inter.end() ; ++e_iter)
+      {
+        if (e_iter->m_to == other) {
+          node.m_inter.erase(e_iter);
+          break;
+        }
+      }
+
+      assert(node.m_refcount > 0);
+      if (!--node.m_refcount) {
+        changed.insert(cluster_of(*ends[i]));
+      }
+    }
+  }
+
+  m_borders.erase(b_iter);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::build_border(
+    border_t const & border, std::set<vector_t> & changed)
+{
+  // Find all pairs of neighbouring nodes across the border, between which
+  // movement is possible in at least one direction.
+  std::vector<transition_t> crossings;
+
+  vector_t min(border.first.m_x * m_cluster_size,
+      border.first.m_y * m_cluster_size);
+  join_t join_types = m_traversal_traits.join_types();
+  for (unit_t x = min.m_x ; x < min.m_x + m_cluster_size ; ++x) {
+    for (unit_t y = min.m_y ; y < min.m_y + m_cluster_size ; ++y) {
+      vector_t coords(x, y);
+      if (!m_group.is_valid(coords) || m_group.is_empty(coords)) {
+        continue;
+      }
+
+      directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+          join_types);
+      for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+        vector_t n_coords = tile_traits_t::get_relative(coords, *d);
+        if (cluster_of(n_coords) != border.second
+            || m_group.is_empty(n_coords))
+        {
+          continue;
+        }
+
+        unit_t cost = 0;
+        if (step_cost(coords, n_coords, cost)
+            || step_cost(n_coords, coords, cost))
+        {
+          transition_t crossing = { coords, n_coords };
+          crossings.push_back(crossing);
+        }
+      }
+    }
+  }
+
+  if (crossings.empty()) {
+    return;
+  }
+
+  // Group the crossings into runs of adjacent crossings, and pick one
+  // transition for each run - or two, at either end, for long runs, as paths
+  // along the border would otherwise make detours.
+  static const std::size_t LONG_RUN = 6;
+
+  transition_list_t & transitions = m_borders[border];
+  std::vector<bool> visited(crossings.size(), false);
+  for (std::size_t i = 0 ; i < crossings.size() ; ++i) {
+    if (visited[i]) {
+      continue;
+    }
+
+    std::vector<std::size_t> run(1, i);
+    visited[i] = true;
+    for (std::size_t r = 0 ; r < run.size() ; ++r) {
+      transition_t const & current = crossings[run[r]];
+      for (std::size_t j = 0 ; j < crossings.size() ; ++j) {
+        if (visited[j]) {
+          continue;
+        }
+        transition_t const & other = crossings[j];
+        if (current.m_first == other.m_first
+            || current.m_second == other.m_second
+            || is_neighbour(current.m_first, other.m_first)
+            || is_neighbour(current.m_second, other.m_second))
+        {
+          visited[j] = true;
+          run.push_back(j);
+        }
+      }
+    }
+
+    // Crossings were found in coordinate order, so sorting the indices sorts
+    // the run along the border.
+    std::sort(run.begin(), run.end());
+    if (run.size() >= LONG_RUN) {
+      transitions.push_back(crossings[run.front()]);
+      transitions.push_back(crossings[run.back()]);
+    }
+    else {
+      transitions.push_back(crossings[run[run.size() / 2]]);
+    }
+  }
+
+  // Create entrances and the edges between them.
+  for (typename transition_list_t::const_iterator iter = transitions.begin()
+      ; iter != transitions.end() ; ++iter)
+  {
+    add_entrance(iter->m_first, changed);
+    add_entrance(iter->m_second, changed);
+
+    unit_t cost = 0;
+    if (step_cost(iter->m_first, iter->m_second, cost)) {
+      m_nodes[iter->m_first].m_inter.push_back(edge_t(iter->m_second, cost));
+    }
+    if (step_cost(iter->m_second, iter->m_first, cost)) {
+      m_nodes[iter->m_second].m_inter.push_back(edge_t(iter->m_first, cost));
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::add_entrance(
+    vector_t const & coords, std::set<vector_t> & changed)
+{
+  abstract_node_t & node = m_nodes[coords];
+  if (!node.m_refcount++) {
+    vector_t cluster = cluster_of(coords);
+    if (m_clusters[cluster].m_nodes.insert(coords).second) {
+      changed.insert(cluster);
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::build_intra_edges(
+    vector_t const & cluster)
+{
+  std::set<vector_t> const & entrances = m_clusters[cluster].m_nodes;
+  for (std::set<vector_t>::const_iterator from = entrances.begin()
+      ; from != entrances.end() ; ++from)
+  {
+    abstract_node_t & node = m_nodes[*from];
+    node.m_intra.clear();
+
+    for (std::set<vector_t>::const_iterator to = entrances.begin()
+        ; to != entrances.end() ; ++to)
+    {
+      if (from == to) {
+        continue;
+      }
+
+      std::deque<vector_t> path;
+      unit_t cost = 0;
+      if (CG_OK == search_in_cluster(path, cluster, *from, *to)
+          && path_cost(path, cost))
+      {
+        node.m_intra.push_back(edge_t(*to, cost));
+      }
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::connect(
+    vector_t const & coords, bool outgoing, extra_edges_t & extra)
+{
+  vector_t cluster = cluster_of(coords);
+  typename cluster_map_t::const_iterator c_iter = m_clusters.find(cluster);
+  if (c_iter == m_clusters.end()) {
+    return;
+  }
+
+  std::set<vector_t> const & entrances = c_iter->second.m_nodes;
+  for (std::set<vector_t>::const_iterator iter = entrances.begin()
+      ; iter != entrances.end() ; ++iter)
+  {
+    if (*iter == coords) {
+      continue;
+    }
+
+    vector_t const & from = outgoing ? coords : *iter;
+    vector_t const & to = outgoing ? *iter : coords;
+
+    std::deque<vector_t> path;
+    unit_t cost = 0;
+    if (CG_OK == search_in_cluster(path, cluster, from, to)
+        && path_cost(path, cost))
+    {
+      extra[from].push_back(edge_t(to, cost));
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::search_in_cluster(
+    std::deque<vector_t> & result, vector_t const & cluster,
+    vector_t const & from, vector_t const & to)
+{
+  typedef detail::cluster_traversal_traits<
+    traversal_traitsT,
+    tile_traits_t
+  > cluster_traits_t;
+
+  typedef detail::cluster_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    cluster_traits_t,
+    heuristicT
+  > cluster_heuristic_t;
+
+  vector_t min(cluster.m_x * m_cluster_size, cluster.m_y * m_cluster_size);
+  vector_t max = min + vector_t(m_cluster_size, m_cluster_size);
+  cluster_traits_t traits(m_traversal_traits, min, max);
+
+  detail::search_workspace & ws = m_context.workspace();
+  ws.reset();
+  ws.m_dense_lookup.reset(min, max);
+
+  detail::pathfinder<
+    cluster_traits_t,
+    node_groupT,
+    detail::open_list_t,
+    detail::dense_node_lookup,
+    cluster_heuristic_t
+  > pathfinder(m_group, from, to, traits, cluster_heuristic_t(m_heuristic),
+      search_limits(), ws.m_arena, ws.m_open_list, ws.m_dense_lookup);
+  return pathfinder.find_path(result);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+bool
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::path_cost(
+    std::deque<vector_t> const & path, unit_t & cost)
+{
+  // a_star() does not check whether the move into the end node is passable, so
+  // we need to check each step here.
+  cost = 0;
+  for (std::size_t i = 1 ; i < path.size() ; ++i) {
+    unit_t step = 0;
+    if (!step_cost(path[i - 1], path[i], step)) {
+      return false;
+    }
+    cost += step;
+  }
+  return true;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+bool
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::step_cost(
+    vector_t const & from, vector_t const & to, unit_t & cost)
+{
+  directions_t const * const dirs = tile_traits_t::available_dirs(from,
+      m_traversal_traits.join_types());
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    if (tile_traits_t::get_relative(from, *d) != to) {
+      continue;
+    }
+    if (m_traversal_traits.is_impassable(from, *d)) {
+      return false;
+    }
+    cost = m_traversal_traits.traversal_cost(from, *d);
+    return true;
+  }
+  return false;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+bool
+hierarchical_map<node_groupT, traversal_traitsT, heuristicT>::is_neighbour(
+    vector_t const & first, vector_t const & second)
+{
+  directions_t const * const dirs = tile_traits_t::available_dirs(first,
+      m_traversal_traits.join_types());
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    if (tile_traits_t::get_relative(first, *d) == second) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+}} // namespace cartograph::pathfinding
@@ -0,0 +1,451 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cassert>
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <cartograph/tile_traits.h>
+
+
+namespace cartograph {
+namespace pathfinding {
+
+
+namespace detail {
+
+/**
+ * The jump_point_pathfinder works much like the pathfinder for A*, but only
+ * places jump points on the open list. Directions are handled as unit vectors
+ * here, which makes it much easier to express the pruning rules.
+ **/
+template <
+  typename traversal_traitsT,
+  typename node_groupT,
+  typename node_lookupT,
+  typename heuristicT
+>
+struct jump_point_pathfinder
+{
+
+  // ctor
+  jump_point_pathfinder(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, node_arena & arena,
+      open_list_t & open_list,
+      node_lookupT & nodes)
+    : m_group(group)
+    , m_start(start)
+    , m_end(end)
+    , m_traversal_traits(traversal_traits)
+    , m_heuristic(heuristic)
+    , m_straight_cost(traversal_traits.traversal_cost(start, NORTH))
+    , m_diagonal_cost(traversal_traits.traversal_cost(start, NORTH_EAST))
+    , m_arena(arena)
+    , m_open_list(open_list)
+    , m_nodes(nodes)
+  {
+    m_heuristic.prepare(m_group, m_start, m_end, m_traversal_traits);
+  }
+
+
+  /**
+   * Main entry point into the algorithm.
+   **/
+  error_t
+  find_path(std::deque<vector_t> & result, bool full_path)
+  {
+    unit_t h_cost = m_heuristic(m_start);
+    node_index_t start_index = m_arena.allocate(m_start, 0, h_cost,
+        invalid_node_index);
+    m_nodes.insert(m_start, start_index);
+    m_open_list.push(start_index);
+
+    while (!m_open_list.empty()) {
+      node_index_t current_index = m_open_list.pop();
+      search_node_t & current = m_arena[current_index];
+      current.m_closed = true;
+
+      // Unlike in A*, a jump to the end node may cost more than some other
+      // jump to it, so we're only done once the end node is processed.
+      if (current.m_coords == m_end) {
+        build_path(result, current_index, full_path);
+        return CG_OK;
+      }
+
+      vector_t dirs[8];
+      std::size_t count = successor_dirs(current_index, dirs);
+      for (std::size_t i = 0 ; i < count ; ++i) {
+        vector_t jump_point;
+        unit_t steps = 0;
+        if (!jump(current.m_coords, dirs[i], jump_point, steps)) {
+          continue;
+        }
+
+        node_index_t n_index = m_nodes.find(jump_point);
+        if (n_index != invalid_node_index && m_arena[n_index].m_closed) {
+          continue;
+        }
+
+        unit_t g_cost = current.m_g_cost + steps
+          * ((dirs[i].m_x && dirs[i].m_y) ? m_diagonal_cost : m_straight_cost);
+
+        if (n_index != invalid_node_index) {
+          search_node_t & node = m_arena[n_index];
+          if (node.m_g_cost > g_cost) {
+            unit_t f_cost = g_cost + (node.m_f_cost - node.m_g_cost);
+            node.m_g_cost = g_cost;
+            node.m_parent = current_index;
+            m_open_list.decrease_key(n_index, f_cost);
+          }
+          continue;
+        }
+
+        unit_t h_cost = m_heuristic(jump_point);
+
+        n_index = m_arena.allocate(jump_point, g_cost, g_cost + h_cost,
+            current_index);
+        m_nodes.insert(jump_point, n_index);
+        m_open_list.push(n_index);
+      }
+    }
+
+    return CG_NO_PATH;
+  }
+
+
+  /**
+   * Fills dirs with the directions worth following from the given node, and
+   * returns their number. For the start node, that's every direction. For any
+   * other node, it's the direction we've arrived from, and any direction that
+   * would have been shorter to follow from the parent if it weren't for an
+   * impassable node next to the current node.
+   **/
+  std::size_t
+  successor_dirs(node_index_t const & index, vector_t * dirs)
+  {
+    search_node_t const & node = m_arena[index];
+    std::size_t count = 0;
+
+    if (node.m_parent == invalid_node_index) {
+      for (unit_t x = -1 ; x <= 1 ; ++x) {
+        for (unit_t y = -1 ; y <= 1 ; ++y) {
+          if (x || y) {
+            dirs[count++] = vector_t(x, y);
+          }
+        }
+      }
+      return count;
+    }
+
+    vector_t const & coords = node.m_coords;
+    vector_t const & parent = m_arena[node.m_parent].m_coords;
+    unit_t dx = sign(coords.m_x - parent.m_x);
+    unit_t dy = sign(coords.m_y - parent.m_y);
+
+    dirs[count++] = vector_t(dx, dy);
+
+    if (dx && dy) {
+      dirs[count++] = vector_t(dx, 0);
+      dirs[count++] = vector_t(0, dy);
+      if (!is_passable(coords, vector_t(-dx, 0))) {
+        dirs[count++] = vector_t(-dx, dy);
+      }
+      if (!is_passable(coords, vector_t(0, -dy))) {
+        dirs[count++] = vector_t(dx, -dy);
+      }
+    }
+    else if (dx) {
+      if (!is_passable(coords, vector_t(0, 1))) {
+        dirs[count++] = vector_t(dx, 1);
+      }
+      if (!is_passable(coords, vector_t(0, -1))) {
+        dirs[count++] = vector_t(dx, -1);
+      }
+    }
+    else {
+      if (!is_passable(coords, vector_t(1, 0))) {
+        dirs[count++] = vector_t(1, dy);
+      }
+      if (!is_passable(coords, vector_t(-1, 0))) {
+        dirs[count++] = vector_t(-1, dy);
+      }
+    }
+
+    return count;
+  }
+
+
+  /**
+   * Follows the given direction from the given node until reaching a jump
+   * point, i.e. the end node or a node with a forced neighbour. Moving
+   * diagonally, a node from which a jump point can be reached horizontally or
+   * vertically is a jump point, too.
+   * Returns false if an impassable node is reached first.
+   **/
+  bool
+  jump(vector_t const & from, vector_t const & dir, vector_t & jump_point,
+      unit_t & steps)
+  {
+    unit_t dx = dir.m_x;
+    unit_t dy = dir.m_y;
+    vector_t current = from;
+    steps = 0;
+
+    while (true) {
+      if (!is_passable(current, dir)) {
+        return false;
+      }
+      current += dir;
+      ++steps;
+
+      if (current == m_end) {
+        break;
+      }
+
+      if (dx && dy) {
+        if ((!is_passable(current, vector_t(-dx, 0))
+              && is_passable(current, vector_t(-dx, dy)))
+            || (!is_passable(current, vector_t(0, -dy))
+              && is_passable(current, vector_t(dx, -dy))))
+        {
+          break;
+        }
+
+        vector_t ignored;
+        unit_t ignored_steps;
+        if (jump(current, vector_t(dx, 0), ignored, ignored_steps)
+            || jump(current, vector_t(0, dy), ignored, ignored_steps))
+        {
+          break;
+        }
+      }
+      else if (dx) {
+        if ((!is_passable(current, vector_t(0, 1))
+              && is_passable(current, vector_t(dx, 1)))
+            || (!is_passable(current, vector_t(0, -1))
+              && is_passable(current, vector_t(dx, -1))))
+        {
+          break;
+        }
+      }
+      else {
+        if ((!is_passable(current, vector_t(1, 0))
+              && is_passable(current, vector_t(1, dy)))
+            || (!is_passable(current, vector_t(-1, 0))
+              && is_passable(current, vector_t(-1, dy))))
+        {
+          break;
+        }
+      }
+    }
+
+    jump_point = current;
+    return true;
+  }
+
+
+  /**
+   * Returns true if one can move from the given node in the given direction.
+   **/
+  bool
+  is_passable(vector_t const & coords, vector_t const & dir)
+  {
+    vector_t target = coords + dir;
+    if (target != m_end && m_group.is_empty(target)) {
+      return false;
+    }
+    return !m_traversal_traits.is_impassable(coords, to_direction(dir));
+  }
+
+
+  /**
+   * Walk backwards from the given node to the start node, and add the nodes
+   * in between to the result - optionally all the nodes between jump points,
+   * too.
+   **/
+  void
+  build_path(std::deque<vector_t> & result, node_index_t index,
+      bool full_path) const
+  {
+    while (index != invalid_node_index) {
+      search_node_t const & node = m_arena[index];
+      result.push_front(node.m_coords);
+
+      if (node.m_parent != invalid_node_index && full_path) {
+        vector_t const & parent = m_arena[node.m_parent].m_coords;
+        vector_t dir(sign(parent.m_x - node.m_coords.m_x),
+            sign(parent.m_y - node.m_coords.m_y));
+        for (vector_t coords = node.m_coords + dir ; coords != parent ;
+            coords += dir)
+        {
+          result.push_front(coords);
+        }
+      }
+
+      index = node.m_parent;
+    }
+  }
+
+
+  static unit_t
+  sign(unit_t const & value)
+  {
+    return (value > 0) - (value < 0);
+  }
+
+
+  static directions_t
+  to_direction(vector_t const & dir)
+  {
+    // Indexed by (dy + 1) * 3 + (dx + 1); see rectangular_tile_traits.
+    static const directions_t directions[] = {
+      NORTH_WEST, NORTH,    NORTH_EAST,
+      WEST,       DIR_END,  EAST,
+      SOUTH_WEST, SOUTH,    SOUTH_EAST,
+    };
+    return directions[(dir.m_y + 1) * 3 + (dir.m_x + 1)];
+  }
+
+
+  node_groupT const & m_group;
+  vector_t            m_start;
+  vector_t            m_end;
+
+  traversal_traitsT & m_traversal_traits;
+  bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  >                   m_heuristic;
+
+  unit_t              m_straight_cost;
+  unit_t              m_diagonal_cost;
+
+  node_arena &        m_arena;
+  open_list_t &       m_open_list;
+  node_lookupT &      m_nodes;
+};
+
+} // namespace detail
+
+
+
+/*****************************************************************************
+ * jump_point_search
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+jump_point_search(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, bool full_path /* = true */)
+{
+  search_context context;
+  return jump_point_search(result, group, start, end, traversal_traits,
+      heuristic, context, full_path);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+jump_point_search(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context,
+    bool full_path /* = true */)
+{
+  BOOST_STATIC_ASSERT((boost::is_same<
+        typename node_groupT::tile_traits_t,
+        rectangular_tile_traits
+      >::value));
+  BOOST_STATIC_ASSERT(has_uniform_costs<traversal_traitsT>::value);
+
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  // The pruning rules rely on being able to move into every direction.
+  join_t join_types = traversal_traits.join_types();
+  if ((join_types & PATHFINDING_DEFAULT) != PATHFINDING_DEFAULT) {
+    return a_star(result, group, start, end, traversal_traits, heuristic,
+        context);
+  }
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || !group.is_valid(end)) {
+    return CG_INVALID_COORDS;
+  }
+
+  detail::search_workspace & ws = context.workspace();
+  ws.reset();
+
+  // Unlike a_star(), we add the end node to the node lookup - jump() treats
+  // it as passable even if the node_group has no node there - so both the
+  // start and end node must fit into the dense lookup.
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)
+      && detail::dense_node_lookup::suitable(min, max, group.size(), end))
+  {
+    ws.m_dense_lookup.reset(min, max);
+
+    detail::jump_point_pathfinder<
+      traversal_traitsT,
+      node_groupT,
+      detail::dense_node_lookup,
+      heuristicT
+    > pathfinder(group, start, end, traversal_traits, heuristic,
+        ws.m_arena, ws.m_open_list, ws.m_dense_lookup);
+    return pathfinder.find_path(result, full_path);
+  }
+
+  ws.m_map_lookup.reset(min, max);
+
+  detail::jump_point_pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::map_node_lookup,
+    heuristicT
+  > pathfinder(group, start, end, traversal_traits, heuristic,
+      ws.m_arena, ws.m_open_list, ws.m_map_lookup);
+  return pathfinder.find_path(result, full_path);
+}
+
+
+}} // namespace cartograph::pathfinding
@@ -0,0 +1,641 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cartograph/detail/binary_io.h>
+
+
+namespace cartograph {
+namespace pathfinding {
+
+namespace detail {
+
+// File format version written by landmark_table::save()
+static const uint32_t LANDMARK_FILE_VERSION = 1;
+
+static char const LANDMARK_FILE_MAGIC[4] = { 'C', 'G', 'L', 'M' };
+
+} // namespace detail
+
+
+/*****************************************************************************
+ * class landmark_table
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+landmark_table<node_groupT, traversal_traitsT>::build_state::build_state()
+  : m_next(0)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+landmark_table<node_groupT, traversal_traitsT>::landmark_table(
+    node_groupT const & group)
+  : m_group(group)
+  , m_min(invalid_vector)
+  , m_max(invalid_vector)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+landmark_table<node_groupT, traversal_traitsT>::compute(
+    traversal_traitsT const & traversal_traits, std::size_t num_landmarks,
+    std::size_t num_threads /* = 0 */)
+{
+  if (!num_landmarks) {
+    return CG_INVALID_VALUE;
+  }
+
+  traversal_traitsT traits(traversal_traits);
+  std::vector<vector_t> landmarks;
+  pick_landmarks(traits, num_landmarks, landmarks);
+  if (landmarks.empty()) {
+    return CG_INVALID_VALUE;
+  }
+
+  return compute(traversal_traits, landmarks, num_threads);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+landmark_table<node_groupT, traversal_traitsT>::compute(
+    traversal_traitsT const & traversal_traits,
+    std::vector<vector_t> const & landmarks,
+    std::size_t num_threads /* = 0 */)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::CloneableTraversalTraitsConcept<traversal_traitsT>
+  >();
+#endif
+
+  if (landmarks.empty()) {
+    return CG_INVALID_VALUE;
+  }
+  for (std::size_t i = 0 ; i < landmarks.size() ; ++i) {
+    if (m_group.is_empty(landmarks[i])) {
+      return CG_INVALID_COORDS;
+    }
+  }
+
+  m_landmarks = landmarks;
+  m_min = m_group.min_coords();
+  m_max = m_group.max_coords();
+
+  std::size_t cells = std::size_t(m_max.m_x - m_min.m_x)
+    * std::size_t(m_max.m_y - m_min.m_y);
+  m_from.assign(cells * m_landmarks.size(), invalid_unit);
+  m_to.assign(cells * m_landmarks.size(), invalid_unit);
+
+  // There's no point in using more threads than there are searches to run.
+  if (!num_threads) {
+    num_threads = boost::thread::hardware_concurrency();
+  }
+  num_threads = std::max(std::size_t(1),
+      std::min(num_threads, 2 * m_landmarks.size()));
+
+  build_state state;
+  boost::thread_group threads;
+  for (std::size_t i = 0 ; i < num_threads ; ++i) {
+    threads.create_thread(boost::bind(&landmark_table::build, this,
+          traversal_traits, boost::ref(state)));
+  }
+  threads.join_all();
+
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+landmark_table<node_groupT, traversal_traitsT>::save(
+    std::string const & filename) const
+{
+  std::ofstream os(filename.c_str(),
+      std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os) {
+    return CG_IO_ERROR;
+  }
+
+  detail::write_header(os, detail::LANDMARK_FILE_MAGIC,
+      detail::LANDMARK_FILE_VERSION);
+
+  detail::write_value(os, m_min.m_x);
+  detail::write_value(os, m_min.m_y);
+  detail::write_value(os, m_max.m_x);
+  detail::write_value(os, m_max.m_y);
+
+  detail::write_value(os, uint64_t(m_landmarks.size()));
+  for (std::size_t i = 0 ; i < m_landmarks.size() ; ++i) {
+    detail::write_value(os, m_landmarks[i].m_x);
+    detail::write_value(os, m_landmarks[i].m_y);
+  }
+
+  if (!m_from.empty()) {
+    os.write(reinterpret_cast<char const *>(&m_from[0]),
+        m_from.size() * sizeof(unit_t));
+    os.write(reinterpret_cast<char const *>(&m_to[0]),
+        m_to.size() * sizeof(unit_t));
+  }
+
+  os.close();
+  return os ? CG_OK : CG_IO_ERROR;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+error_t
+landmark_table<node_groupT, traversal_traitsT>::load(
+    std::string const & filename)
+{
+  std::ifstream is(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+
+  error_t err = detail::read_header(is, detail::LANDMARK_FILE_MAGIC,
+      detail::LANDMARK_FILE_VERSION);
+  if (CG_OK != err) {
+    return err;
+  }
+
+  vector_t min;
+  vector_t max;
+  detail::read_value(is, min.m_x);
+  detail::read_value(is, min.m_y);
+  detail::read_value(is, max.m_x);
+  detail::read_value(is, max.m_y);
+
+  uint64_t count = 0;
+  detail::read_value(is, count);
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+  if (min != m_group.min_coords() || max != m_group.max_coords()) {
+    return CG_INVALID_VALUE;
+  }
+
+  std::vector<vector_t> landmarks;
+  for (uint64_t i = 0 ; i < count && is ; ++i) {
+    vector_t landmark;
+    detail::read_value(is, landmark.m_x);
+    detail::read_value(is, landmark.m_y);
+    landmarks.push_back(landmark);
+  }
+
+  std::size_t cells = std::size_t(max.m_x - min.m_x)
+    * std::size_t(max.m_y - min.m_y);
+  std::vector<unit_t> from(cells * landmarks.size());
+  std::vector<unit_t> to(cells * landmarks.size());
+  if (!from.empty()) {
+    is.read(reinterpret_cast<char *>(&from[0]), from.size() * sizeof(unit_t));
+    is.read(reinterpret_cast<char *>(&to[0]), to.size() * sizeof(unit_t));
+  }
+  if (!is) {
+    return CG_IO_ERROR;
+  }
+
+  m_landmarks.swap(landmarks);
+  m_min = min;
+  m_max = max;
+  m_from.swap(from);
+  m_to.swap(to);
+
+  return CG_OK;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::vector<vector_t> const &
+landmark_table<node_groupT, traversal_traitsT>::landmarks() const
+{
+  return m_landmarks;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+landmark_table<node_groupT, traversal_traitsT>::cost_from(
+    std::size_t landmark, vector_t const & coords) const
+{
+  unit_t const * costs = costs_from(coords);
+  if (!costs || landmark >= m_landmarks.size()) {
+    return invalid_unit;
+  }
+  return costs[landmark];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+unit_t
+landmark_table<node_groupT, traversal_traitsT>::cost_to(
+    std::size_t landmark, vector_t const & coords) const
+{
+  unit_t const * costs = costs_to(coords);
+  if (!costs || landmark >= m_landmarks.size()) {
+    return invalid_unit;
+  }
+  return costs[landmark];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t const *
+landmark_table<node_groupT, traversal_traitsT>::costs_from(
+    vector_t const & coords) const
+{
+  std::size_t index = index_of(coords);
+  if (index == std::size_t(-1)) {
+    return 0;
+  }
+  return &m_from[index * m_landmarks.size()];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t const *
+landmark_table<node_groupT, traversal_traitsT>::costs_to(
+    vector_t const & coords) const
+{
+  std::size_t index = index_of(coords);
+  if (index == std::size_t(-1)) {
+    return 0;
+  }
+  return &m_to[index * m_landmarks.size()];
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+landmark_table<node_groupT, traversal_traitsT>::pick_landmarks(
+    traversal_traitsT & traversal_traits, std::size_t num_landmarks,
+    std::vector<vector_t> & landmarks) const
+{
+  if (!m_group.size()) {
+    return;
+  }
+
+  // Landmarks work best when they lie behind the nodes we search paths
+  // between, i.e. near the edges of the map. Divide the map into sectors
+  // around it's center, and pick the node farthest from the center in each.
+  vector_t min = m_group.min_coords();
+  vector_t max = m_group.max_coords();
+  double center_x = (min.m_x + max.m_x - 1) / 2.0;
+  double center_y = (min.m_y + max.m_y - 1) / 2.0;
+  double const pi = std::acos(-1.0);
+
+  std::vector<vector_t> best(num_landmarks, invalid_vector);
+  std::vector<double> best_distance(num_landmarks, -1);
+
+  join_t join_types = traversal_traits.join_types();
+  for (unit_t y = min.m_y ; y < max.m_y ; ++y) {
+    for (unit_t x = min.m_x ; x < max.m_x ; ++x) {
+      vector_t coords(x, y);
+      if (m_group.is_empty(coords)
+          || !is_enterable(traversal_traits, join_types, coords))
+      {
+        continue;
+      }
+
+      double dx = x - center_x;
+      double dy = y - center_y;
+      std::size_t sector = std::size_t((std::atan2(dy, dx) + pi) / (2 * pi)
+          * num_landmarks);
+      sector = std::min(sector, num_landmarks - 1);
+
+      double distance = (dx * dx) + (dy * dy);
+      if (distance > best_distance[sector]) {
+        best_distance[sector] = distance;
+        best[sector] = coords;
+      }
+    }
+  }
+
+  for (std::size_t i = 0 ; i < best.size() ; ++i) {
+    if (best[i] != invalid_vector) {
+      landmarks.push_back(best[i]);
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+bool
+landmark_table<node_groupT, traversal_traitsT>::is_enterable(
+    traversal_traitsT & traversal_traits, join_t const & join_types,
+    vector_t const & coords) const
+{
+  // A landmark that can't be reached from anywhere only yields half the
+  // bounds, so we skip those.
+  directions_t const * const dirs = tile_traits_t::available_dirs(coords,
+      join_types);
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    vector_t neighbour = tile_traits_t::get_relative(coords, *d);
+    if (m_group.is_empty(neighbour)) {
+      continue;
+    }
+
+    unit_t cost = 0;
+    if (detail::reverse_traversal_cost<tile_traits_t>(traversal_traits,
+          join_types, coords, neighbour, cost))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+landmark_table<node_groupT, traversal_traitsT>::build(
+    traversal_traitsT traversal_traits, build_state & state)
+{
+  detail::search_workspace workspace;
+
+  while (true) {
+    std::size_t search = 0;
+    {
+      boost::mutex::scoped_lock lock(state.m_mutex);
+      search = state.m_next++;
+    }
+    if (search >= 2 * m_landmarks.size()) {
+      return;
+    }
+
+    sweep(traversal_traits, workspace, search / 2, search % 2);
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+landmark_table<node_groupT, traversal_traitsT>::sweep(
+    traversal_traitsT & traversal_traits,
+    detail::search_workspace & workspace, std::size_t landmark, bool reverse)
+{
+  // Dijkstra's algorithm without an end node, i.e. until all nodes reachable
+  // from (or, in reverse, that can reach) the landmark have been processed.
+  workspace.reset();
+  detail::dense_node_lookup & nodes = workspace.m_dense_lookup;
+  nodes.reset(m_min, m_max);
+
+  std::vector<unit_t> & table = reverse ? m_to : m_from;
+  std::size_t const stride = m_landmarks.size();
+  join_t const join_types = traversal_traits.join_types();
+
+  vector_t const & root = m_landmarks[landmark];
+  detail::node_index_t root_index = workspace.m_arena.allocate(root, 0, 0,
+      detail::invalid_node_index);
+  nodes.insert(root, root_index);
+  workspace.m_open_list.push(root_index);
+
+  while (!workspace.m_open_list.empty()) {
+    detail::node_index_t current_index = workspace.m_open_list.pop();
+    detail::search_node_t & current = workspace.m_arena[current_index];
+    current.m_closed = true;
+
+    table[(index_of(current.m_coords) * stride) + landmark] = current.m_g_cost;
+
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        current.m_coords, join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      vector_t n_coords = tile_traits_t::get_relative(current.m_coords, *d);
+      if (m_group.is_empty(n_coords)) {
+        continue;
+      }
+
+      unit_t cost = 0;
+      if (reverse) {
+        if (!detail::reverse_traversal_cost<tile_traits_t>(traversal_traits,
+              join_types, current.m_coords, n_coords, cost))
+        {
+          continue;
+        }
+      }
+      else {
+        if (traversal_traits.is_impassable(current.m_coords, *d)) {
+          continue;
+        }
+        cost = traversal_traits.traversal_cost(current.m_coords, *d);
+      }
+
+      detail::node_index_t n_index = nodes.find(n_coords);
+      if (n_index != detail::invalid_node_index
+          && workspace.m_arena[n_index].m_closed)
+      {
+        continue;
+      }
+
+      unit_t g_cost = current.m_g_cost + cost;
+
+      if (n_index != detail::invalid_node_index) {
+        detail::search_node_t & node = workspace.m_arena[n_index];
+        if (node.m_g_cost > g_cost) {
+          node.m_g_cost = g_cost;
+          node.m_parent = current_index;
+          workspace.m_open_list.decrease_key(n_index, g_cost);
+        }
+        continue;
+      }
+
+      n_index = workspace.m_arena.allocate(n_coords, g_cost, g_cost,
+          current_index);
+      nodes.insert(n_coords, n_index);
+      workspace.m_open_list.push(n_index);
+    }
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline std::size_t
+landmark_table<node_groupT, traversal_traitsT>::index_of(
+    vector_t const & coords) const
+{
+  if (m_landmarks.empty()
+      || coords.m_x < m_min.m_x || coords.m_x >= m_max.m_x
+      || coords.m_y < m_min.m_y || coords.m_y >= m_max.m_y)
+  {
+    return std::size_t(-1);
+  }
+
+  return std::size_t(coords.m_y - m_min.m_y)
+    * std::size_t(m_max.m_x - m_min.m_x)
+    + std::size_t(coords.m_x - m_min.m_x);
+}
+
+
+
+/*****************************************************************************
+ * class landmark_heuristic
+ */
+
+namespace heuristics {
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+landmark_heuristic<node_groupT, traversal_traitsT>::landmark_heuristic(
+    landmark_table<node_groupT, traversal_traitsT> const & table)
+  : m_table(&table)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+landmark_heuristic<node_groupT, traversal_traitsT>::prepare(
+    node_groupT const & /* group */, vector_t const & /* start */,
+    vector_t const & end, traversal_traitsT & /* traversal_traits */)
+{
+  m_end_from.clear();
+  m_end_to.clear();
+
+  unit_t const * from = m_table->costs_from(end);
+  unit_t const * to = m_table->costs_to(end);
+  if (!from) {
+    return;
+  }
+
+  // The tables may lack costs for end nodes that the traversal traits don't
+  // allow entering, but a_star() enters them anyway, so the bounds via other
+  // landmarks don't hold either. Estimate zero instead.
+  std::size_t count = m_table->landmarks().size();
+  for (std::size_t i = 0 ; i < count ; ++i) {
+    if (from[i] == invalid_unit || to[i] == invalid_unit) {
+      return;
+    }
+  }
+  m_end_from.assign(from, from + count);
+  m_end_to.assign(to, to + count);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+inline unit_t
+landmark_heuristic<node_groupT, traversal_traitsT>::operator()(
+    vector_t const & current) const
+{
+  unit_t const * from = m_table->costs_from(current);
+  if (!from) {
+    return 0;
+  }
+  unit_t const * to = m_table->costs_to(current);
+
+  // Unreachable nodes don't bound anything.
+  unit_t h = 0;
+  for (std::size_t i = 0 ; i < m_end_from.size() ; ++i) {
+    if (from[i] != invalid_unit) {
+      h = std::max(h, m_end_from[i] - from[i]);
+    }
+    if (to[i] != invalid_unit) {
+      h = std::max(h, to[i] - m_end_to[i]);
+    }
+  }
+  return h;
+}
+
+} // namespace heuristics
+
+}} // namespace cartograph::pathfinding
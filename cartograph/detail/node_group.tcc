@@ -30,14 +30,17 @@ namespace cartograph {
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::node(
-    node_group<node_dataT, tile_traitsT, id_generatorT> * group,
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::node(
+    node_group<node_dataT, tile_traitsT, id_generatorT, storageT> * group,
     node_id_t const & _id, vector_t const & coords)
   : m_group(group)
   , m_id(_id)
   , m_coords(coords)
+  , m_data(0)
+  , m_data_version(~version_t(0))
 {
 }
 
@@ -46,13 +49,16 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::node(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::node(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::node(
     node const & other)
   : m_group(other.m_group)
   , m_id(other.m_id)
   , m_coords(other.m_coords)
+  , m_data(other.m_data)
+  , m_data_version(other.m_data_version)
 {
 }
 
@@ -61,9 +67,10 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::node(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::~node()
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::~node()
 {
 }
 
@@ -72,10 +79,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::~node()
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node_id_t
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::id() const
+typename node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node_id_t
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::id() const
 {
   return m_id;
 }
@@ -85,10 +95,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::id() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 vector_t
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::coordinates() const
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::coordinates() const
 {
   return m_coords;
 }
@@ -98,10 +111,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::coordinates() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 node_dataT const *
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator->() const
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::operator->() const
 {
   return get();
 }
@@ -111,10 +127,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator->() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 node_dataT *
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator->()
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::operator->()
 {
   return get();
 }
@@ -124,13 +143,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator->()
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 node_dataT const *
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::get() const
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::get() const
 {
-  node_data_ptr p = m_group->get(m_id);
-  return p.get();
+  return lookup();
 }
 
 
@@ -138,23 +157,24 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::get() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 node_dataT *
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::get()
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::get()
 {
-  node_data_ptr p = m_group->get(m_id);
-  return p.get();
+  return lookup();
 }
 
 
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node &
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator=(
+typename node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node &
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::operator=(
     node_dataT const & other)
 {
   m_group->set(m_id, m_coords, other);
@@ -165,12 +185,14 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator=(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator bool() const
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::operator bool() const
 {
-  node_data_ptr p = m_group->get(m_id);
-  return (p);
+  return lookup() != 0;
 }
 
 
@@ -178,10 +200,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::operator bool() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::get_relative(
+typename node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::get_relative(
     directions_t const & dir) const
 {
   vector_t coords = tile_traitsT::get_relative(m_coords, dir);
@@ -197,10 +222,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::get_relative(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::move_to(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::move_to(
     unit_t const & x, unit_t const & y)
 {
   return move_to(vector_t(x, y));
@@ -211,10 +237,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::move_to(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::move_to(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::move_to(
     vector_t const & coords)
 {
   bool result = m_group->move(m_coords, coords);
@@ -229,10 +256,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::move_to(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 directions_t const * const
-node_group<node_dataT, tile_traitsT, id_generatorT>::node::available_dirs(
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::node::available_dirs(
     join_t join_type) const
 {
   return tile_traitsT::available_dirs(m_coords, join_type);
@@ -240,6 +270,28 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::available_dirs(
 
 
 
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT *
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node::lookup()
+  const
+{
+  // Any change to the node_group that could move or remove node data also
+  // changes it's version.
+  version_t version = m_group->version();
+  if (m_data_version != version) {
+    m_data = m_group->get(m_id, m_coords);
+    m_data_version = version;
+  }
+  return m_data;
+}
+
+
+
 
 /*****************************************************************************
  * Class node_group<>
@@ -248,10 +300,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node::available_dirs(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node_group()
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node_group()
   : m_id_generator(new id_generatorT())
+  , m_version(0)
+  , m_clear_version(0)
 {
 }
 
@@ -260,11 +315,14 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node_group()
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-node_group<node_dataT, tile_traitsT, id_generatorT>::node_group(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node_group(
     id_generatorT const & gen)
   : m_id_generator(new id_generatorT(gen))
+  , m_version(0)
+  , m_clear_version(0)
 {
 }
 
@@ -275,10 +333,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::node_group(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node
-node_group<node_dataT, tile_traitsT, id_generatorT>::operator()(
+typename node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::operator()(
     unit_t const & x, unit_t const & y) const
 {
   return operator()(vector_t(x, y));
@@ -289,10 +348,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::operator()(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node
-node_group<node_dataT, tile_traitsT, id_generatorT>::operator()(
+typename node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::node
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::operator()(
     vector_t const & coords) const
 {
   if (!is_valid(coords)) {
@@ -301,11 +361,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::operator()(
 
   node_id_t id = node_id_t();
 
-  typename coordinate_map_t::const_iterator iter = m_nodes.find(coords);
-  if (iter == m_nodes.end()) {
+  node_id_t const * found = m_storage.find(coords);
+  if (!found) {
     id = m_id_generator->get_unique_id();
   } else {
-    id = iter->second;
+    id = *found;
   }
 
   return node(const_cast<node_group *>(this), id, coords);
@@ -316,10 +376,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::operator()(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::is_valid(unit_t const & x,
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::is_valid(unit_t const & x,
     unit_t const & y) const
 {
   return is_valid(vector_t(x, y));
@@ -330,10 +393,11 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::is_valid(unit_t const & x,
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::is_valid(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::is_valid(
     vector_t const & coords) const
 {
   return tile_traitsT::is_valid(coords);
@@ -344,31 +408,33 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::is_valid(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-typename node_group<node_dataT, tile_traitsT, id_generatorT>::node_data_ptr
-node_group<node_dataT, tile_traitsT, id_generatorT>::get(
-    node_id_t const & id) const
+node_dataT *
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::get(
+    node_id_t const & id, vector_t const & coords) const
 {
-  typename node_data_map_t::const_iterator iter = m_node_data.find(id);
-  if (iter == m_node_data.end()) {
-    return node_data_ptr();
-  }
-  return iter->second.m_data;
+  return m_storage.get(id, coords);
 }
 
 
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 void
-node_group<node_dataT, tile_traitsT, id_generatorT>::clear()
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::clear()
 {
-  m_nodes.clear();
-  m_node_data.clear();
+  m_storage.clear();
+  m_bounds.clear();
   m_id_generator->reset();
+
+  // Affects all regions.
+  m_clear_version = ++m_version;
+  m_region_versions.clear();
 }
 
 
@@ -377,10 +443,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::clear()
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::is_empty(unit_t const & x,
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::is_empty(unit_t const & x,
     unit_t const & y) const
 {
   return is_empty(vector_t(x, y));
@@ -391,14 +460,14 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::is_empty(unit_t const & x,
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::is_empty(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::is_empty(
     vector_t const & coords) const
 {
-  typename coordinate_map_t::const_iterator iter = m_nodes.find(coords);
-  return (iter == m_nodes.end());
+  return !m_storage.find(coords);
 }
 
 
@@ -406,32 +475,103 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::is_empty(
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
-vector_t
-node_group<node_dataT, tile_traitsT, id_generatorT>::min_coords() const
+node_dataT const *
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::try_get(unit_t const & x,
+    unit_t const & y) const
 {
-  // XXX Easy to optimize by remembering min/max when nodes are created.
-  vector_t ret;
+  return try_get(vector_t(x, y));
+}
+
 
-  typename coordinate_map_t::const_iterator node_end = m_nodes.end();
-  for (typename coordinate_map_t::const_iterator iter = m_nodes.begin()
-      ; iter != node_end ; ++iter)
-  {
-    if (ret.m_x == invalid_unit) {
-      ret.m_x = iter->first.m_x;
-    } else {
-      ret.m_x = std::min<unit_t>(ret.m_x, iter->first.m_x);
-    }
-
-    if (ret.m_y == invalid_unit) {
-      ret.m_y = iter->first.m_y;
-    } else {
-      ret.m_y = std::min<unit_t>(ret.m_y, iter->first.m_y);
-    }
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT const *
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::try_get(
+    vector_t const & coords) const
+{
+  if (!tile_traitsT::is_valid(coords)) {
+    return 0;
   }
+  return m_storage.find_data(coords);
+}
 
-  return ret;
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT *
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::try_get(unit_t const & x,
+    unit_t const & y)
+{
+  return try_get(vector_t(x, y));
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT *
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::try_get(
+    vector_t const & coords)
+{
+  if (!tile_traitsT::is_valid(coords)) {
+    return 0;
+  }
+  return m_storage.find_data(coords);
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT const *
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::try_get_relative(vector_t const & coords,
+    directions_t const & dir) const
+{
+  return try_get(tile_traitsT::get_relative(coords, dir));
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+node_dataT *
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::try_get_relative(vector_t const & coords,
+    directions_t const & dir)
+{
+  return try_get(tile_traitsT::get_relative(coords, dir));
 }
 
 
@@ -439,35 +579,31 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::min_coords() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 vector_t
-node_group<node_dataT, tile_traitsT, id_generatorT>::max_coords() const
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::min_coords() const
 {
-  // XXX Easy to optimize by remembering min/max when nodes are created.
-  vector_t ret;
+  return m_bounds.min_coords();
+}
 
-  typename coordinate_map_t::const_iterator node_end = m_nodes.end();
-  for (typename coordinate_map_t::const_iterator iter = m_nodes.begin()
-      ; iter != node_end ; ++iter)
-  {
-    if (ret.m_x == invalid_unit) {
-      ret.m_x = iter->first.m_x;
-    } else {
-      ret.m_x = std::max<unit_t>(ret.m_x, iter->first.m_x);
-    }
-
-    if (ret.m_y == invalid_unit) {
-      ret.m_y = iter->first.m_y;
-    } else {
-      ret.m_y = std::max<unit_t>(ret.m_y, iter->first.m_y);
-    }
-  }
 
-  // for STL-/pointer-like iteration
-  ++ret.m_x;
-  ++ret.m_y;
-  return ret;
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+vector_t
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::max_coords() const
+{
+  return m_bounds.max_coords();
 }
 
 
@@ -475,12 +611,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::max_coords() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 size_t
-node_group<node_dataT, tile_traitsT, id_generatorT>::size() const
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::size() const
 {
-  return m_node_data.size();
+  return m_storage.size();
 }
 
 
@@ -488,16 +625,23 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::size() const
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 void
-node_group<node_dataT, tile_traitsT, id_generatorT>::set(node_id_t const & id,
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::set(node_id_t const & id,
     vector_t const & coords, node_dataT const & data)
 {
-  node_data_wrapper & w = m_node_data[id];
-  w.m_data = node_data_ptr(new node_dataT(data));
-  w.m_coords = coords;
-  m_nodes[coords] = id;
+  // Overwriting an existing node doesn't change the bounding box.
+  std::size_t size = m_storage.size();
+  m_storage.set(id, coords, data);
+  if (m_storage.size() != size) {
+    m_bounds.add(coords);
+  }
+
+  touch(coords);
 }
 
 
@@ -505,25 +649,23 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::set(node_id_t const & id,
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::move(vector_t const & from,
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::move(vector_t const & from,
     vector_t const & to)
 {
-  typename coordinate_map_t::iterator iter = m_nodes.find(from);
-  if (iter == m_nodes.end()) {
-    return false;
-  }
-
-  typename coordinate_map_t::const_iterator c_iter = m_nodes.find(to);
-  if (c_iter != m_nodes.end()) {
+  if (!m_storage.move(from, to)) {
     return false;
   }
+  m_bounds.remove(from);
+  m_bounds.add(to);
 
-  node_id_t id = iter->second;
-  m_nodes.erase(iter);
-  m_nodes[to] = id;
+  touch(from);
+  touch(to);
 
   return true;
 }
@@ -533,10 +675,13 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::move(vector_t const & from,
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::erase(unit_t const & x,
+node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::erase(unit_t const & x,
     unit_t const & y)
 {
   return erase(vector_t(x, y));
@@ -547,24 +692,94 @@ node_group<node_dataT, tile_traitsT, id_generatorT>::erase(unit_t const & x,
 template <
   typename node_dataT,
   typename tile_traitsT,
-  typename id_generatorT
+  typename id_generatorT,
+  typename storageT
 >
 bool
-node_group<node_dataT, tile_traitsT, id_generatorT>::erase(
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::erase(
     vector_t const & coords)
 {
-  typename coordinate_map_t::iterator iter = m_nodes.find(coords);
-  if (iter == m_nodes.end()) {
+  if (!m_storage.erase(coords)) {
     return false;
   }
+  m_bounds.remove(coords);
 
-  node_id_t id = iter->second;
-  m_nodes.erase(iter);
-  m_node_data.erase(id);
+  touch(coords);
 
   return true;
 }
 
 
 
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+typename node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::version_t
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::version() const
+{
+  return m_version;
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+typename node_group<
+  node_dataT, tile_traitsT, id_generatorT, storageT
+>::version_t
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::region_version(
+    vector_t const & region) const
+{
+  return m_region_versions.get(region, m_clear_version);
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+vector_t
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::region_of(
+    vector_t const & coords)
+{
+  // Round towards negative infinity, so that regions don't straddle the
+  // axes.
+  vector_t ret;
+  ret.m_x = (coords.m_x >= 0) ? (coords.m_x >> REGION_BITS)
+    : -((-coords.m_x - 1) >> REGION_BITS) - 1;
+  ret.m_y = (coords.m_y >= 0) ? (coords.m_y >> REGION_BITS)
+    : -((-coords.m_y - 1) >> REGION_BITS) - 1;
+  return ret;
+}
+
+
+
+template <
+  typename node_dataT,
+  typename tile_traitsT,
+  typename id_generatorT,
+  typename storageT
+>
+void
+node_group<node_dataT, tile_traitsT, id_generatorT, storageT>::touch(
+    vector_t const & coords)
+{
+  m_region_versions.set(region_of(coords), ++m_version);
+}
+
+
+
 } // namespace cartograph
@@ -80,4 +80,49 @@ struct IDGeneratorConcept
 };
 
 
+/*****************************************************************************
+ * NodeStorageConcept
+ */
+template <
+    typename storageT
+>
+struct NodeStorageConcept
+{
+  void constraints()
+  {
+    // Return the id of the node at the given coordinates, or a null pointer
+    // if there is none.
+    typename storageT::node_id_t const * id = const_storage.find(coords);
+
+    // Return the data of the node with the given id, or a null pointer if
+    // there is no such node. The coordinates are where the node was last
+    // seen; the node may have been moved since.
+    typename storageT::node_data_t * data = const_storage.get(*id, coords);
+
+    // Return the data of the node at the given coordinates, or a null pointer
+    // if there is none.
+    data = const_storage.find_data(coords);
+
+    // Store node data for the given id at the given coordinates, replacing
+    // any node there.
+    storage.set(*id, coords, *data);
+
+    // Move or erase the node at the given coordinates; return false if there
+    // is no such node, or if moving to an occupied position.
+    bool b = storage.move(coords, coords);
+    b = storage.erase(coords);
+    boost::ignore_unused_variable_warning(b);
+
+    storage.clear();
+
+    std::size_t s = const_storage.size();
+    boost::ignore_unused_variable_warning(s);
+  }
+
+  storageT &        storage;
+  storageT const &  const_storage;
+  vector_t const &  coords;
+};
+
+
 }} // namespace cartograph::concepts
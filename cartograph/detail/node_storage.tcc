@@ -0,0 +1,828 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+#include <map>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <cartograph/error.h>
+#include <cartograph/detail/coords_hash.h>
+
+namespace cartograph {
+namespace detail {
+
+/*****************************************************************************
+ * class map_node_storage
+ */
+
+template <
+  typename node_idT,
+  typename node_dataT
+>
+class map_node_storage
+  : private boost::noncopyable
+{
+public:
+  typedef node_idT    node_id_t;
+  typedef node_dataT  node_data_t;
+
+
+  node_id_t const *
+  find(vector_t const & coords) const
+  {
+    typename coordinate_map_t::const_iterator iter = m_nodes.find(coords);
+    if (iter == m_nodes.end()) {
+      return 0;
+    }
+    return &iter->second;
+  }
+
+
+  node_dataT *
+  find_data(vector_t const & coords) const
+  {
+    node_id_t const * id = find(coords);
+    return id ? get(*id, coords) : 0;
+  }
+
+
+  node_dataT *
+  get(node_id_t const & id, vector_t const & /* coords */) const
+  {
+    typename node_data_map_t::const_iterator iter = m_node_data.find(id);
+    if (iter == m_node_data.end()) {
+      return 0;
+    }
+    return const_cast<node_dataT *>(&iter->second);
+  }
+
+
+  void
+  set(node_id_t const & id, vector_t const & coords, node_dataT const & data)
+  {
+    // Replace any other node at the coordinates, and any data the node had.
+    // Ids tend to be created in ascending order, so the lower bounds make
+    // good insertion hints.
+    typename coordinate_map_t::iterator iter = m_nodes.lower_bound(coords);
+    if (iter != m_nodes.end() && iter->first == coords) {
+      if (iter->second != id) {
+        m_node_data.erase(iter->second);
+        iter->second = id;
+      }
+    }
+    else {
+      m_nodes.insert(iter, std::make_pair(coords, id));
+    }
+
+    typename node_data_map_t::iterator data_iter = m_node_data.lower_bound(id);
+    if (data_iter != m_node_data.end() && !(id < data_iter->first)) {
+      m_node_data.erase(data_iter++);
+    }
+    m_node_data.insert(data_iter, std::make_pair(id, data));
+  }
+
+
+  bool
+  move(vector_t const & from, vector_t const & to)
+  {
+    typename coordinate_map_t::iterator iter = m_nodes.find(from);
+    if (iter == m_nodes.end()) {
+      return false;
+    }
+
+    typename coordinate_map_t::const_iterator c_iter = m_nodes.find(to);
+    if (c_iter != m_nodes.end()) {
+      return false;
+    }
+
+    node_id_t id = iter->second;
+    m_nodes.erase(iter);
+    m_nodes[to] = id;
+    return true;
+  }
+
+
+  bool
+  erase(vector_t const & coords)
+  {
+    typename coordinate_map_t::iterator iter = m_nodes.find(coords);
+    if (iter == m_nodes.end()) {
+      return false;
+    }
+
+    node_id_t id = iter->second;
+    m_nodes.erase(iter);
+    m_node_data.erase(id);
+    return true;
+  }
+
+
+  void
+  clear()
+  {
+    m_nodes.clear();
+    m_node_data.clear();
+  }
+
+
+  std::size_t
+  size() const
+  {
+    return m_node_data.size();
+  }
+
+private:
+  // Map coordinates to node ids.
+  typedef std::map<vector_t, node_id_t> coordinate_map_t;
+  coordinate_map_t m_nodes;
+
+  // Map node ids to user-defined node data, which lives in the map's nodes
+  // rather than in separate allocations.
+  typedef std::map<node_id_t, node_dataT> node_data_map_t;
+  node_data_map_t m_node_data;
+};
+
+
+
+/*****************************************************************************
+ * class chunked_node_storage
+ */
+
+template <
+  typename node_idT,
+  typename node_dataT
+>
+class chunked_node_storage
+  : private boost::noncopyable
+{
+public:
+  typedef node_idT    node_id_t;
+  typedef node_dataT  node_data_t;
+
+
+  chunked_node_storage()
+    : m_size(0)
+  {
+  }
+
+
+  ~chunked_node_storage()
+  {
+    clear();
+  }
+
+
+  node_id_t const *
+  find(vector_t const & coords) const
+  {
+    chunk const * c = find_chunk(chunk_of(coords));
+    if (!c) {
+      return 0;
+    }
+
+    std::size_t cell = cell_of(coords, c->m_coords);
+    return c->is_present(cell) ? &c->m_ids[cell] : 0;
+  }
+
+
+  node_dataT *
+  find_data(vector_t const & coords) const
+  {
+    chunk * c = find_chunk(chunk_of(coords));
+    if (!c) {
+      return 0;
+    }
+
+    std::size_t cell = cell_of(coords, c->m_coords);
+    return c->is_present(cell) ? c->data(cell) : 0;
+  }
+
+
+  node_dataT *
+  get(node_id_t const & id, vector_t const & coords) const
+  {
+    node_dataT * data = get_at(id, coords);
+    if (data) {
+      return data;
+    }
+
+    // The node may have been moved since the caller last saw it.
+    typename moved_map_t::const_iterator iter = m_moved.find(id);
+    if (iter == m_moved.end() || iter->second == coords) {
+      return 0;
+    }
+    return get_at(id, iter->second);
+  }
+
+
+  void
+  set(node_id_t const & id, vector_t const & coords, node_dataT const & data)
+  {
+    vector_t chunk_coords = chunk_of(coords);
+    chunk * c = find_chunk(chunk_coords);
+    if (!c) {
+      c = add_chunk(chunk_coords);
+    }
+
+    std::size_t cell = cell_of(coords, c->m_coords);
+    if (c->is_present(cell)) {
+      if (c->m_ids[cell] != id) {
+        m_moved.erase(c->m_ids[cell]);
+      }
+      remove(*c, cell);
+    }
+
+    new (c->data(cell)) node_dataT(data);
+    add(*c, cell, id);
+  }
+
+
+  bool
+  move(vector_t const & from, vector_t const & to)
+  {
+    chunk * source = find_chunk(chunk_of(from));
+    if (!source) {
+      return false;
+    }
+    std::size_t source_cell = cell_of(from, source->m_coords);
+    if (!source->is_present(source_cell) || find(to)) {
+      return false;
+    }
+
+    vector_t chunk_coords = chunk_of(to);
+    chunk * target = find_chunk(chunk_coords);
+    if (!target) {
+      target = add_chunk(chunk_coords);
+    }
+    std::size_t target_cell = cell_of(to, target->m_coords);
+
+    node_id_t id = source->m_ids[source_cell];
+    new (target->data(target_cell)) node_dataT(*source->data(source_cell));
+    add(*target, target_cell, id);
+    remove(*source, source_cell);
+
+    m_moved[id] = to;
+    return true;
+  }
+
+
+  bool
+  erase(vector_t const & coords)
+  {
+    chunk * c = find_chunk(chunk_of(coords));
+    if (!c) {
+      return false;
+    }
+
+    std::size_t cell = cell_of(coords, c->m_coords);
+    if (!c->is_present(cell)) {
+      return false;
+    }
+
+    m_moved.erase(c->m_ids[cell]);
+    remove(*c, cell);
+    return true;
+  }
+
+
+  void
+  clear()
+  {
+    for (std::size_t i = 0 ; i < m_chunks.size() ; ++i) {
+      chunk * c = m_chunks[i];
+      for (std::size_t cell = 0 ; c->m_count && cell < CHUNK_CELLS ; ++cell) {
+        if (c->is_present(cell)) {
+          remove(*c, cell);
+        }
+      }
+      delete c;
+    }
+
+    m_chunks.clear();
+    m_table.clear();
+    m_moved.clear();
+    m_size = 0;
+  }
+
+
+  std::size_t
+  size() const
+  {
+    return m_size;
+  }
+
+private:
+  enum
+  {
+    CHUNK_BITS = chunked_storage::CHUNK_BITS,
+    CHUNK_SIZE = chunked_storage::CHUNK_SIZE,
+    CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE,
+    MIN_TABLE_SIZE = 16,
+  };
+
+  // The ids and data of all positions within a chunk, and for each position
+  // whether there is a node; ids and data are only valid for positions with
+  // a node.
+  struct chunk
+  {
+    explicit chunk(vector_t const & coords)
+      : m_coords(coords)
+      , m_count(0)
+    {
+      std::fill(m_present, m_present + PRESENT_WORDS, 0);
+    }
+
+    bool is_present(std::size_t cell) const
+    {
+      return m_present[cell / 32] & (uint32_t(1) << (cell % 32));
+    }
+
+    void set_present(std::size_t cell, bool present)
+    {
+      if (present) {
+        m_present[cell / 32] |= (uint32_t(1) << (cell % 32));
+      }
+      else {
+        m_present[cell / 32] &= ~(uint32_t(1) << (cell % 32));
+      }
+    }
+
+    node_dataT * data(std::size_t cell)
+    {
+      return static_cast<node_dataT *>(static_cast<void *>(&m_data)) + cell;
+    }
+
+    enum
+    {
+      PRESENT_WORDS = CHUNK_CELLS / 32,
+    };
+
+    vector_t    m_coords;
+    std::size_t m_count;
+    uint32_t    m_present[PRESENT_WORDS];
+    node_id_t   m_ids[CHUNK_CELLS];
+    typename boost::aligned_storage<
+      sizeof(node_dataT) * CHUNK_CELLS,
+      boost::alignment_of<node_dataT>::value
+    >::type     m_data;
+  };
+
+
+  static unit_t
+  floor_div(unit_t value)
+  {
+    // Round towards negative infinity, as node_group::region_of() does.
+    return (value >= 0) ? (value >> CHUNK_BITS)
+      : -((-value - 1) >> CHUNK_BITS) - 1;
+  }
+
+
+  static vector_t
+  chunk_of(vector_t const & coords)
+  {
+    return vector_t(floor_div(coords.m_x), floor_div(coords.m_y));
+  }
+
+
+  static std::size_t
+  cell_of(vector_t const & coords, vector_t const & chunk_coords)
+  {
+    return std::size_t(coords.m_y - chunk_coords.m_y * CHUNK_SIZE)
+      * CHUNK_SIZE + std::size_t(coords.m_x - chunk_coords.m_x * CHUNK_SIZE);
+  }
+
+
+  static std::size_t
+  hash(vector_t const & chunk_coords)
+  {
+    return mix_coords_key(coords_key(chunk_coords));
+  }
+
+
+  chunk *
+  find_chunk(vector_t const & chunk_coords) const
+  {
+    if (m_table.empty()) {
+      return 0;
+    }
+
+    std::size_t mask = m_table.size() - 1;
+    for (std::size_t i = hash(chunk_coords) & mask ; ; i = (i + 1) & mask) {
+      chunk * c = m_table[i];
+      if (!c || c->m_coords == chunk_coords) {
+        return c;
+      }
+    }
+  }
+
+
+  chunk *
+  add_chunk(vector_t const & chunk_coords)
+  {
+    // Keep the table at most half full, so probe sequences stay short.
+    if ((m_chunks.size() + 1) * 2 > m_table.size()) {
+      std::vector<chunk *> table(std::max<std::size_t>(MIN_TABLE_SIZE,
+            m_table.size() * 2), static_cast<chunk *>(0));
+      for (std::size_t i = 0 ; i < m_chunks.size() ; ++i) {
+        insert(table, m_chunks[i]);
+      }
+      m_table.swap(table);
+    }
+
+    m_chunks.reserve(m_chunks.size() + 1);
+    chunk * c = new chunk(chunk_coords);
+    m_chunks.push_back(c);
+    insert(m_table, c);
+    return c;
+  }
+
+
+  static void
+  insert(std::vector<chunk *> & table, chunk * c)
+  {
+    std::size_t mask = table.size() - 1;
+    std::size_t i = hash(c->m_coords) & mask;
+    while (table[i]) {
+      i = (i + 1) & mask;
+    }
+    table[i] = c;
+  }
+
+
+  node_dataT *
+  get_at(node_id_t const & id, vector_t const & coords) const
+  {
+    chunk * c = find_chunk(chunk_of(coords));
+    if (!c) {
+      return 0;
+    }
+
+    std::size_t cell = cell_of(coords, c->m_coords);
+    if (!c->is_present(cell) || c->m_ids[cell] != id) {
+      return 0;
+    }
+    return c->data(cell);
+  }
+
+
+  void
+  add(chunk & c, std::size_t cell, node_id_t const & id)
+  {
+    c.m_ids[cell] = id;
+    c.set_present(cell, true);
+    ++c.m_count;
+    ++m_size;
+  }
+
+
+  void
+  remove(chunk & c, std::size_t cell)
+  {
+    c.data(cell)->~node_dataT();
+    c.set_present(cell, false);
+    --c.m_count;
+    --m_size;
+  }
+
+
+  // All chunks, in the order they were allocated, and a hash table of them,
+  // using linear probing.
+  std::vector<chunk *>  m_chunks;
+  std::vector<chunk *>  m_table;
+
+  // Number of nodes in all chunks.
+  std::size_t           m_size;
+
+  // Where moved nodes went, for node instances that saw them before.
+  typedef std::map<node_id_t, vector_t> moved_map_t;
+  moved_map_t           m_moved;
+};
+
+
+
+/*****************************************************************************
+ * class hash_node_storage
+ */
+
+template <
+  typename node_idT,
+  typename node_dataT
+>
+class hash_node_storage
+  : private boost::noncopyable
+{
+public:
+  typedef node_idT    node_id_t;
+  typedef node_dataT  node_data_t;
+
+
+  hash_node_storage()
+    : m_size(0)
+  {
+  }
+
+
+  ~hash_node_storage()
+  {
+    clear();
+  }
+
+
+  node_id_t const *
+  find(vector_t const & coords) const
+  {
+    std::size_t slot = find_slot(coords);
+    return (slot == NO_SLOT) ? 0 : &m_ids[slot];
+  }
+
+
+  node_dataT *
+  find_data(vector_t const & coords) const
+  {
+    std::size_t slot = find_slot(coords);
+    return (slot == NO_SLOT) ? 0 : data_at(slot);
+  }
+
+
+  node_dataT *
+  get(node_id_t const & id, vector_t const & coords) const
+  {
+    node_dataT * data = get_at(id, coords);
+    if (data) {
+      return data;
+    }
+
+    // The node may have been moved since the caller last saw it.
+    typename moved_map_t::const_iterator iter = m_moved.find(id);
+    if (iter == m_moved.end() || iter->second == coords) {
+      return 0;
+    }
+    return get_at(id, iter->second);
+  }
+
+
+  void
+  set(node_id_t const & id, vector_t const & coords, node_dataT const & data)
+  {
+    if (!coords_key_fits(coords)) {
+      throw exception(CG_INVALID_COORDS);
+    }
+
+    std::size_t slot = find_slot(coords);
+    if (slot != NO_SLOT) {
+      if (m_ids[slot] != id) {
+        m_moved.erase(m_ids[slot]);
+      }
+      data_at(slot)->~node_dataT();
+      new (data_at(slot)) node_dataT(data);
+      m_ids[slot] = id;
+      return;
+    }
+
+    reserve(m_size + 1);
+    slot = free_slot(m_keys, coords_key(coords));
+    new (data_at(slot)) node_dataT(data);
+    add(slot, coords_key(coords), id);
+  }
+
+
+  bool
+  move(vector_t const & from, vector_t const & to)
+  {
+    if (!coords_key_fits(to) || find_slot(from) == NO_SLOT
+        || find_slot(to) != NO_SLOT)
+    {
+      return false;
+    }
+
+    // Growing the table moves all entries, so look the source up after.
+    reserve(m_size + 1);
+    std::size_t source = find_slot(from);
+    std::size_t target = free_slot(m_keys, coords_key(to));
+
+    node_id_t id = m_ids[source];
+    new (data_at(target)) node_dataT(*data_at(source));
+    add(target, coords_key(to), id);
+    remove(source);
+
+    m_moved[id] = to;
+    return true;
+  }
+
+
+  bool
+  erase(vector_t const & coords)
+  {
+    std::size_t slot = find_slot(coords);
+    if (slot == NO_SLOT) {
+      return false;
+    }
+
+    m_moved.erase(m_ids[slot]);
+    remove(slot);
+    return true;
+  }
+
+
+  void
+  clear()
+  {
+    for (std::size_t i = 0 ; m_size && i < m_keys.size() ; ++i) {
+      if (m_keys[i] != coords_key_unused) {
+        data_at(i)->~node_dataT();
+        --m_size;
+      }
+    }
+
+    m_keys.clear();
+    m_ids.clear();
+    m_data.clear();
+    m_moved.clear();
+    m_size = 0;
+  }
+
+
+  std::size_t
+  size() const
+  {
+    return m_size;
+  }
+
+private:
+  enum
+  {
+    MIN_CAPACITY = 16,
+  };
+
+  static std::size_t const NO_SLOT = ~std::size_t(0);
+
+  typedef typename boost::aligned_storage<
+    sizeof(node_dataT),
+    boost::alignment_of<node_dataT>::value
+  >::type slot_data_t;
+
+
+  node_dataT *
+  data_at(std::size_t slot) const
+  {
+    return static_cast<node_dataT *>(static_cast<void *>(
+          const_cast<slot_data_t *>(&m_data[slot])));
+  }
+
+
+  std::size_t
+  find_slot(vector_t const & coords) const
+  {
+    if (!m_size || !coords_key_fits(coords)) {
+      return NO_SLOT;
+    }
+
+    uint64_t key = coords_key(coords);
+    std::size_t mask = m_keys.size() - 1;
+    for (std::size_t i = mix_coords_key(key) & mask ; ; i = (i + 1) & mask) {
+      if (m_keys[i] == key) {
+        return i;
+      }
+      if (m_keys[i] == coords_key_unused) {
+        return NO_SLOT;
+      }
+    }
+  }
+
+
+  static std::size_t
+  free_slot(std::vector<uint64_t> const & keys, uint64_t key)
+  {
+    std::size_t mask = keys.size() - 1;
+    std::size_t i = mix_coords_key(key) & mask;
+    while (keys[i] != coords_key_unused) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+
+  void
+  reserve(std::size_t size)
+  {
+    // Keep the table at most 70% full; with a good hash, linear probing
+    // stays fast up to there.
+    if (size * 10 <= m_keys.size() * 7) {
+      return;
+    }
+
+    std::size_t capacity = std::max<std::size_t>(MIN_CAPACITY,
+        m_keys.size() * 2);
+    while (size * 10 > capacity * 7) {
+      capacity *= 2;
+    }
+
+    std::vector<uint64_t> keys(capacity, coords_key_unused);
+    std::vector<node_id_t> ids(capacity);
+    std::vector<slot_data_t> data(capacity);
+    for (std::size_t i = 0 ; i < m_keys.size() ; ++i) {
+      if (m_keys[i] == coords_key_unused) {
+        continue;
+      }
+      std::size_t slot = free_slot(keys, m_keys[i]);
+      keys[slot] = m_keys[i];
+      ids[slot] = m_ids[i];
+      new (static_cast<void *>(&data[slot])) node_dataT(*data_at(i));
+      data_at(i)->~node_dataT();
+    }
+
+    m_keys.swap(keys);
+    m_ids.swap(ids);
+    m_data.swap(data);
+  }
+
+
+  node_dataT *
+  get_at(node_id_t const & id, vector_t const & coords) const
+  {
+    std::size_t slot = find_slot(coords);
+    if (slot == NO_SLOT || m_ids[slot] != id) {
+      return 0;
+    }
+    return data_at(slot);
+  }
+
+
+  void
+  add(std::size_t slot, uint64_t key, node_id_t const & id)
+  {
+    m_keys[slot] = key;
+    m_ids[slot] = id;
+    ++m_size;
+  }
+
+
+  void
+  remove(std::size_t slot)
+  {
+    data_at(slot)->~node_dataT();
+
+    // Shift following entries of the probe sequence back into the freed
+    // slot where that doesn't move them before their home slot, so that no
+    // tombstones are needed and lookups can stop at the first unused slot.
+    std::size_t mask = m_keys.size() - 1;
+    for (std::size_t i = (slot + 1) & mask ; m_keys[i] != coords_key_unused
+        ; i = (i + 1) & mask)
+    {
+      std::size_t home = mix_coords_key(m_keys[i]) & mask;
+      if (((i - home) & mask) < ((i - slot) & mask)) {
+        continue;
+      }
+
+      m_keys[slot] = m_keys[i];
+      m_ids[slot] = m_ids[i];
+      new (data_at(slot)) node_dataT(*data_at(i));
+      data_at(i)->~node_dataT();
+      slot = i;
+    }
+
+    m_keys[slot] = coords_key_unused;
+    --m_size;
+  }
+
+
+  // The table, in separate arrays of the slots' keys, node ids and node data;
+  // ids and data are only valid in slots whose key isn't coords_key_unused.
+  // The table's size is always a power of two.
+  std::vector<uint64_t>     m_keys;
+  std::vector<node_id_t>    m_ids;
+  std::vector<slot_data_t>  m_data;
+
+  // Number of nodes in the table.
+  std::size_t               m_size;
+
+  // Where moved nodes went, for node instances that saw them before.
+  typedef std::map<node_id_t, vector_t> moved_map_t;
+  moved_map_t               m_moved;
+};
+
+}} // namespace cartograph::detail
@@ -0,0 +1,238 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <functional>
+#include <set>
+
+namespace cartograph {
+namespace pathfinding {
+
+/*****************************************************************************
+ * class path_cache
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+path_cache<node_groupT, traversal_traitsT>::path_cache(
+    node_groupT const & group, std::size_t capacity /* = 256 */)
+  : m_group(group)
+  , m_capacity(capacity)
+  , m_hits(0)
+  , m_misses(0)
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+template <typename heuristicT>
+error_t
+path_cache<node_groupT, traversal_traitsT>::find_path(
+    std::deque<vector_t> & result, vector_t const & start,
+    vector_t const & end, traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic)
+{
+  key_t key;
+  key.m_start = start;
+  key.m_end = end;
+  key.m_traversal_traits = &traversal_traits;
+
+  typename entry_map_t::iterator iter = m_index.find(key);
+  if (iter != m_index.end()) {
+    if (is_current(*iter->second)) {
+      ++m_hits;
+      m_entries.splice(m_entries.begin(), m_entries, iter->second);
+      result = iter->second->m_path;
+      return iter->second->m_error;
+    }
+
+    m_entries.erase(iter->second);
+    m_index.erase(iter);
+  }
+
+  ++m_misses;
+  result.clear();
+  error_t err = a_star(result, m_group, start, end, traversal_traits,
+      heuristic, m_context);
+  if ((CG_OK != err && CG_NO_PATH != err) || !m_capacity) {
+    return err;
+  }
+
+  if (m_entries.size() >= m_capacity) {
+    m_index.erase(m_entries.back().m_key);
+    m_entries.pop_back();
+  }
+
+  m_entries.push_front(entry_t());
+  entry_t & entry = m_entries.front();
+  entry.m_key = key;
+  entry.m_error = err;
+  entry.m_path = result;
+  entry.m_version = m_group.version();
+  collect_regions(entry.m_regions, traversal_traits.join_types());
+  m_index[key] = m_entries.begin();
+
+  return err;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+path_cache<node_groupT, traversal_traitsT>::clear()
+{
+  m_entries.clear();
+  m_index.clear();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+path_cache<node_groupT, traversal_traitsT>::size() const
+{
+  return m_index.size();
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+path_cache<node_groupT, traversal_traitsT>::capacity() const
+{
+  return m_capacity;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+path_cache<node_groupT, traversal_traitsT>::hits() const
+{
+  return m_hits;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+std::size_t
+path_cache<node_groupT, traversal_traitsT>::misses() const
+{
+  return m_misses;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+bool
+path_cache<node_groupT, traversal_traitsT>::is_current(
+    entry_t const & entry) const
+{
+  if (m_group.version() == entry.m_version) {
+    return true;
+  }
+
+  for (std::size_t i = 0 ; i < entry.m_regions.size() ; ++i) {
+    if (m_group.region_version(entry.m_regions[i]) > entry.m_version) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+void
+path_cache<node_groupT, traversal_traitsT>::collect_regions(
+    std::vector<vector_t> & regions, join_t const & join_types)
+{
+  // The search's result depends on the nodes it processed, and on their
+  // neighbours - including those it skipped because they're not part of the
+  // node_group or impassable.
+  detail::node_arena const & arena = m_context.workspace().m_arena;
+
+  std::set<vector_t> found;
+  for (detail::node_index_t index = 0 ; index < arena.size() ; ++index) {
+    detail::search_node_t const & node = arena[index];
+    if (!node.m_closed) {
+      continue;
+    }
+
+    found.insert(node_groupT::region_of(node.m_coords));
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        node.m_coords, join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      found.insert(node_groupT::region_of(
+            tile_traits_t::get_relative(node.m_coords, *d)));
+    }
+  }
+
+  regions.assign(found.begin(), found.end());
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+bool
+path_cache<node_groupT, traversal_traitsT>::key_t::operator<(
+    key_t const & other) const
+{
+  if (m_start != other.m_start) {
+    return m_start < other.m_start;
+  }
+  if (m_end != other.m_end) {
+    return m_end < other.m_end;
+  }
+  return std::less<traversal_traitsT const *>()(m_traversal_traits,
+      other.m_traversal_traits);
+}
+
+}} // namespace cartograph::pathfinding
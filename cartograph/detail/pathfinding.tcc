@@ -19,16 +19,10 @@
  * author with your specific requirements.
  **/
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
-#include <map>
-
-#include <boost/shared_ptr.hpp>
-#include <boost/weak_ptr.hpp>
-
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
+#include <vector>
 
 
 namespace cartograph {
@@ -38,251 +32,2071 @@ namespace pathfinding {
 namespace detail {
 
 /**
- * The open list is a bit more complicated. In some instances we need to quickly
- * find a node by it's coordinates, in other's by it's cost. Either way, once
- * we've found it, we need it's g_cost, coordinates, parent. So the following
- * structure makes for a good value type regardless.
+ * Determines the cost of moving from neighbour to current, which is what
+ * searches running backwards need; returns false if that's impossible. We need
+ * to find the direction in which current lies as seen from neighbour for that,
+ * which is stored in dir if it's non-NULL.
+ **/
+template <
+  typename tile_traitsT,
+  typename traversal_traitsT
+>
+inline bool
+reverse_traversal_cost(traversal_traitsT & traversal_traits,
+    join_t const & join_types, vector_t const & current,
+    vector_t const & neighbour, unit_t & cost, directions_t * dir = 0)
+{
+  directions_t const * const dirs = tile_traitsT::available_dirs(
+      neighbour, join_types);
+  for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+    if (tile_traitsT::get_relative(neighbour, *d) != current) {
+      continue;
+    }
+    if (traversal_traits.is_impassable(neighbour, *d)) {
+      return false;
+    }
+    cost = traversal_traits.traversal_cost(neighbour, *d);
+    if (dir) {
+      *dir = *d;
+    }
+    return true;
+  }
+  return false;
+}
+
+
+
+/**
+ * Binds a heuristic to the start and end node of a search, so the pathfinders
+ * only need to pass the current node. Prepared heuristics (see heuristics.h)
+ * are prepared once here; other heuristics are called with the bound values
+ * for every node.
  *
- * For lookup, we'll keep a multi_index_container of pointers to the structure.
+ * heuristicT may be a function type if a function was passed by name; it's
+ * stored as a function pointer then.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT,
+  bool preparedT = boost::is_base_of<
+    heuristics::prepared_heuristic_tag,
+    typename boost::decay<heuristicT>::type
+  >::value
+>
+class bound_heuristic
+{
+public:
+  typedef typename boost::decay<heuristicT>::type heuristic_t;
+
+  explicit bound_heuristic(heuristic_t const & heuristic)
+    : m_heuristic(heuristic)
+    , m_group(0)
+    , m_traversal_traits(0)
+  {
+  }
+
+
+  void
+  prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits)
+  {
+    m_group = &group;
+    m_start = start;
+    m_end = end;
+    m_traversal_traits = &traversal_traits;
+  }
+
+
+  unit_t
+  operator()(vector_t const & current)
+  {
+    return m_heuristic(*m_group, m_start, current, m_end, *m_traversal_traits);
+  }
+
+private:
+  heuristic_t               m_heuristic;
+  node_groupT const *       m_group;
+  vector_t                  m_start;
+  vector_t                  m_end;
+  traversal_traitsT *       m_traversal_traits;
+};
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class bound_heuristic<node_groupT, traversal_traitsT, heuristicT, true>
+{
+public:
+  explicit bound_heuristic(heuristicT const & heuristic)
+    : m_heuristic(heuristic)
+  {
+  }
+
+
+  void
+  prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits)
+  {
+    m_heuristic.prepare(group, start, end, traversal_traits);
+  }
+
+
+  unit_t
+  operator()(vector_t const & current) const
+  {
+    return m_heuristic(current);
+  }
+
+private:
+  heuristicT                m_heuristic;
+};
+
+
+
+/**
+ * Estimates the costs to the nearest of several goals, as the minimum of the
+ * given heuristic's estimates for each goal. The end node passed to prepare()
+ * is ignored.
  **/
-struct ol_entry_t
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class nearest_goal_heuristic
+  : public heuristics::prepared_heuristic_tag
 {
-  ol_entry_t(vector_t const & coords, unit_t const & g_cost, unit_t const & f_cost,
-      boost::shared_ptr<ol_entry_t> parent)
-    : m_coords(coords)
-    , m_g_cost(g_cost)
-    , m_f_cost(f_cost)
-    , m_parent(parent)
+public:
+  typedef typename boost::decay<heuristicT>::type heuristic_t;
+
+  nearest_goal_heuristic(heuristic_t const & heuristic,
+      std::vector<vector_t> const & goals)
+    : m_heuristic(heuristic)
+    , m_goals(goals)
+  {
+  }
+
+
+  void
+  prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & /* end */, traversal_traitsT & traversal_traits)
+  {
+    m_bound.clear();
+    m_bound.reserve(m_goals.size());
+    for (std::size_t i = 0 ; i < m_goals.size() ; ++i) {
+      m_bound.push_back(bound_heuristic_t(m_heuristic));
+      m_bound.back().prepare(group, start, m_goals[i], traversal_traits);
+    }
+  }
+
+
+  unit_t
+  operator()(vector_t const & current) const
   {
+    unit_t h = m_bound[0](current);
+    for (std::size_t i = 1 ; i < m_bound.size() ; ++i) {
+      h = std::min(h, m_bound[i](current));
+    }
+    return h;
   }
 
-  vector_t                      m_coords;
-  unit_t                        m_g_cost;
-  unit_t                        m_f_cost;
-  boost::weak_ptr<ol_entry_t>   m_parent;
+private:
+  typedef bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  > bound_heuristic_t;
+
+  heuristic_t                             m_heuristic;
+  std::vector<vector_t> const &           m_goals;
+  // Plain heuristics aren't necessarily callable when const.
+  mutable std::vector<bound_heuristic_t>  m_bound;
 };
-typedef boost::shared_ptr<ol_entry_t> ol_entry_ptr;
-
-struct vector_index {};
-struct f_cost_index {};
-typedef boost::multi_index_container<
-  ol_entry_ptr,
-  boost::multi_index::indexed_by<
-    boost::multi_index::ordered_unique<
-      boost::multi_index::tag<vector_index>,
-      boost::multi_index::member<ol_entry_t, vector_t, &ol_entry_t::m_coords>
-    >,
-    boost::multi_index::ordered_non_unique<
-      boost::multi_index::tag<f_cost_index>,
-      boost::multi_index::member<ol_entry_t, unit_t, &ol_entry_t::m_f_cost>
-    >
-  >
-> open_list_t;
+
+
 
 /**
- * The closed list for the pathfinder is fairly simple in nature: we just need
- * to stuff all visited coordinates into it. But since removing ancestors from
- * the open list would take them out of scope and release them, we'd end up with
- * only the last node in the path - we must store the shared pointer as well.
+ * Multiplies the given heuristic's estimates by a weight, for weighted A*.
  **/
-typedef std::map<vector_t, ol_entry_ptr> closed_list_t;
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class weighted_heuristic
+  : public heuristics::prepared_heuristic_tag
+{
+public:
+  weighted_heuristic(heuristicT const & heuristic, double weight)
+    : m_bound(heuristic)
+    , m_weight(weight)
+  {
+  }
+
+
+  void
+  prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits)
+  {
+    m_bound.prepare(group, start, end, traversal_traits);
+  }
+
+
+  unit_t
+  operator()(vector_t const & current) const
+  {
+    return unit_t(m_weight * m_bound(current));
+  }
+
+private:
+  // Plain heuristics aren't necessarily callable when const.
+  mutable bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  >       m_bound;
+  double  m_weight;
+};
+
 
 
 /**
  * The pathfinder implements the A* algorithm proper, and keeps state between
- * iterations.
+ * iterations. The node arena, open list and node lookup it works on are owned
+ * by the caller, and expected to be empty (reset) when find_path() is called.
+ *
+ * The heuristic is stored by value and called directly, so that function
+ * objects can be inlined into the main loop; prepared heuristics are prepared
+ * when the pathfinder is constructed.
  **/
 template <
   typename traversal_traitsT,
-  typename node_groupT
+  typename node_groupT,
+  typename open_listT = open_list_t,
+  typename node_lookupT = map_node_lookup,
+  typename heuristicT = typename heuristic_function<
+    node_groupT,
+    traversal_traitsT
+  >::type
 >
 struct pathfinder
 {
   // Convenience typedefs
   typedef typename node_groupT::tile_traits_t tile_traits_t;
 
-  typedef boost::function<
-    unit_t (node_groupT const &, vector_t const &, vector_t const &,
-        vector_t const &, traversal_traitsT &)
-  > heuristic_t;
-
-  typedef typename open_list_t::index<vector_index>::type vector_index_t;
-  typedef typename open_list_t::index<f_cost_index>::type f_cost_index_t;
 
-
-  // ctor
+  // ctor; if goals is given, it must be sorted, and the search ends at the
+  // first of those nodes that's processed instead of at the end node.
   pathfinder(node_groupT const & group, vector_t const & start,
       vector_t const & end, traversal_traitsT & traversal_traits,
-      heuristic_t heuristic)
+      heuristicT const & heuristic, search_limits const & limits,
+      node_arena & arena, open_listT & open_list, node_lookupT & nodes,
+      std::vector<vector_t> const * goals = 0)
     : m_group(group)
     , m_start(start)
     , m_end(end)
     , m_traversal_traits(traversal_traits)
     , m_heuristic(heuristic)
+    , m_limits(limits)
     , m_join_types(m_traversal_traits.join_types())
+    , m_arena(arena)
+    , m_open_list(open_list)
+    , m_nodes(nodes)
+    , m_expansions(0)
+    , m_pruned(false)
+    , m_best(invalid_node_index)
+    , m_error(CG_OK)
+    , m_goals(goals)
   {
+    m_heuristic.prepare(m_group, m_start, m_end, m_traversal_traits);
   }
 
 
   /**
-   * Main entry point into the algorithm. Sets up the start node, and starts
-   * processing nodes from there...
+   * Main entry point into the algorithm. Sets up the start node, and processes
+   * nodes from there until the search is finished.
    **/
   error_t
   find_path(std::deque<vector_t> & result)
+  {
+    start();
+    run(0, result);
+    return m_error;
+  }
+
+
+  /**
+   * Sets up the start node; call this before run().
+   **/
+  void
+  start()
   {
     // For the start node, the F cost is equal to H, as G is zero.
-    unit_t h_cost = m_heuristic(m_group, m_start, m_start, m_end,
-        m_traversal_traits);
+    unit_t h_cost = m_heuristic(m_start);
 
-    ol_entry_ptr current_ptr = ol_entry_ptr(
-        new ol_entry_t(m_start, 0, h_cost, ol_entry_ptr())
-      );
+    node_index_t start_index = m_arena.allocate(m_start, 0, h_cost,
+        invalid_node_index);
+
+    m_nodes.insert(m_start, start_index);
+    m_open_list.push(start_index);
+  }
 
-    m_new_open_list.insert(current_ptr);
 
-    do {
-      // Drop current entry from open list...
-      vector_index_t & ol_vector_index = m_new_open_list.get<vector_index>();
-      vector_index_t::iterator v_iter = ol_vector_index.find(current_ptr->m_coords);
-      if (v_iter != ol_vector_index.end()) {
-        ol_vector_index.erase(v_iter);
+  /**
+   * Processes up to max_expansions nodes, or until the search is finished if
+   * max_expansions is zero. Once the search is finished, the path (if any) is
+   * stored in result, and m_error holds the search's return value.
+   **/
+  search_state_t
+  run(std::size_t max_expansions, std::deque<vector_t> & result)
+  {
+    for (std::size_t i = 0 ; !max_expansions || i < max_expansions ; ++i) {
+      search_state_t state = expand(result);
+      if (SEARCH_IN_PROGRESS != state) {
+        return state;
       }
+    }
+    return SEARCH_IN_PROGRESS;
+  }
 
-      // ... and add it to closed list.
-      m_closed_list.insert(std::make_pair(current_ptr->m_coords, current_ptr));
-
-      // Iterate over adjacents nodes.
-      typename node_groupT::node current_node = m_group(current_ptr->m_coords);
-      directions_t const * const dirs = current_node.available_dirs(m_join_types);
-      for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
-
-        // Must be valid - because we got the dirs from available_dirs().
-        vector_t n_coords = tile_traits_t::get_relative(current_ptr->m_coords, *d);
-        assert(n_coords != invalid_vector);
-
-        // Success! We've found the end node!
-        if (n_coords == m_end) {
-          // Walk backwards from here to the start node. Since we walk backwards,
-          // we push coordinates to the front of the deque so it later on becomes
-          // iteratable front-to-back.
-          while (current_ptr) {
-            result.push_front(current_ptr->m_coords);
-            current_ptr = current_ptr->m_parent.lock();
-          }
-          result.push_back(m_end);
-          return CG_OK;
-        }
 
-        // Not an end node, we may process this further...
-        //
-        // Only consider nodes that are actually on the map.
-        if (m_group.is_empty(n_coords)) {
-          continue;
-        }
+  /**
+   * Processes the next node on the open list.
+   **/
+  search_state_t
+  expand(std::deque<vector_t> & result)
+  {
+    // If there's nothing left to process, there is no path - unless we
+    // ignored nodes due to the cost limit.
+    if (m_open_list.empty()) {
+      return give_up(result, m_pruned ? CG_BUDGET_EXCEEDED : CG_NO_PATH);
+    }
 
-        // Ignore impassable nodes
-        if (m_traversal_traits.is_impassable(current_ptr->m_coords, *d)) {
-          continue;
-        }
+    if (m_limits.m_max_expansions
+        && m_expansions >= m_limits.m_max_expansions)
+    {
+      return give_up(result, CG_BUDGET_EXCEEDED);
+    }
+
+    // Find the node on the open list with the lowest F cost, drop it from the
+    // open list and add it to closed list.
+    node_index_t current_index = m_open_list.pop();
+    search_node_t & current = m_arena[current_index];
+    current.m_closed = true;
+    ++m_expansions;
+
+    // Remember the node that's closest to the end node, in case we need to
+    // return a partial path.
+    if (m_limits.m_return_partial_path) {
+      update_best(current_index);
+    }
+
+    // With several goals, finding one when it's generated means finding the
+    // nearest one only if all moves cost the same; wait until it's processed.
+    if (m_goals && std::binary_search(m_goals->begin(), m_goals->end(),
+          current.m_coords))
+    {
+      build_path(result, current_index);
+      m_error = CG_OK;
+      return SEARCH_FOUND;
+    }
 
-        // Skip nodes on the closed list.
-        if (m_closed_list.find(n_coords) != m_closed_list.end()) {
+    // Iterate over adjacents nodes.
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        current.m_coords, m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+
+      // Must be valid - because we got the dirs from available_dirs().
+      vector_t n_coords = tile_traits_t::get_relative(current.m_coords, *d);
+      assert(n_coords != invalid_vector);
+
+      // Success! We've found the end node!
+      if (!m_goals && n_coords == m_end) {
+        if (m_limits.m_max_g_cost
+            && current.m_g_cost + m_traversal_traits.traversal_cost(
+              current.m_coords, *d) > m_limits.m_max_g_cost)
+        {
+          m_pruned = true;
           continue;
         }
 
-        // Traversal traits contains terrain cost.
-        unit_t g_cost = current_ptr->m_g_cost
-          + m_traversal_traits.traversal_cost(current_ptr->m_coords, *d);
-
-        // If we find the same node in the open list with a higher g_cost, we want
-        // to replace that entry with a new one. That way we'll find the lowest
-        // cost for reaching each tested node.
-        v_iter = ol_vector_index.find(n_coords);
-        if (v_iter != ol_vector_index.end()) {
-          if ((*v_iter)->m_g_cost > g_cost) {
-            // Found a cheaper one, erase the current entry.
-            ol_vector_index.erase(v_iter);
-          } else {
-            // Found a more or equally expensive entry... we're finished for this
-            // node, it's already on the open list in the best possible config.
-            continue;
-          }
+        build_path(result, current_index);
+        result.push_back(m_end);
+        m_error = CG_OK;
+        return SEARCH_FOUND;
+      }
+
+      // Not an end node, we may process this further...
+      //
+      // Only consider nodes that are actually on the map.
+      if (m_group.is_empty(n_coords)) {
+        continue;
+      }
+
+      // Ignore impassable nodes
+      if (m_traversal_traits.is_impassable(current.m_coords, *d)) {
+        continue;
+      }
+
+      // Skip nodes on the closed list.
+      node_index_t n_index = m_nodes.find(n_coords);
+      if (n_index != invalid_node_index && m_arena[n_index].m_closed) {
+        continue;
+      }
+
+      // Traversal traits contains terrain cost.
+      unit_t g_cost = current.m_g_cost
+        + m_traversal_traits.traversal_cost(current.m_coords, *d);
+
+      // Ignore nodes that are too expensive to reach.
+      if (m_limits.m_max_g_cost && g_cost > m_limits.m_max_g_cost) {
+        m_pruned = true;
+        continue;
+      }
+
+      // If we find the same node in the open list with a higher g_cost, we want
+      // to update that entry with the new costs and parent. That way we'll find
+      // the lowest cost for reaching each tested node.
+      if (n_index != invalid_node_index) {
+        search_node_t & node = m_arena[n_index];
+        if (node.m_g_cost > g_cost) {
+          // Found a cheaper one; the heuristic part of the f_cost stays the
+          // same, so we don't need to recalculate it.
+          unit_t f_cost = g_cost + (node.m_f_cost - node.m_g_cost);
+          node.m_g_cost = g_cost;
+          node.m_parent = current_index;
+          m_open_list.decrease_key(n_index, f_cost);
         }
+        // Otherwise we've found a more or equally expensive entry... we're
+        // finished for this node, it's already on the open list in the best
+        // possible config.
+        continue;
+      }
 
-        // We've either just erased info from the open list for this node, or it's
-        // newly encountered... either way, we'll add it to the open_list again
-        // with it's proper f_cost
-        unit_t h_cost = m_heuristic(m_group, m_start, n_coords, m_end,
-            m_traversal_traits);
+      // Newly encountered node, add it to the open list with it's proper
+      // f_cost
+      unit_t h_cost = m_heuristic(n_coords);
 
-        unit_t f_cost = g_cost + h_cost;
+      unit_t f_cost = g_cost + h_cost;
 
-        ol_entry_ptr node_ptr = ol_entry_ptr(
-            new ol_entry_t(n_coords, g_cost, f_cost, current_ptr)
-          );
-        m_new_open_list.insert(node_ptr);
+      n_index = m_arena.allocate(n_coords, g_cost, f_cost, current_index);
+      m_nodes.insert(n_coords, n_index);
+      m_open_list.push(n_index);
+
+      if (m_limits.m_max_open_list_size
+          && m_open_list.size() > m_limits.m_max_open_list_size)
+      {
+        return give_up(result, CG_BUDGET_EXCEEDED);
       }
+    }
+
+    return SEARCH_IN_PROGRESS;
+  }
+
+
+  /**
+   * Walk backwards from the given node to the start node. Since we walk
+   * backwards, we push coordinates to the front of the deque so it later on
+   * becomes iteratable front-to-back.
+   **/
+  void
+  build_path(std::deque<vector_t> & result, node_index_t index) const
+  {
+    for ( ; index != invalid_node_index ; index = m_arena[index].m_parent) {
+      result.push_front(m_arena[index].m_coords);
+    }
+  }
+
+
+  /**
+   * Keep track of the processed node with the lowest heuristic value, i.e. the
+   * one the heuristic deems closest to the end node. Of nodes with the same
+   * heuristic value, prefer the cheaper one.
+   **/
+  void
+  update_best(node_index_t const & index)
+  {
+    if (invalid_node_index == m_best) {
+      m_best = index;
+      return;
+    }
+
+    search_node_t const & node = m_arena[index];
+    search_node_t const & best = m_arena[m_best];
+    unit_t h_cost = node.m_f_cost - node.m_g_cost;
+    unit_t best_h_cost = best.m_f_cost - best.m_g_cost;
+    if (h_cost < best_h_cost
+        || (h_cost == best_h_cost && node.m_g_cost < best.m_g_cost))
+    {
+      m_best = index;
+    }
+  }
 
-      // After pushing all neighbours to the open list, we now need to find the
-      // node on the open list with the lowest F cost of them all..
-      f_cost_index_t & ol_f_cost_index = m_new_open_list.get<f_cost_index>();
-      f_cost_index_t::iterator f_iter = ol_f_cost_index.lower_bound(0);
 
-      // Great, let's process this one further.
-      current_ptr = *f_iter;
-    } while (true);
+  /**
+   * Record the given error, filling in the partial path if that's requested.
+   **/
+  search_state_t
+  give_up(std::deque<vector_t> & result, error_t err)
+  {
+    if (m_limits.m_return_partial_path) {
+      build_path(result, m_best);
+    }
+    m_error = err;
+    return SEARCH_FAILED;
   }
 
+
   node_groupT const & m_group;
-  vector_t const &    m_start;
-  vector_t const &    m_end;
+  vector_t            m_start;
+  vector_t            m_end;
 
   traversal_traitsT & m_traversal_traits;
-  heuristic_t         m_heuristic;
+  bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  >                   m_heuristic;
+  search_limits       m_limits;
 
   join_t              m_join_types;
 
-  open_list_t         m_new_open_list;
-  closed_list_t       m_closed_list;
-};
+  node_arena &        m_arena;
+  open_listT &        m_open_list;
+  node_lookupT &      m_nodes;
 
+  // Number of nodes moved to the closed list so far.
+  std::size_t         m_expansions;
+  // True if any nodes were ignored due to m_limits.m_max_g_cost.
+  bool                m_pruned;
+  // Best candidate for a partial path.
+  node_index_t        m_best;
+  // Result of the search, once it's finished.
+  error_t             m_error;
+  // Sorted goal nodes, if any.
+  std::vector<vector_t> const * m_goals;
+};
 
-} // namespace detail
 
 
+/**
+ * The bidirectional_pathfinder runs two searches, one forward from the start
+ * node and one backward from the end node, and keeps track of the cheapest
+ * path found via any node both searches have reached. Each search has it's own
+ * node arena, open list and node lookup, which must be empty (reset) when
+ * find_path() is called.
+ *
+ * If both searches used the heuristic as is, neither could stop before it had
+ * (almost) reached the other's root. Instead, nodes are ordered by their G cost
+ * plus half the difference between the heuristic towards the search's target
+ * and the heuristic towards the search's root - and the other way around for
+ * the other search. For any node, the sum of both searches' keys is then the
+ * costs of the path through that node, so once the sum of the lowest keys on
+ * either open list reaches the costs of the best path found, there's no cheaper
+ * path. To avoid rounding, the keys are stored doubled in the f_cost field.
+ **/
 template <
-  typename node_groupT,
   typename traversal_traitsT,
+  typename node_groupT,
+  typename node_lookupT,
   typename heuristicT
 >
-error_t
-a_star(std::deque<vector_t> & result, node_groupT const & group,
-    vector_t const & start, vector_t const & end,
-    traversal_traitsT & traversal_traits,
-    heuristicT const & heuristic)
+struct bidirectional_pathfinder
 {
-#ifndef CG_DISABLE_CONCEPT_CHECKS
-  boost::function_requires<
-    concepts::TraversalTraitsConcept<traversal_traitsT>
-  >();
+  // Convenience typedefs
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
 
-  boost::function_requires<
-    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
-  >();
-#endif
+  /**
+   * The state of either search.
+   **/
+  struct frontier
+  {
+    frontier(vector_t const & root, vector_t const & target, bool reverse,
+        search_workspace & workspace, node_lookupT & nodes)
+      : m_root(root)
+      , m_target(target)
+      , m_reverse(reverse)
+      , m_arena(workspace.m_arena)
+      , m_open_list(workspace.m_open_list)
+      , m_nodes(nodes)
+    {
+    }
 
+    vector_t      m_root;
+    vector_t      m_target;
+    // True if the search runs from the end node towards the start node.
+    bool          m_reverse;
 
-  // Prevent bogus input.
-  if (!group.is_valid(start) || !group.is_valid(end)) {
-    return CG_INVALID_COORDS;
+    node_arena &  m_arena;
+    open_list_t & m_open_list;
+    node_lookupT & m_nodes;
+  };
+
+
+  // ctor
+  bidirectional_pathfinder(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic,
+      search_workspace & forward_workspace, node_lookupT & forward_nodes,
+      search_workspace & backward_workspace, node_lookupT & backward_nodes)
+    : m_group(group)
+    , m_traversal_traits(traversal_traits)
+    , m_to_end(heuristic)
+    , m_to_start(heuristic)
+    , m_join_types(m_traversal_traits.join_types())
+    , m_forward(start, end, false, forward_workspace, forward_nodes)
+    , m_backward(end, start, true, backward_workspace, backward_nodes)
+    , m_met(false)
+    , m_best_cost(0)
+    , m_meet_forward(invalid_node_index)
+    , m_meet_backward(invalid_node_index)
+  {
+    m_to_end.prepare(m_group, start, end, m_traversal_traits);
+    m_to_start.prepare(m_group, end, start, m_traversal_traits);
+  }
+
+
+  /**
+   * Main entry point into the algorithm.
+   **/
+  error_t
+  find_path(std::deque<vector_t> & result)
+  {
+    add_root(m_forward, m_backward);
+    add_root(m_backward, m_forward);
+
+    // We're done when either open list runs out of nodes, or when the
+    // searches can't find a cheaper path than the best one found so far.
+    while (!m_forward.m_open_list.empty() && !m_backward.m_open_list.empty()) {
+      if (m_met && lowest_key(m_forward) + lowest_key(m_backward)
+          >= 2 * m_best_cost)
+      {
+        break;
+      }
+
+      // Expand the smaller frontier; that keeps both searches roughly the same
+      // size, and lets the search that's boxed in run out of nodes early.
+      if (m_forward.m_open_list.size() <= m_backward.m_open_list.size()) {
+        expand(m_forward, m_backward);
+      }
+      else {
+        expand(m_backward, m_forward);
+      }
+    }
+
+    if (!m_met) {
+      return CG_NO_PATH;
+    }
+
+    // The forward search's parents lead back to the start node, the backward
+    // search's parents to the end node.
+    node_index_t index = m_meet_forward;
+    while (index != invalid_node_index) {
+      search_node_t const & node = m_forward.m_arena[index];
+      result.push_front(node.m_coords);
+      index = node.m_parent;
+    }
+
+    index = m_backward.m_arena[m_meet_backward].m_parent;
+    while (index != invalid_node_index) {
+      search_node_t const & node = m_backward.m_arena[index];
+      result.push_back(node.m_coords);
+      index = node.m_parent;
+    }
+
+    return CG_OK;
   }
 
-  typedef detail::pathfinder<traversal_traitsT, node_groupT> pathfinder_t;
 
-  pathfinder_t pathfinder(group, start, end, traversal_traits, heuristic);
+  void
+  add_root(frontier & side, frontier & other)
+  {
+    node_index_t index = side.m_arena.allocate(side.m_root, 0,
+        potential(side, side.m_root), invalid_node_index);
 
-  return pathfinder.find_path(result);
+    side.m_nodes.insert(side.m_root, index);
+    side.m_open_list.push(index);
+
+    // Only matters if start and end are the same.
+    check_meeting(side, index, other);
+  }
+
+
+  unit_t
+  lowest_key(frontier const & side) const
+  {
+    return side.m_arena[side.m_open_list.top()].m_f_cost;
+  }
+
+
+  /**
+   * The part of the (doubled) key that's not the G cost; see above.
+   **/
+  unit_t
+  potential(frontier const & side, vector_t const & coords)
+  {
+    if (side.m_reverse) {
+      return m_to_start(coords) - m_to_end(coords);
+    }
+    return m_to_end(coords) - m_to_start(coords);
+  }
+
+
+  /**
+   * Move the node on the given side's open list with the lowest F cost to the
+   * closed list, and update it's neighbours.
+   **/
+  void
+  expand(frontier & side, frontier & other)
+  {
+    node_index_t current_index = side.m_open_list.pop();
+    search_node_t & current = side.m_arena[current_index];
+    current.m_closed = true;
+
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        current.m_coords, m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+
+      // Must be valid - because we got the dirs from available_dirs().
+      vector_t n_coords = tile_traits_t::get_relative(current.m_coords, *d);
+      assert(n_coords != invalid_vector);
+
+      // Only consider nodes that are actually on the map - the other search's
+      // root is always considered, as a_star() does for the end node.
+      if (n_coords != side.m_target && m_group.is_empty(n_coords)) {
+        continue;
+      }
+
+      unit_t cost = 0;
+      if (!traversal_cost(side, current.m_coords, *d, n_coords, cost)) {
+        continue;
+      }
+
+      // Skip nodes on the closed list.
+      node_index_t n_index = side.m_nodes.find(n_coords);
+      if (n_index != invalid_node_index && side.m_arena[n_index].m_closed) {
+        continue;
+      }
+
+      unit_t g_cost = current.m_g_cost + cost;
+
+      if (n_index != invalid_node_index) {
+        search_node_t & node = side.m_arena[n_index];
+        if (node.m_g_cost > g_cost) {
+          unit_t f_cost = 2 * g_cost + (node.m_f_cost - 2 * node.m_g_cost);
+          node.m_g_cost = g_cost;
+          node.m_parent = current_index;
+          side.m_open_list.decrease_key(n_index, f_cost);
+          check_meeting(side, n_index, other);
+        }
+        continue;
+      }
+
+      n_index = side.m_arena.allocate(n_coords, g_cost,
+          2 * g_cost + potential(side, n_coords), current_index);
+      side.m_nodes.insert(n_coords, n_index);
+      side.m_open_list.push(n_index);
+      check_meeting(side, n_index, other);
+    }
+  }
+
+
+  /**
+   * Determines the cost of moving between the given nodes; returns false if
+   * that's impossible. For the backward search, that's the cost of moving from
+   * the neighbour to the current node.
+   **/
+  bool
+  traversal_cost(frontier const & side, vector_t const & current,
+      directions_t const & dir, vector_t const & neighbour, unit_t & cost)
+  {
+    if (!side.m_reverse) {
+      if (m_traversal_traits.is_impassable(current, dir)) {
+        return false;
+      }
+      cost = m_traversal_traits.traversal_cost(current, dir);
+      return true;
+    }
+
+    return reverse_traversal_cost<tile_traits_t>(m_traversal_traits,
+        m_join_types, current, neighbour, cost);
+  }
+
+
+  /**
+   * If the other search has reached the given node, too, we've found a path;
+   * remember it if it's cheaper than the best one so far.
+   **/
+  void
+  check_meeting(frontier const & side, node_index_t const & index,
+      frontier const & other)
+  {
+    search_node_t const & node = side.m_arena[index];
+    node_index_t other_index = other.m_nodes.find(node.m_coords);
+    if (other_index == invalid_node_index) {
+      return;
+    }
+
+    unit_t cost = node.m_g_cost + other.m_arena[other_index].m_g_cost;
+    if (m_met && cost >= m_best_cost) {
+      return;
+    }
+
+    m_met = true;
+    m_best_cost = cost;
+    m_meet_forward = side.m_reverse ? other_index : index;
+    m_meet_backward = side.m_reverse ? index : other_index;
+  }
+
+
+  node_groupT const & m_group;
+  traversal_traitsT & m_traversal_traits;
+
+  typedef bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  > bound_heuristic_t;
+
+  // The heuristic towards either root.
+  bound_heuristic_t   m_to_end;
+  bound_heuristic_t   m_to_start;
+
+  join_t              m_join_types;
+
+  frontier            m_forward;
+  frontier            m_backward;
+
+  // Cheapest path found so far, if any.
+  bool                m_met;
+  unit_t              m_best_cost;
+  node_index_t        m_meet_forward;
+  node_index_t        m_meet_backward;
+};
+
+
+
+
+/**
+ * The anytime_pathfinder implements anytime repairing A* (ARA*): a series of
+ * weighted A* searches with decreasing weights, each of which reuses the
+ * nodes and costs of the previous one. As for the pathfinder, the node arena,
+ * open list and node lookup are owned by the caller, and expected to be empty
+ * (reset) when start() is called.
+ *
+ * Nodes are ordered by their G cost plus the weighted heuristic, which is
+ * stored in the f_cost field; the unweighted heuristic is kept separately, so
+ * that changing the weight doesn't require calling the heuristic again.
+ * Within an iteration, each node is processed at most once; nodes that become
+ * cheaper to reach after they were processed are set aside until the next
+ * iteration. An iteration ends when the end node's key is no higher than the
+ * lowest key on the open list.
+ **/
+template <
+  typename traversal_traitsT,
+  typename node_groupT,
+  typename open_listT = open_list_t,
+  typename node_lookupT = map_node_lookup,
+  typename heuristicT = typename heuristic_function<
+    node_groupT,
+    traversal_traitsT
+  >::type
+>
+struct anytime_pathfinder
+{
+  // Convenience typedefs
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  // Where a node is with respect to the current iteration.
+  enum node_state_t
+  {
+    NODE_OPEN         = 0,  // On the open list.
+    NODE_CLOSED       = 1,  // Processed in this iteration.
+    NODE_INCONSISTENT = 2,  // Processed, but has become cheaper since.
+    NODE_IDLE         = 3,  // Processed in an earlier iteration.
+  };
+
+
+  anytime_pathfinder(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, double weight, double weight_step,
+      node_arena & arena, open_listT & open_list, node_lookupT & nodes)
+    : m_group(group)
+    , m_start(start)
+    , m_end(end)
+    , m_traversal_traits(traversal_traits)
+    , m_heuristic(heuristic)
+    , m_weight(weight)
+    , m_weight_step(weight_step)
+    , m_join_types(m_traversal_traits.join_types())
+    , m_arena(arena)
+    , m_open_list(open_list)
+    , m_nodes(nodes)
+    , m_end_index(invalid_node_index)
+    , m_path_cost(invalid_unit)
+    , m_bound(0)
+    , m_error(CG_OK)
+  {
+    m_heuristic.prepare(m_group, m_start, m_end, m_traversal_traits);
+  }
+
+
+  /**
+   * Sets up the start node; call this before run().
+   **/
+  void
+  start()
+  {
+    add_node(m_start, 0, invalid_node_index);
+  }
+
+
+  /**
+   * Processes up to max_expansions nodes, or until the current iteration is
+   * finished if max_expansions is zero. When an iteration finishes, the path
+   * found is stored in result, and the weight lowered for the next iteration.
+   *
+   * Returns SEARCH_FOUND once the path in result is the cheapest path.
+   **/
+  search_state_t
+  run(std::size_t max_expansions, std::deque<vector_t> & result)
+  {
+    for (std::size_t i = 0 ; !max_expansions || i < max_expansions ; ++i) {
+      if (iteration_finished()) {
+        return finish_iteration(result);
+      }
+      expand();
+    }
+    return SEARCH_IN_PROGRESS;
+  }
+
+
+  /**
+   * True if no node on the open list could lead to a path that's cheaper than
+   * the one to the end node under the current weight.
+   **/
+  bool
+  iteration_finished() const
+  {
+    if (m_open_list.empty()) {
+      return true;
+    }
+    if (invalid_node_index == m_end_index) {
+      return false;
+    }
+    return key(m_end_index) <= m_arena[m_open_list.top()].m_f_cost;
+  }
+
+
+  /**
+   * Processes the next node on the open list. Unlike the pathfinder, the end
+   * node is never processed, so it's passability isn't checked either.
+   **/
+  void
+  expand()
+  {
+    node_index_t current_index = m_open_list.pop();
+    search_node_t & current = m_arena[current_index];
+    m_node_states[current_index] = NODE_CLOSED;
+
+    directions_t const * const dirs = tile_traits_t::available_dirs(
+        current.m_coords, m_join_types);
+    for (directions_t const * d = dirs ; *d != DIR_END ; ++d) {
+      vector_t n_coords = tile_traits_t::get_relative(current.m_coords, *d);
+      assert(n_coords != invalid_vector);
+
+      if (n_coords != m_end) {
+        if (m_group.is_empty(n_coords)) {
+          continue;
+        }
+        if (m_traversal_traits.is_impassable(current.m_coords, *d)) {
+          continue;
+        }
+      }
+
+      unit_t g_cost = current.m_g_cost
+        + m_traversal_traits.traversal_cost(current.m_coords, *d);
+
+      node_index_t n_index = m_nodes.find(n_coords);
+      if (n_index == invalid_node_index) {
+        add_node(n_coords, g_cost, current_index);
+        continue;
+      }
+
+      search_node_t & node = m_arena[n_index];
+      if (node.m_g_cost <= g_cost) {
+        continue;
+      }
+      node.m_g_cost = g_cost;
+      node.m_parent = current_index;
+
+      switch (m_node_states[n_index]) {
+        case NODE_OPEN:
+          m_open_list.decrease_key(n_index, key(n_index));
+          break;
+
+        case NODE_CLOSED:
+          m_node_states[n_index] = NODE_INCONSISTENT;
+          break;
+
+        case NODE_IDLE:
+          m_node_states[n_index] = NODE_OPEN;
+          node.m_f_cost = key(n_index);
+          m_open_list.push(n_index);
+          break;
+
+        default:
+          // Already set aside for the next iteration.
+          break;
+      }
+    }
+  }
+
+
+  /**
+   * Publishes the path found in this iteration along with it's bound, and
+   * sets up the next iteration if the path may not be the cheapest one.
+   **/
+  search_state_t
+  finish_iteration(std::deque<vector_t> & result)
+  {
+    if (invalid_node_index == m_end_index) {
+      m_error = CG_NO_PATH;
+      return SEARCH_FAILED;
+    }
+
+    // Nodes that became cheaper to reach don't pass that on to the nodes
+    // reached through them until they're processed again, so the path may
+    // well be cheaper than the end node's G cost.
+    result.clear();
+    m_path_cost = 0;
+    for (node_index_t index = m_end_index ; index != invalid_node_index
+        ; index = m_arena[index].m_parent)
+    {
+      search_node_t const & node = m_arena[index];
+      if (node.m_parent != invalid_node_index) {
+        m_path_cost += step_cost(m_arena[node.m_parent].m_coords,
+            node.m_coords);
+      }
+      result.push_front(node.m_coords);
+    }
+
+    // No path can be cheaper than the lowest unweighted F cost of any node
+    // that may still be processed. All nodes are visited here anyway, to
+    // collect those we need to process in the next iteration.
+    unit_t lower_bound = m_path_cost;
+    for (node_index_t index = 0 ; index < m_arena.size() ; ++index) {
+      char state = m_node_states[index];
+      if (NODE_OPEN == state || NODE_INCONSISTENT == state) {
+        lower_bound = std::min(lower_bound,
+            m_arena[index].m_g_cost + m_h_costs[index]);
+      }
+    }
+
+    m_bound = m_weight;
+    if (lower_bound >= m_path_cost) {
+      m_bound = 1;
+    }
+    else if (lower_bound > 0) {
+      m_bound = std::min(m_bound, double(m_path_cost) / lower_bound);
+    }
+
+    if (m_bound <= 1) {
+      m_bound = 1;
+      return SEARCH_FOUND;
+    }
+
+    m_weight = std::max(1.0, m_weight - m_weight_step);
+
+    // Rebuild the open list with the new weight, from the nodes left on it and
+    // the ones set aside.
+    m_open_list.clear();
+    for (node_index_t index = 0 ; index < m_arena.size() ; ++index) {
+      char & state = m_node_states[index];
+      if (NODE_OPEN == state || NODE_INCONSISTENT == state) {
+        state = NODE_OPEN;
+        m_arena[index].m_f_cost = key(index);
+        m_open_list.push(index);
+      }
+      else {
+        state = NODE_IDLE;
+      }
+    }
+
+    return SEARCH_IN_PROGRESS;
+  }
+
+
+  void
+  add_node(vector_t const & coords, unit_t const & g_cost,
+      node_index_t const & parent)
+  {
+    unit_t h_cost = m_heuristic(coords);
+
+    node_index_t index = m_arena.allocate(coords, g_cost,
+        g_cost + weighted(h_cost), parent);
+    m_nodes.insert(coords, index);
+    m_node_states.push_back(NODE_OPEN);
+    m_h_costs.push_back(h_cost);
+    m_open_list.push(index);
+
+    if (coords == m_end) {
+      m_end_index = index;
+    }
+  }
+
+
+  unit_t
+  step_cost(vector_t const & from, vector_t const & to) const
+  {
+    directions_t const * d = tile_traits_t::available_dirs(from,
+        m_join_types);
+    for ( ; *d != DIR_END ; ++d) {
+      if (tile_traits_t::get_relative(from, *d) == to) {
+        return m_traversal_traits.traversal_cost(from, *d);
+      }
+    }
+    assert(false);
+    return 0;
+  }
+
+
+  unit_t
+  weighted(unit_t const & h_cost) const
+  {
+    return unit_t(m_weight * h_cost);
+  }
+
+
+  unit_t
+  key(node_index_t const & index) const
+  {
+    return m_arena[index].m_g_cost + weighted(m_h_costs[index]);
+  }
+
+
+  node_groupT const & m_group;
+  vector_t            m_start;
+  vector_t            m_end;
+
+  traversal_traitsT & m_traversal_traits;
+  bound_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  >                   m_heuristic;
+  double              m_weight;
+  double              m_weight_step;
+
+  join_t              m_join_types;
+
+  node_arena &        m_arena;
+  open_listT &        m_open_list;
+  node_lookupT &      m_nodes;
+
+  // Per node, indexed like the arena.
+  std::vector<char>   m_node_states;
+  std::vector<unit_t> m_h_costs;
+
+  // The end node, once it's been reached.
+  node_index_t        m_end_index;
+  // Costs of the last path found.
+  unit_t              m_path_cost;
+  // Suboptimality bound of the last path found.
+  double              m_bound;
+  // Result of the search, once it's failed.
+  error_t             m_error;
+};
+
+} // namespace detail
+
+
+/*****************************************************************************
+ * class search_context
+ */
+
+inline
+search_context::search_context()
+{
+}
+
+
+
+inline detail::search_workspace &
+search_context::workspace()
+{
+  return m_workspace;
+}
+
+
+
+inline detail::search_workspace &
+search_context::reverse_workspace()
+{
+  if (!m_reverse_workspace) {
+    m_reverse_workspace.reset(new detail::search_workspace());
+  }
+  return *m_reverse_workspace;
+}
+
+
+
+/*****************************************************************************
+ * struct search_limits
+ */
+
+inline
+search_limits::search_limits()
+  : m_max_expansions(0)
+  , m_max_g_cost(0)
+  , m_max_open_list_size(0)
+  , m_return_partial_path(false)
+{
+}
+
+
+
+/*****************************************************************************
+ * a_star
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic)
+{
+  search_context context;
+  return a_star(result, group, start, end, traversal_traits, heuristic,
+      context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context)
+{
+  return a_star(result, group, start, end, traversal_traits, heuristic,
+      search_limits(), context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits)
+{
+  search_context context;
+  return a_star(result, group, start, end, traversal_traits, heuristic,
+      limits, context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits,
+    search_context & context)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || !group.is_valid(end)) {
+    return CG_INVALID_COORDS;
+  }
+
+  detail::search_workspace & ws = context.workspace();
+  ws.reset();
+
+  // If the group's bounds allow for it, keep track of visited nodes in a flat
+  // array rather than a map.
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)) {
+    ws.m_dense_lookup.reset(min, max);
+
+    detail::pathfinder<
+      traversal_traitsT,
+      node_groupT,
+      detail::open_list_t,
+      detail::dense_node_lookup,
+      heuristicT
+    > pathfinder(group, start, end, traversal_traits, heuristic, limits,
+        ws.m_arena, ws.m_open_list, ws.m_dense_lookup);
+    return pathfinder.find_path(result);
+  }
+
+  ws.m_map_lookup.reset(min, max);
+
+  detail::pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::map_node_lookup,
+    heuristicT
+  > pathfinder(group, start, end, traversal_traits, heuristic, limits,
+      ws.m_arena, ws.m_open_list, ws.m_map_lookup);
+  return pathfinder.find_path(result);
+}
+
+
+/*****************************************************************************
+ * a_star with several end nodes
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic)
+{
+  search_context context;
+  return a_star(result, group, start, ends, traversal_traits, heuristic,
+      context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context)
+{
+  return a_star(result, group, start, ends, traversal_traits, heuristic,
+      search_limits(), context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits)
+{
+  search_context context;
+  return a_star(result, group, start, ends, traversal_traits, heuristic,
+      limits, context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits,
+    search_context & context)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || ends.empty()) {
+    return CG_INVALID_COORDS;
+  }
+  for (std::size_t i = 0 ; i < ends.size() ; ++i) {
+    if (!group.is_valid(ends[i])) {
+      return CG_INVALID_COORDS;
+    }
+  }
+
+  // The pathfinder looks up goals via binary search.
+  std::vector<vector_t> goals(ends);
+  std::sort(goals.begin(), goals.end());
+  goals.erase(std::unique(goals.begin(), goals.end()), goals.end());
+
+  typedef detail::nearest_goal_heuristic<
+    node_groupT,
+    traversal_traitsT,
+    heuristicT
+  > nearest_goal_heuristic_t;
+  nearest_goal_heuristic_t nearest(heuristic, goals);
+
+  detail::search_workspace & ws = context.workspace();
+  ws.reset();
+
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)) {
+    ws.m_dense_lookup.reset(min, max);
+
+    detail::pathfinder<
+      traversal_traitsT,
+      node_groupT,
+      detail::open_list_t,
+      detail::dense_node_lookup,
+      nearest_goal_heuristic_t
+    > pathfinder(group, start, goals.front(), traversal_traits, nearest,
+        limits, ws.m_arena, ws.m_open_list, ws.m_dense_lookup, &goals);
+    return pathfinder.find_path(result);
+  }
+
+  ws.m_map_lookup.reset(min, max);
+
+  detail::pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::map_node_lookup,
+    nearest_goal_heuristic_t
+  > pathfinder(group, start, goals.front(), traversal_traits, nearest,
+      limits, ws.m_arena, ws.m_open_list, ws.m_map_lookup, &goals);
+  return pathfinder.find_path(result);
+}
+
+
+
+/*****************************************************************************
+ * weighted_a_star
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight)
+{
+  search_context context;
+  return weighted_a_star(result, group, start, end, traversal_traits,
+      heuristic, weight, context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_context & context)
+{
+  return weighted_a_star(result, group, start, end, traversal_traits,
+      heuristic, weight, search_limits(), context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_limits const & limits)
+{
+  search_context context;
+  return weighted_a_star(result, group, start, end, traversal_traits,
+      heuristic, weight, limits, context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_limits const & limits,
+    search_context & context)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  if (weight < 1) {
+    return CG_INVALID_VALUE;
+  }
+
+  // The weighted heuristic is a prepared heuristic, so a_star() prepares the
+  // heuristic it wraps just once.
+  return a_star(result, group, start, end, traversal_traits,
+      detail::weighted_heuristic<
+        node_groupT,
+        traversal_traitsT,
+        heuristicT
+      >(heuristic, weight),
+      limits, context);
+}
+
+
+
+/*****************************************************************************
+ * bidirectional_a_star
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+bidirectional_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic)
+{
+  search_context context;
+  return bidirectional_a_star(result, group, start, end, traversal_traits,
+      heuristic, context);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+bidirectional_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || !group.is_valid(end)) {
+    return CG_INVALID_COORDS;
+  }
+
+  detail::search_workspace & forward = context.workspace();
+  detail::search_workspace & backward = context.reverse_workspace();
+  forward.reset();
+  backward.reset();
+
+  // Same choice of node lookup as in a_star(), except both searches' roots
+  // must be in bounds.
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)
+      && detail::dense_node_lookup::suitable(min, max, group.size(), end))
+  {
+    forward.m_dense_lookup.reset(min, max);
+    backward.m_dense_lookup.reset(min, max);
+
+    detail::bidirectional_pathfinder<
+      traversal_traitsT,
+      node_groupT,
+      detail::dense_node_lookup,
+      heuristicT
+    > pathfinder(group, start, end, traversal_traits, heuristic,
+        forward, forward.m_dense_lookup, backward, backward.m_dense_lookup);
+    return pathfinder.find_path(result);
+  }
+
+  forward.m_map_lookup.reset(min, max);
+  backward.m_map_lookup.reset(min, max);
+
+  detail::bidirectional_pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::map_node_lookup,
+    heuristicT
+  > pathfinder(group, start, end, traversal_traits, heuristic,
+      forward, forward.m_map_lookup, backward, backward.m_map_lookup);
+  return pathfinder.find_path(result);
+}
+
+
+
+/*****************************************************************************
+ * class resumable_search
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::resumable_search(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    search_limits const & limits /* = search_limits() */)
+  : m_own_context(new search_context())
+  , m_context(*m_own_context)
+  , m_state(SEARCH_IN_PROGRESS)
+  , m_error(CG_OK)
+{
+  init(group, start, end, traversal_traits, heuristic, limits);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::resumable_search(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    search_limits const & limits, search_context & context)
+  : m_context(context)
+  , m_state(SEARCH_IN_PROGRESS)
+  , m_error(CG_OK)
+{
+  init(group, start, end, traversal_traits, heuristic, limits);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+resumable_search<node_groupT, traversal_traitsT,
+  heuristicT>::~resumable_search()
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::init(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    search_limits const & limits)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || !group.is_valid(end)) {
+    m_state = SEARCH_FAILED;
+    m_error = CG_INVALID_COORDS;
+    return;
+  }
+
+  detail::search_workspace & ws = m_context.workspace();
+  ws.reset();
+
+  // Same choice of node lookup as in a_star()
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)) {
+    ws.m_dense_lookup.reset(min, max);
+    m_dense_pathfinder.reset(new dense_pathfinder_t(group, start, end,
+          traversal_traits, heuristic, limits, ws.m_arena, ws.m_open_list,
+          ws.m_dense_lookup));
+    m_dense_pathfinder->start();
+  }
+  else {
+    ws.m_map_lookup.reset(min, max);
+    m_map_pathfinder.reset(new map_pathfinder_t(group, start, end,
+          traversal_traits, heuristic, limits, ws.m_arena, ws.m_open_list,
+          ws.m_map_lookup));
+    m_map_pathfinder->start();
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+search_state_t
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::step(
+    std::size_t max_expansions)
+{
+  if (SEARCH_IN_PROGRESS != m_state) {
+    return m_state;
+  }
+
+  if (m_dense_pathfinder) {
+    m_state = m_dense_pathfinder->run(max_expansions, m_path);
+    m_error = m_dense_pathfinder->m_error;
+  }
+  else {
+    m_state = m_map_pathfinder->run(max_expansions, m_path);
+    m_error = m_map_pathfinder->m_error;
+  }
+
+  return m_state;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+search_state_t
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::state() const
+{
+  return m_state;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::error() const
+{
+  return m_error;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+std::deque<vector_t> const &
+resumable_search<node_groupT, traversal_traitsT, heuristicT>::path() const
+{
+  return m_path;
+}
+
+
+
+/*****************************************************************************
+ * class anytime_search
+ */
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::anytime_search(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    double initial_weight /* = 3.0 */, double weight_step /* = 0.5 */)
+  : m_own_context(new search_context())
+  , m_context(*m_own_context)
+  , m_state(SEARCH_IN_PROGRESS)
+  , m_error(CG_OK)
+  , m_path_cost(invalid_unit)
+  , m_bound(0)
+  , m_weight(initial_weight)
+{
+  init(group, start, end, traversal_traits, heuristic, initial_weight,
+      weight_step);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::anytime_search(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    double initial_weight, double weight_step, search_context & context)
+  : m_context(context)
+  , m_state(SEARCH_IN_PROGRESS)
+  , m_error(CG_OK)
+  , m_path_cost(invalid_unit)
+  , m_bound(0)
+  , m_weight(initial_weight)
+{
+  init(group, start, end, traversal_traits, heuristic, initial_weight,
+      weight_step);
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::~anytime_search()
+{
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+void
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::init(
+    node_groupT const & group, vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+    double initial_weight, double weight_step)
+{
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  boost::function_requires<
+    concepts::TraversalTraitsConcept<traversal_traitsT>
+  >();
+
+  boost::function_requires<
+    concepts::HeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+  >();
+#endif
+
+  // Prevent bogus input.
+  if (!group.is_valid(start) || !group.is_valid(end)) {
+    m_state = SEARCH_FAILED;
+    m_error = CG_INVALID_COORDS;
+    return;
+  }
+
+  if (initial_weight < 1 || weight_step <= 0) {
+    m_state = SEARCH_FAILED;
+    m_error = CG_INVALID_VALUE;
+    return;
+  }
+
+  detail::search_workspace & ws = m_context.workspace();
+  ws.reset();
+
+  // Unlike the pathfinder used by a_star(), the anytime_pathfinder adds the
+  // end node to the node lookup, so both must fit into the dense lookup.
+  vector_t min = group.min_coords();
+  vector_t max = group.max_coords();
+  if (detail::dense_node_lookup::suitable(min, max, group.size(), start)
+      && detail::dense_node_lookup::suitable(min, max, group.size(), end))
+  {
+    ws.m_dense_lookup.reset(min, max);
+    m_dense_pathfinder.reset(new dense_pathfinder_t(group, start, end,
+          traversal_traits, heuristic, initial_weight,
+          weight_step, ws.m_arena, ws.m_open_list, ws.m_dense_lookup));
+    m_dense_pathfinder->start();
+  }
+  else {
+    ws.m_map_lookup.reset(min, max);
+    m_map_pathfinder.reset(new map_pathfinder_t(group, start, end,
+          traversal_traits, heuristic, initial_weight,
+          weight_step, ws.m_arena, ws.m_open_list, ws.m_map_lookup));
+    m_map_pathfinder->start();
+  }
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+search_state_t
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::step(
+    std::size_t max_expansions)
+{
+  if (SEARCH_IN_PROGRESS != m_state) {
+    return m_state;
+  }
+
+  // The path is only replaced once an iteration finishes, so the previous
+  // path stays available in the meantime.
+  if (m_dense_pathfinder) {
+    m_state = m_dense_pathfinder->run(max_expansions, m_path);
+    m_error = m_dense_pathfinder->m_error;
+    m_bound = m_dense_pathfinder->m_bound;
+    m_weight = m_dense_pathfinder->m_weight;
+    m_path_cost = m_dense_pathfinder->m_path_cost;
+  }
+  else {
+    m_state = m_map_pathfinder->run(max_expansions, m_path);
+    m_error = m_map_pathfinder->m_error;
+    m_bound = m_map_pathfinder->m_bound;
+    m_weight = m_map_pathfinder->m_weight;
+    m_path_cost = m_map_pathfinder->m_path_cost;
+  }
+
+  return m_state;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+search_state_t
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::state() const
+{
+  return m_state;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::error() const
+{
+  return m_error;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+std::deque<vector_t> const &
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::path() const
+{
+  return m_path;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+unit_t
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::path_cost() const
+{
+  return m_path_cost;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+double
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::bound() const
+{
+  return m_bound;
+}
+
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+double
+anytime_search<node_groupT, traversal_traitsT, heuristicT>::weight() const
+{
+  return m_weight;
 }
 
 
@@ -20,6 +20,8 @@
  **/
 
 #include <boost/concept_check.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/is_base_of.hpp>
 
 namespace cartograph {
 namespace pathfinding {
@@ -33,7 +35,7 @@ template <
   typename traversal_traitsT,
   typename heuristicT
 >
-struct HeuristicConcept
+struct PlainHeuristicConcept
 {
   void constraints()
   {
@@ -50,6 +52,59 @@ struct HeuristicConcept
 };
 
 
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+struct PreparedHeuristicConcept
+{
+  void constraints()
+  {
+    heuristicT h(heuristic);
+    h.prepare(group, coords, coords, traversal_traits);
+
+    const_constraints(h);
+  }
+
+
+  void const_constraints(heuristicT const & h)
+  {
+    unit_t u = h(coords);
+    boost::ignore_unused_variable_warning(u);
+  }
+
+  heuristicT const &    heuristic;
+  node_groupT const &   group;
+  vector_t const &      coords;
+  traversal_traitsT &   traversal_traits;
+};
+
+
+/**
+ * Heuristics derived from heuristics::prepared_heuristic_tag must satisfy
+ * PreparedHeuristicConcept, all others PlainHeuristicConcept.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+struct HeuristicConcept
+{
+  void constraints()
+  {
+    typedef typename boost::mpl::if_c<
+      boost::is_base_of<heuristics::prepared_heuristic_tag, heuristicT>::value,
+      PreparedHeuristicConcept<node_groupT, traversal_traitsT, heuristicT>,
+      PlainHeuristicConcept<node_groupT, traversal_traitsT, heuristicT>
+    >::type concept_t;
+
+    boost::function_requires<concept_t>();
+  }
+};
+
+
 /*****************************************************************************
  * TraversalTraitsConcept
  */
@@ -83,4 +138,34 @@ struct TraversalTraitsConcept
   directions_t const &  dir;
 };
 
+
+/*****************************************************************************
+ * CloneableTraversalTraitsConcept
+ */
+
+/**
+ * Traversal traits whose copies are used on several threads at once. Copies
+ * must not share any state that they modify. The node_group is shared, too;
+ * look nodes up with it's try_get_relative(), as it's function call operator
+ * modifies the node_group for empty positions.
+ **/
+template <
+    typename traversal_traitsT
+>
+struct CloneableTraversalTraitsConcept
+{
+  void constraints()
+  {
+    boost::function_requires<
+      TraversalTraitsConcept<traversal_traitsT>
+    >();
+
+    // Copies are handed to different threads.
+    traversal_traitsT copy(c_instance);
+    boost::ignore_unused_variable_warning(copy);
+  }
+
+  traversal_traitsT const & c_instance;
+};
+
 }}} // namespace cartograph::pathfinding::concepts
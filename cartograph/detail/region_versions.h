@@ -0,0 +1,175 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_DETAIL_REGION_VERSIONS_H
+#define CG_DETAIL_REGION_VERSIONS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <cartograph/types.h>
+#include <cartograph/detail/coords_hash.h>
+
+namespace cartograph {
+namespace detail {
+
+/**
+ * The version of each region changed since the last clear(), for
+ * node_group::region_version(); see there. Versions are kept in a hash table
+ * using linear probing, keyed on the region's coords_key().
+ *
+ * Regions whose coordinates don't pass coords_key_fits() may share a key, and
+ * then share a version. That only makes data derived from one of them look
+ * stale when the other changes.
+ *
+ * Consecutive changes tend to hit the same region, e.g. when loading a map,
+ * so the slot of the last region set is remembered.
+ **/
+class region_versions
+{
+public:
+  region_versions()
+    : m_size(0)
+    , m_last_key(0)
+    , m_last_slot(0)
+  {
+  }
+
+
+  /**
+   * Returns the version recorded for the region, or the given default if
+   * there is none.
+   **/
+  uint64_t
+  get(vector_t const & region, uint64_t const & default_version) const
+  {
+    if (m_slots.empty()) {
+      return default_version;
+    }
+
+    uint64_t key = coords_key(region);
+    std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = hash(key) & mask ; m_slots[i].m_version
+        ; i = (i + 1) & mask)
+    {
+      if (m_slots[i].m_key == key) {
+        return m_slots[i].m_version;
+      }
+    }
+    return default_version;
+  }
+
+
+  /**
+   * Records the version for the region; versions must not be zero.
+   **/
+  void
+  set(vector_t const & region, uint64_t const & version)
+  {
+    uint64_t key = coords_key(region);
+    if (m_size && key == m_last_key) {
+      m_slots[m_last_slot].m_version = version;
+      return;
+    }
+
+    // Keep the table at most half full, so probe sequences stay short.
+    if ((m_size + 1) * 2 > m_slots.size()) {
+      std::vector<version_slot> slots(std::max<std::size_t>(MIN_TABLE_SIZE,
+            m_slots.size() * 2));
+      for (std::size_t i = 0 ; i < m_slots.size() ; ++i) {
+        if (m_slots[i].m_version) {
+          slots[find_slot(slots, m_slots[i].m_key)] = m_slots[i];
+        }
+      }
+      m_slots.swap(slots);
+    }
+
+    std::size_t slot = find_slot(m_slots, key);
+    if (!m_slots[slot].m_version) {
+      m_slots[slot].m_key = key;
+      ++m_size;
+    }
+    m_slots[slot].m_version = version;
+
+    m_last_key = key;
+    m_last_slot = slot;
+  }
+
+
+  void
+  clear()
+  {
+    m_slots.clear();
+    m_size = 0;
+  }
+
+private:
+  enum
+  {
+    MIN_TABLE_SIZE = 16,
+  };
+
+  // Slots without a version are unused.
+  struct version_slot
+  {
+    version_slot()
+      : m_key(0)
+      , m_version(0)
+    {
+    }
+
+    uint64_t  m_key;
+    uint64_t  m_version;
+  };
+
+
+  static std::size_t
+  hash(uint64_t key)
+  {
+    return mix_coords_key(key);
+  }
+
+
+  // Returns the slot holding the key, or the unused slot it belongs in.
+  static std::size_t
+  find_slot(std::vector<version_slot> const & slots, uint64_t key)
+  {
+    std::size_t mask = slots.size() - 1;
+    std::size_t i = hash(key) & mask;
+    while (slots[i].m_version && slots[i].m_key != key) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+
+  std::vector<version_slot> m_slots;
+  std::size_t               m_size;
+
+  // Only valid while the table isn't empty.
+  uint64_t                  m_last_key;
+  std::size_t               m_last_slot;
+};
+
+}} // namespace cartograph::detail
+
+#endif // guard
@@ -0,0 +1,675 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_DETAIL_SEARCH_NODES_H
+#define CG_DETAIL_SEARCH_NODES_H
+
+#include <cassert>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/integer_traits.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <cartograph/types.h>
+
+namespace cartograph {
+namespace pathfinding {
+namespace detail {
+
+/**
+ * Search nodes are referred to by their index in the node_arena below.
+ **/
+typedef uint32_t node_index_t;
+static const node_index_t invalid_node_index
+  = boost::integer_traits<node_index_t>::const_max;
+
+/**
+ * Costs of nodes that can't be reached (yet), for searches that keep costs
+ * outside of search nodes.
+ **/
+static unit_t const infinite_cost = boost::integer_traits<unit_t>::const_max;
+
+
+/**
+ * Each node the pathfinder encounters is represented by a search_node_t. Once
+ * we've found one, we need it's g_cost, coordinates, parent - and for the open
+ * list implementations below, some bookkeeping information.
+ **/
+struct search_node_t
+{
+  vector_t      m_coords;
+  unit_t        m_g_cost;
+  unit_t        m_f_cost;
+  node_index_t  m_parent;
+
+  // True once the node has been moved to the closed list.
+  bool          m_closed;
+
+  // Position in a heap_open_list, and the order in which the node was last
+  // pushed or decreased. The latter breaks ties between nodes of the same
+  // f_cost in favour of the older node.
+  node_index_t  m_heap_index;
+  std::size_t   m_sequence;
+};
+
+
+/**
+ * The node_arena owns all search nodes for a query. Nodes are allocated from
+ * fixed-size blocks by bumping an index, so a query does not need to allocate
+ * memory per node, and all nodes are released in one go when the arena is
+ * cleared or destroyed. Blocks are never moved, so references to nodes stay
+ * valid until then.
+ **/
+class node_arena
+  : public boost::noncopyable
+{
+public:
+  node_arena()
+    : m_size(0)
+  {
+  }
+
+
+  ~node_arena()
+  {
+    for (block_list_t::iterator iter = m_blocks.begin()
+        ; iter != m_blocks.end() ; ++iter)
+    {
+      delete [] *iter;
+    }
+  }
+
+
+  node_index_t allocate(vector_t const & coords, unit_t const & g_cost,
+      unit_t const & f_cost, node_index_t const & parent)
+  {
+    assert(m_size < invalid_node_index);
+
+    if ((m_size >> BLOCK_BITS) >= m_blocks.size()) {
+      m_blocks.push_back(new search_node_t[BLOCK_SIZE]);
+    }
+
+    node_index_t index = m_size++;
+
+    search_node_t & node = (*this)[index];
+    node.m_coords = coords;
+    node.m_g_cost = g_cost;
+    node.m_f_cost = f_cost;
+    node.m_parent = parent;
+    node.m_closed = false;
+    node.m_heap_index = invalid_node_index;
+    node.m_sequence = 0;
+
+    return index;
+  }
+
+
+  inline search_node_t &
+  operator[](node_index_t const & index)
+  {
+    assert(index < m_size);
+    return m_blocks[index >> BLOCK_BITS][index & (BLOCK_SIZE - 1)];
+  }
+
+
+  inline search_node_t const &
+  operator[](node_index_t const & index) const
+  {
+    assert(index < m_size);
+    return m_blocks[index >> BLOCK_BITS][index & (BLOCK_SIZE - 1)];
+  }
+
+
+  std::size_t size() const
+  {
+    return m_size;
+  }
+
+
+  /**
+   * Forget all nodes, but keep the allocated blocks around for reuse.
+   **/
+  void clear()
+  {
+    m_size = 0;
+  }
+
+private:
+  enum {
+    BLOCK_BITS = 12,
+    BLOCK_SIZE = 1 << BLOCK_BITS
+  };
+
+  typedef std::vector<search_node_t *> block_list_t;
+  block_list_t  m_blocks;
+  node_index_t  m_size;
+};
+
+
+/**
+ * The open list is where we keep nodes we've seen, but not yet processed. All
+ * open list implementations are constructed from the node_arena the nodes
+ * live in, and provide the same interface:
+ *
+ *  - push() adds a new node.
+ *  - pop() removes and returns the node with the lowest f_cost; of several
+ *    nodes with the same f_cost, the one pushed (or decreased) first wins.
+ *  - decrease_key() lowers the f_cost of a node already on the open list.
+ *  - clear() removes all nodes.
+ *
+ * The heap_open_list below is the default; the multi_index_open_list is the
+ * original implementation, and is used instead if you define
+ * CG_MULTI_INDEX_OPEN_LIST.
+ **/
+
+
+/**
+ * Implements the open list as a d-ary heap, with each node's position in the
+ * heap stored in the node itself. That way decrease_key() does not need to
+ * search for the node, it just needs to sift it towards the root.
+ **/
+template <
+  std::size_t arityT = 4
+>
+class heap_open_list
+{
+public:
+  explicit heap_open_list(node_arena & arena)
+    : m_arena(arena)
+    , m_sequence(0)
+  {
+  }
+
+
+  bool empty() const
+  {
+    return m_heap.empty();
+  }
+
+
+  std::size_t size() const
+  {
+    return m_heap.size();
+  }
+
+
+  void push(node_index_t const & index)
+  {
+    m_arena[index].m_sequence = m_sequence++;
+    m_heap.push_back(index);
+    sift_up(m_heap.size() - 1);
+  }
+
+
+  node_index_t top() const
+  {
+    assert(!m_heap.empty());
+    return m_heap.front();
+  }
+
+
+  node_index_t pop()
+  {
+    assert(!m_heap.empty());
+
+    node_index_t ret = m_heap.front();
+    m_arena[ret].m_heap_index = invalid_node_index;
+
+    node_index_t last = m_heap.back();
+    m_heap.pop_back();
+    if (!m_heap.empty()) {
+      place(0, last);
+      sift_down(0);
+    }
+
+    return ret;
+  }
+
+
+  void decrease_key(node_index_t const & index, unit_t const & f_cost)
+  {
+    search_node_t & node = m_arena[index];
+    assert(f_cost <= node.m_f_cost);
+    assert(m_heap[node.m_heap_index] == index);
+
+    node.m_f_cost = f_cost;
+    node.m_sequence = m_sequence++;
+    sift_up(node.m_heap_index);
+  }
+
+
+  void clear()
+  {
+    m_heap.clear();
+    m_sequence = 0;
+  }
+
+
+private:
+
+  inline bool
+  less(node_index_t const & first, node_index_t const & second) const
+  {
+    search_node_t const & f = m_arena[first];
+    search_node_t const & s = m_arena[second];
+    if (f.m_f_cost == s.m_f_cost) {
+      return f.m_sequence < s.m_sequence;
+    }
+    return f.m_f_cost < s.m_f_cost;
+  }
+
+
+  inline void
+  place(std::size_t pos, node_index_t const & index)
+  {
+    m_heap[pos] = index;
+    m_arena[index].m_heap_index = pos;
+  }
+
+
+  void sift_up(std::size_t pos)
+  {
+    node_index_t index = m_heap[pos];
+    while (pos > 0) {
+      std::size_t parent = (pos - 1) / arityT;
+      if (!less(index, m_heap[parent])) {
+        break;
+      }
+      place(pos, m_heap[parent]);
+      pos = parent;
+    }
+    place(pos, index);
+  }
+
+
+  void sift_down(std::size_t pos)
+  {
+    node_index_t index = m_heap[pos];
+    std::size_t const size = m_heap.size();
+
+    do {
+      std::size_t first_child = (pos * arityT) + 1;
+      if (first_child >= size) {
+        break;
+      }
+
+      // Find the smallest child.
+      std::size_t last_child = std::min(first_child + arityT, size);
+      std::size_t best = first_child;
+      for (std::size_t child = first_child + 1 ; child < last_child ; ++child) {
+        if (less(m_heap[child], m_heap[best])) {
+          best = child;
+        }
+      }
+
+      if (!less(m_heap[best], index)) {
+        break;
+      }
+      place(pos, m_heap[best]);
+      pos = best;
+    } while (true);
+
+    place(pos, index);
+  }
+
+
+  node_arena &              m_arena;
+  std::vector<node_index_t> m_heap;
+  std::size_t               m_sequence;
+};
+
+
+
+/**
+ * The original open list implementation: a multi_index_container indexed both
+ * by the node and by it's f_cost. A cheaper path to a node on the open list
+ * means erasing and re-inserting the entry.
+ **/
+class multi_index_open_list
+{
+public:
+  explicit multi_index_open_list(node_arena & arena)
+    : m_arena(arena)
+  {
+  }
+
+
+  bool empty() const
+  {
+    return m_container.empty();
+  }
+
+
+  std::size_t size() const
+  {
+    return m_container.size();
+  }
+
+
+  void push(node_index_t const & index)
+  {
+    m_container.insert(ol_entry_t(index, m_arena[index].m_f_cost));
+  }
+
+
+  node_index_t top() const
+  {
+    assert(!m_container.empty());
+    return m_container.get<f_cost_index>().begin()->m_index;
+  }
+
+
+  node_index_t pop()
+  {
+    assert(!m_container.empty());
+
+    f_cost_index_t & ol_f_cost_index = m_container.get<f_cost_index>();
+    f_cost_index_t::iterator f_iter = ol_f_cost_index.begin();
+
+    node_index_t ret = f_iter->m_index;
+    ol_f_cost_index.erase(f_iter);
+    return ret;
+  }
+
+
+  void decrease_key(node_index_t const & index, unit_t const & f_cost)
+  {
+    assert(f_cost <= m_arena[index].m_f_cost);
+
+    node_index_index_t & ol_node_index = m_container.get<node_index>();
+    node_index_index_t::iterator n_iter = ol_node_index.find(index);
+    assert(n_iter != ol_node_index.end());
+
+    ol_node_index.erase(n_iter);
+    m_arena[index].m_f_cost = f_cost;
+    m_container.insert(ol_entry_t(index, f_cost));
+  }
+
+
+  void clear()
+  {
+    m_container.clear();
+  }
+
+private:
+  struct ol_entry_t
+  {
+    ol_entry_t(node_index_t const & index, unit_t const & f_cost)
+      : m_index(index)
+      , m_f_cost(f_cost)
+    {
+    }
+
+    node_index_t  m_index;
+    unit_t        m_f_cost;
+  };
+
+  struct node_index {};
+  struct f_cost_index {};
+  typedef boost::multi_index_container<
+    ol_entry_t,
+    boost::multi_index::indexed_by<
+      boost::multi_index::ordered_unique<
+        boost::multi_index::tag<node_index>,
+        boost::multi_index::member<ol_entry_t, node_index_t, &ol_entry_t::m_index>
+      >,
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<f_cost_index>,
+        boost::multi_index::member<ol_entry_t, unit_t, &ol_entry_t::m_f_cost>
+      >
+    >
+  > container_t;
+
+  typedef container_t::index<node_index>::type node_index_index_t;
+  typedef container_t::index<f_cost_index>::type f_cost_index_t;
+
+  node_arena &  m_arena;
+  container_t   m_container;
+};
+
+
+#if defined(CG_MULTI_INDEX_OPEN_LIST)
+typedef multi_index_open_list open_list_t;
+#else
+typedef heap_open_list<> open_list_t;
+#endif
+
+
+/**
+ * The pathfinder needs to look up all nodes it has encountered so far, whether
+ * they're on the open or closed list, by their coordinates. Node lookup
+ * implementations provide the following interface:
+ *
+ *  - reset() forgets all nodes, and prepares for a search within the given
+ *    bounds (see node_group::min_coords() and max_coords()).
+ *  - find() returns the index of the node at the given coordinates, or
+ *    invalid_node_index if there is none.
+ *  - insert() records the node index for the given coordinates.
+ **/
+
+
+/**
+ * Node lookup via a std::map; works for any coordinates.
+ **/
+class map_node_lookup
+{
+public:
+  void reset(vector_t const & /* min */, vector_t const & /* max */)
+  {
+    m_nodes.clear();
+  }
+
+
+  inline node_index_t
+  find(vector_t const & coords) const
+  {
+    node_map_t::const_iterator iter = m_nodes.find(coords);
+    if (iter == m_nodes.end()) {
+      return invalid_node_index;
+    }
+    return iter->second;
+  }
+
+
+  inline void
+  insert(vector_t const & coords, node_index_t const & index)
+  {
+    m_nodes[coords] = index;
+  }
+
+private:
+  typedef std::map<vector_t, node_index_t> node_map_t;
+  node_map_t  m_nodes;
+};
+
+
+
+/**
+ * Node lookup via a flat array with one cell per position within the bounds
+ * passed to reset(). Each cell is stamped with the generation of the search
+ * that wrote it, so reset() does not need to clear the array; bumping the
+ * generation invalidates all cells at once.
+ *
+ * Coordinates outside the bounds are never found, and must not be inserted.
+ **/
+class dense_node_lookup
+{
+public:
+  dense_node_lookup()
+    : m_width(0)
+    , m_height(0)
+    , m_generation(0)
+  {
+  }
+
+
+  /**
+   * Returns true if a dense_node_lookup is a good choice for searching a
+   * node_group with the given bounds and number of nodes, starting at the
+   * given coordinates.
+   **/
+  static bool
+  suitable(vector_t const & min, vector_t const & max, std::size_t node_count,
+      vector_t const & start)
+  {
+    if (min == invalid_vector || max == invalid_vector) {
+      return false;
+    }
+
+    if (start.m_x < min.m_x || start.m_x >= max.m_x
+        || start.m_y < min.m_y || start.m_y >= max.m_y)
+    {
+      return false;
+    }
+
+    // Don't waste memory on sparsely populated groups; tile traits such as
+    // hexagonal_tile_traits leave half of the positions invalid, so a little
+    // slack is required.
+    uint64_t width = max.m_x - min.m_x;
+    uint64_t height = max.m_y - min.m_y;
+    if (width > MAX_CELLS || height > MAX_CELLS) {
+      return false;
+    }
+    uint64_t cells = width * height;
+    return (cells <= MAX_CELLS && cells <= (uint64_t(node_count) + 1) * 4);
+  }
+
+
+  void reset(vector_t const & min, vector_t const & max)
+  {
+    assert(max.m_x >= min.m_x && max.m_y >= min.m_y);
+
+    m_min = min;
+    m_width = max.m_x - min.m_x;
+    m_height = max.m_y - min.m_y;
+
+    std::size_t cells = std::size_t(m_width * m_height);
+    if (m_cells.size() < cells) {
+      m_cells.resize(cells);
+    }
+
+    ++m_generation;
+    if (0 == m_generation) {
+      // Wrapped around; stale stamps could now match, so clear them all.
+      std::fill(m_cells.begin(), m_cells.end(), cell_t());
+      m_generation = 1;
+    }
+  }
+
+
+  inline node_index_t
+  find(vector_t const & coords) const
+  {
+    unit_t x = coords.m_x - m_min.m_x;
+    unit_t y = coords.m_y - m_min.m_y;
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+      return invalid_node_index;
+    }
+
+    cell_t const & cell = m_cells[std::size_t((y * m_width) + x)];
+    if (cell.m_generation != m_generation) {
+      return invalid_node_index;
+    }
+    return cell.m_index;
+  }
+
+
+  inline void
+  insert(vector_t const & coords, node_index_t const & index)
+  {
+    unit_t x = coords.m_x - m_min.m_x;
+    unit_t y = coords.m_y - m_min.m_y;
+    assert(x >= 0 && x < m_width && y >= 0 && y < m_height);
+
+    cell_t & cell = m_cells[std::size_t((y * m_width) + x)];
+    cell.m_generation = m_generation;
+    cell.m_index = index;
+  }
+
+private:
+  // Upper limit for the number of cells we're willing to allocate.
+  static const uint64_t MAX_CELLS = 1 << 26;
+
+  struct cell_t
+  {
+    cell_t()
+      : m_generation(0)
+      , m_index(invalid_node_index)
+    {
+    }
+
+    uint32_t      m_generation;
+    node_index_t  m_index;
+  };
+
+  std::vector<cell_t> m_cells;
+
+  vector_t  m_min;
+  unit_t    m_width;
+  unit_t    m_height;
+  uint32_t  m_generation;
+};
+
+
+
+/**
+ * Bundles everything a search needs to keep track of nodes, so that it can be
+ * kept around and reused between searches; see search_context in
+ * pathfinding.h.
+ **/
+struct search_workspace
+  : public boost::noncopyable
+{
+  search_workspace()
+    : m_open_list(m_arena)
+  {
+  }
+
+
+  /**
+   * Forget all nodes from a previous search. The node lookups are reset by the
+   * search itself, as only it knows the bounds to search in.
+   **/
+  void reset()
+  {
+    m_open_list.clear();
+    m_arena.clear();
+  }
+
+
+  // Declared before the open list, which refers to it.
+  node_arena          m_arena;
+  open_list_t         m_open_list;
+
+  map_node_lookup     m_map_lookup;
+  dense_node_lookup   m_dense_lookup;
+};
+
+
+}}} // namespace cartograph::pathfinding::detail
+
+#endif // guard
@@ -84,6 +84,9 @@ CG_ERROR_START
 CG_ERROR(CG_OK,
     0,
     "No error")
+CG_ERROR(CG_UNEXPECTED,
+    1,
+    "An unexpected exception was thrown")
 
 CG_ERROR(CG_INVALID_COORDS,
     50,
@@ -91,6 +94,19 @@ CG_ERROR(CG_INVALID_COORDS,
 CG_ERROR(CG_INVALID_DIR,
     51,
     "Invalid direction provided")
+CG_ERROR(CG_INVALID_VALUE,
+    52,
+    "Invalid value provided")
+CG_ERROR(CG_IO_ERROR,
+    53,
+    "Could not read or write file")
+
+CG_ERROR(CG_NO_PATH,
+    100,
+    "No path exists between the given nodes")
+CG_ERROR(CG_BUDGET_EXCEEDED,
+    101,
+    "Search limits were exceeded before a path was found")
 
 CG_ERROR_END
 
@@ -0,0 +1,147 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_FLOW_FIELD_H
+#define CG_FLOW_FIELD_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * A flow_field holds, for every node of a node_group, the costs of the
+ * cheapest path to a single goal node, and the direction in which that path
+ * leaves the node. When many units head for the same goal, compute one
+ * flow_field instead of running a_star() for each unit; each unit then just
+ * follows the directions, which takes constant time per step.
+ *
+ * The flow_field is computed with a single run of Dijkstra's algorithm that
+ * starts at the goal and follows moves backwards, honouring the traversal
+ * traits' is_impassable() and traversal_cost(). It works with all tile traits.
+ *
+ * The flow_field refers to the node_group and traversal traits passed to it's
+ * constructor for as long as it exists, and requires memory for the costs and
+ * direction of each position within the node_group's bounds. When either
+ * changes, call invalidate() for each changed node; update() then recomputes
+ * only the nodes whose path to the goal is affected by the change.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class flow_field
+  : private boost::noncopyable
+{
+public:
+  flow_field(node_groupT const & group, traversal_traitsT & traversal_traits);
+
+  /**
+   * Computes the flow_field for the given goal.
+   *
+   * @return CG_OK on success, or CG_INVALID_COORDS if the goal is not part of
+   *    the node_group.
+   **/
+  error_t compute(vector_t const & goal);
+
+  /**
+   * Marks the given node, or all nodes within the given bounds (max being
+   * exclusive, as with node_group::max_coords()), as changed. Call this
+   * whenever a node is added, removed or modified in ways that affect
+   * pathfinding.
+   **/
+  void invalidate(vector_t const & coords);
+  void invalidate(vector_t const & min, vector_t const & max);
+
+  /**
+   * Recomputes the parts of the flow_field affected by the nodes marked via
+   * invalidate() above. If the node_group has grown beyond it's previous
+   * bounds, the entire flow_field is recomputed.
+   **/
+  void update();
+
+  /**
+   * Returns the goal passed to compute(), or invalid_vector if compute() was
+   * not called yet.
+   **/
+  vector_t goal() const;
+
+  /**
+   * Returns the costs of the cheapest path from the given node to the goal,
+   * or invalid_unit if there is no such path.
+   **/
+  unit_t cost(vector_t const & coords) const;
+
+  /**
+   * Returns the direction in which to move from the given node to get closer
+   * to the goal, or DIR_END if there is no path to the goal, or the node is
+   * the goal.
+   **/
+  directions_t direction(vector_t const & coords) const;
+
+  /**
+   * Returns the node to move to from the given node to get closer to the goal,
+   * or invalid_vector if direction() returns DIR_END.
+   **/
+  vector_t next(vector_t const & coords) const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  void reset();
+  void mark_affected(std::vector<bool> & affected) const;
+  void seed(std::size_t index, vector_t const & coords);
+  void push(vector_t const & coords, unit_t const & cost);
+  void propagate();
+
+  std::size_t index_of(vector_t const & coords) const;
+  vector_t coords_of(std::size_t index) const;
+
+  node_groupT const &       m_group;
+  traversal_traitsT &       m_traversal_traits;
+  join_t                    m_join_types;
+
+  vector_t                  m_goal;
+
+  // Bounds of the node_group when the flow_field was computed; see
+  // node_group::min_coords() and max_coords().
+  vector_t                  m_min;
+  vector_t                  m_max;
+
+  // Costs and direction for each position within the bounds.
+  std::vector<unit_t>       m_costs;
+  std::vector<directions_t> m_directions;
+
+  // Nodes marked by invalidate() since the last update.
+  std::vector<vector_t>     m_dirty;
+
+  detail::search_workspace  m_workspace;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/flow_field.tcc>
+
+#endif // guard
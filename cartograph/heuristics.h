@@ -106,6 +106,223 @@ diagonal_tiebreaker(node_groupT const & group, vector_t const & start,
     vector_t const & current, vector_t const & end,
     traversal_traitsT & traversal_traits);
 
+
+namespace detail {
+
+// See detail/heuristics.tcc
+template <
+  typename tile_traitsT,
+  typename node_groupT,
+  typename traversal_traitsT
+>
+struct diagonal;
+
+} // namespace detail
+
+
+/**
+ * Prepared heuristics
+ *
+ * The functions above are called with the start and end node for every node
+ * considered, and so recompute anything that depends only on those each time.
+ * A prepared heuristic is a function object that derives from
+ * prepared_heuristic_tag and instead provides
+ *
+ *   void prepare(node_groupT const & group, vector_t const & start,
+ *       vector_t const & end, traversal_traitsT & traversal_traits);
+ *   unit_t operator()(vector_t const & current) const;
+ *
+ * The pathfinding functions call prepare() once per search on their own copy
+ * of the heuristic, and from then on only pass the current node, e.g.
+ *
+ *   a_star(result, group, start, end, traits,
+ *       diagonal_heuristic<map_t, traits_t>());
+ **/
+struct prepared_heuristic_tag
+{
+};
+
+
+/**
+ * Base class for prepared heuristics; additionally provides the call operator
+ * the functions above have, so that prepared heuristics can still be used
+ * where a heuristic_function is expected. That operator prepares a copy of the
+ * heuristic for each call, so it's no faster than the plain functions.
+ **/
+template <
+  typename derivedT,
+  typename node_groupT,
+  typename traversal_traitsT
+>
+struct prepared_heuristic
+  : public prepared_heuristic_tag
+{
+  unit_t
+  operator()(node_groupT const & group, vector_t const & start,
+      vector_t const & current, vector_t const & end,
+      traversal_traitsT & traversal_traits) const;
+};
+
+
+/**
+ * Prepared versions of the heuristics functions above; the same restrictions
+ * apply.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class dijkstra_heuristic
+  : public prepared_heuristic<
+      dijkstra_heuristic<node_groupT, traversal_traitsT>,
+      node_groupT,
+      traversal_traitsT
+    >
+{
+public:
+  using prepared_heuristic<
+    dijkstra_heuristic<node_groupT, traversal_traitsT>,
+    node_groupT,
+    traversal_traitsT
+  >::operator();
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits);
+
+  unit_t operator()(vector_t const & current) const;
+};
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class manhattan_heuristic
+  : public prepared_heuristic<
+      manhattan_heuristic<node_groupT, traversal_traitsT>,
+      node_groupT,
+      traversal_traitsT
+    >
+{
+public:
+  using prepared_heuristic<
+    manhattan_heuristic<node_groupT, traversal_traitsT>,
+    node_groupT,
+    traversal_traitsT
+  >::operator();
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits);
+
+  unit_t operator()(vector_t const & current) const;
+
+private:
+  vector_t  m_end;
+  unit_t    m_average_cost;
+};
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class diagonal_heuristic
+  : public prepared_heuristic<
+      diagonal_heuristic<node_groupT, traversal_traitsT>,
+      node_groupT,
+      traversal_traitsT
+    >
+{
+public:
+  using prepared_heuristic<
+    diagonal_heuristic<node_groupT, traversal_traitsT>,
+    node_groupT,
+    traversal_traitsT
+  >::operator();
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits);
+
+  unit_t operator()(vector_t const & current) const;
+
+private:
+  // See detail/heuristics.tcc
+  typedef detail::diagonal<
+    typename node_groupT::tile_traits_t,
+    node_groupT,
+    traversal_traitsT
+  > estimate_t;
+
+  vector_t    m_end;
+  estimate_t  m_estimate;
+};
+
+
+/**
+ * Adds the line-of-sight tiebreaker to any other prepared heuristic.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class tiebreaker_heuristic
+  : public prepared_heuristic<
+      tiebreaker_heuristic<node_groupT, traversal_traitsT, heuristicT>,
+      node_groupT,
+      traversal_traitsT
+    >
+{
+public:
+  using prepared_heuristic<
+    tiebreaker_heuristic<node_groupT, traversal_traitsT, heuristicT>,
+    node_groupT,
+    traversal_traitsT
+  >::operator();
+
+  explicit tiebreaker_heuristic(heuristicT const & heuristic = heuristicT());
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits);
+
+  unit_t operator()(vector_t const & current) const;
+
+private:
+  heuristicT  m_heuristic;
+  vector_t    m_start;
+  vector_t    m_end;
+  unit_t      m_total;
+  unit_t      m_average_cost;
+};
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class manhattan_tiebreaker_heuristic
+  : public tiebreaker_heuristic<
+      node_groupT,
+      traversal_traitsT,
+      manhattan_heuristic<node_groupT, traversal_traitsT>
+    >
+{
+};
+
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class diagonal_tiebreaker_heuristic
+  : public tiebreaker_heuristic<
+      node_groupT,
+      traversal_traitsT,
+      diagonal_heuristic<node_groupT, traversal_traitsT>
+    >
+{
+};
+
 }}} // namespace cartograph::pathfinding::heuristics
 
 #include <cartograph/detail/heuristics.tcc>
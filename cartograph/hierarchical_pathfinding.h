@@ -0,0 +1,225 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_HIERARCHICAL_PATHFINDING_H
+#define CG_HIERARCHICAL_PATHFINDING_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * The hierarchical_map implements hierarchical pathfinding (HPA*) on top of a
+ * node_group. The group is partitioned into square clusters of a fixed size.
+ * Wherever two clusters border each other, a few nodes on either side of the
+ * border are picked as entrances. Together with the costs of moving between
+ * entrances of the same cluster - determined by A* searches that are
+ * restricted to the cluster - these form an abstract graph that is much
+ * smaller than the node_group itself.
+ *
+ * Finding a path then means finding a path through the abstract graph first,
+ * which yields a list of waypoints. Each pair of consecutive waypoints lies
+ * within the same cluster, or on either side of a cluster border; refining such
+ * a segment into a path through the node_group is cheap, and can be done
+ * lazily, e.g. only once a unit following the path gets close to the segment.
+ *
+ * The paths found are not necessarily the shortest paths, but usually come
+ * close.
+ *
+ * The hierarchical_map works with all tile traits. It refers to the node_group
+ * and traversal traits passed to it's constructor for as long as it exists.
+ * When either changes, call invalidate() for each changed node, and the
+ * clusters containing those nodes are rebuilt before the next search.
+ *
+ * The heuristic is prepared once for the search between clusters, and once
+ * for each search within a cluster (see heuristic_function).
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class hierarchical_map
+  : private boost::noncopyable
+{
+public:
+  /**
+   * Builds the abstract graph for the given node_group; see a_star() for
+   * details on the parameters.
+   *
+   * @param cluster_size Width and height of each cluster.
+   *
+   * @throws CG_INVALID_VALUE if cluster_size is less than 2.
+   **/
+  hierarchical_map(node_groupT const & group,
+      traversal_traitsT & traversal_traits, heuristicT const & heuristic,
+      unit_t const & cluster_size = 16);
+
+  /**
+   * Marks the cluster containing the given node as needing to be rebuilt.
+   * Call this whenever a node is added, removed or modified in ways that
+   * affect pathfinding.
+   **/
+  void invalidate(vector_t const & coords);
+
+  /**
+   * Rebuilds all clusters marked by invalidate() above. Searches do this
+   * automatically, so you only need to call this function if you'd rather do
+   * the work at a time of your choosing.
+   **/
+  void update();
+
+  /**
+   * Rebuilds the entire abstract graph, e.g. after the node_group has grown
+   * beyond it's previous bounds.
+   **/
+  void rebuild();
+
+  /**
+   * Finds a path through the abstract graph.
+   *
+   * @param waypoints Filled with the start node, the entrances to traverse and
+   *    the end node, in that order.
+   * @param start Start position to find path to...
+   * @param end ... here.
+   *
+   * @return CG_OK if a path was found, CG_INVALID_COORDS if start or end are
+   *    not valid coordinates, or CG_NO_PATH if no path was found.
+   **/
+  error_t find_abstract_path(std::deque<vector_t> & waypoints,
+      vector_t const & start, vector_t const & end);
+
+  /**
+   * Refines a segment between two consecutive waypoints returned by
+   * find_abstract_path() into a path through the node_group, and appends
+   * that path to result. If result already ends with the from node, it's not
+   * appended twice.
+   *
+   * @return CG_OK on success, CG_INVALID_COORDS if from and to are not in the
+   *    same or in neighbouring clusters, or CG_NO_PATH if no path was found -
+   *    e.g. because the node_group was changed since the waypoints were found.
+   **/
+  error_t refine_segment(std::deque<vector_t> & result, vector_t const & from,
+      vector_t const & to);
+
+  /**
+   * Combines find_abstract_path() and refine_segment() to find the complete
+   * path from start to end; the result is comparable to that of a_star().
+   **/
+  error_t find_path(std::deque<vector_t> & result, vector_t const & start,
+      vector_t const & end);
+
+  /**
+   * Returns the coordinates of the cluster containing the given node; cluster
+   * (0, 0) contains node (0, 0).
+   **/
+  vector_t cluster_of(vector_t const & coords) const;
+
+  /**
+   * Returns the number of entrance nodes in the abstract graph.
+   **/
+  std::size_t abstract_node_count() const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  struct edge_t
+  {
+    edge_t(vector_t const & to, unit_t const & cost);
+
+    vector_t  m_to;
+    unit_t    m_cost;
+  };
+  typedef std::vector<edge_t> edge_list_t;
+
+  struct abstract_node_t
+  {
+    abstract_node_t();
+
+    // Number of transitions this node is part of.
+    std::size_t m_refcount;
+    // Edges to entrances in neighbouring clusters, and within the cluster.
+    edge_list_t m_inter;
+    edge_list_t m_intra;
+  };
+  typedef std::map<vector_t, abstract_node_t> node_map_t;
+
+  struct cluster_t
+  {
+    cluster_t();
+
+    bool                m_dirty;
+    std::set<vector_t>  m_nodes;
+  };
+  typedef std::map<vector_t, cluster_t> cluster_map_t;
+
+  // A transition is a pair of neighbouring nodes on either side of a border;
+  // borders are identified by the two clusters' coordinates, the lesser
+  // first. m_first of each transition lies in the first cluster.
+  struct transition_t
+  {
+    vector_t  m_first;
+    vector_t  m_second;
+  };
+  typedef std::vector<transition_t> transition_list_t;
+  typedef std::pair<vector_t, vector_t> border_t;
+  typedef std::map<border_t, transition_list_t> border_map_t;
+
+  typedef std::map<vector_t, edge_list_t> extra_edges_t;
+
+  void remove_border(border_t const & border, std::set<vector_t> & changed);
+  void build_border(border_t const & border, std::set<vector_t> & changed);
+  void add_entrance(vector_t const & coords, std::set<vector_t> & changed);
+  void build_intra_edges(vector_t const & cluster);
+
+  void connect(vector_t const & coords, bool outgoing,
+      extra_edges_t & extra);
+  error_t search_in_cluster(std::deque<vector_t> & result,
+      vector_t const & cluster, vector_t const & from, vector_t const & to);
+  bool path_cost(std::deque<vector_t> const & path, unit_t & cost);
+  bool step_cost(vector_t const & from, vector_t const & to, unit_t & cost);
+  bool is_neighbour(vector_t const & first, vector_t const & second);
+
+  node_groupT const & m_group;
+  traversal_traitsT & m_traversal_traits;
+  heuristicT          m_heuristic;
+  unit_t              m_cluster_size;
+
+  cluster_map_t       m_clusters;
+  node_map_t          m_nodes;
+  border_map_t        m_borders;
+
+  search_context      m_context;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/hierarchical_pathfinding.tcc>
+
+#endif // guard
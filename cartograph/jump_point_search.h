@@ -0,0 +1,88 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_JUMP_POINT_SEARCH_H
+#define CG_JUMP_POINT_SEARCH_H
+
+#include <cartograph/pathfinding.h>
+#include <cartograph/traversal_traits.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * Implements Jump Point Search, a variant of A* for rectangular tiles with
+ * uniform traversal costs. Of all the paths of equal costs between two nodes,
+ * Jump Point Search considers only one; instead of adding every neighbour to
+ * the open list, it follows each direction until it reaches a node at which
+ * the path might have to turn, and adds only that node - a jump point. On maps
+ * with large open areas, that processes far fewer nodes than a_star().
+ *
+ * The restrictions are:
+ *  - The node_group must use rectangular_tile_traits.
+ *  - The traversal traits must declare uniform costs by specializing
+ *    has_uniform_costs (see traversal_traits.h). The costs for edge and corner
+ *    neighbours are each taken from a single call to traversal_cost().
+ *  - The traversal traits must permit both edge and corner neighbours. If
+ *    they don't, this function falls back to a_star().
+ *
+ * Moving diagonally past an impassable node is permitted, just as in a_star().
+ *
+ * Parameters and return values are the same as for a_star(), except for:
+ *
+ * @param full_path If true, the result contains every node on the path, just
+ *    as with a_star(). If false, the result contains only the start node, the
+ *    jump points on the path and the end node; consecutive nodes in the result
+ *    then lie on a straight or diagonal line.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+jump_point_search(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, bool full_path = true);
+
+
+/**
+ * Same as above, but keeps the memory used for the search in the given
+ * search_context for reuse by subsequent calls.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+jump_point_search(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context,
+    bool full_path = true);
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/jump_point_search.tcc>
+
+#endif // guard
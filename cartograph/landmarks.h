@@ -0,0 +1,238 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_LANDMARKS_H
+#define CG_LANDMARKS_H
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * The landmark_table holds the exact costs of the cheapest paths from and to a
+ * small number of landmark nodes for every node of a node_group. With those,
+ * the landmark_heuristic below can estimate path costs via the triangle
+ * inequality (this is known as ALT: A*, landmarks, triangle inequality), which
+ * unlike the heuristics in heuristics.h takes obstacles into account. On maps
+ * with many obstacles, A* then considers far fewer nodes.
+ *
+ * Computing the tables takes two searches per landmark over the entire
+ * node_group, which are spread over a number of threads. For large maps that
+ * takes a while, so the tables can be saved to and loaded from a file.
+ *
+ * The tables require two unit_t per landmark for each position within the
+ * node_group's bounds. They refer to the node_group passed to the constructor,
+ * and describe the node_group and traversal traits at the time they were
+ * computed. If either changes such that paths become cheaper, the
+ * landmark_heuristic may overestimate, so compute the tables again; changes
+ * that only make paths more expensive are harmless.
+ *
+ * The tables only count moves the traversal traits allow, but a_star() never
+ * checks the move into the end node. If the end node can't be reached or left
+ * for some landmark, the landmark_heuristic estimates zero for all nodes. If
+ * it can only be entered from some directions, the landmark_heuristic may
+ * overestimate for it as well.
+ *
+ * Computing the tables requires linking against boost_thread.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class landmark_table
+  : private boost::noncopyable
+{
+public:
+  /**
+   * Creates an empty table; use compute() or load() to fill it.
+   **/
+  explicit landmark_table(node_groupT const & group);
+
+  /**
+   * Picks num_landmarks landmarks near the edges of the node_group, spread
+   * evenly around it's center, and computes the tables for them. Fewer
+   * landmarks may be picked if the node_group is oddly shaped.
+   *
+   * Each thread uses it's own copy of the traversal traits, so the traversal
+   * traits must satisfy the CloneableTraversalTraitsConcept, and should look
+   * nodes up with the node_group's try_get_relative(); see batch_pathfinder.
+   *
+   * @param num_threads Number of threads to use; if zero, one thread per CPU
+   *    core is used.
+   *
+   * @return CG_OK on success, or CG_INVALID_VALUE if num_landmarks is zero or
+   *    the node_group contains no suitable nodes.
+   **/
+  error_t compute(traversal_traitsT const & traversal_traits,
+      std::size_t num_landmarks, std::size_t num_threads = 0);
+
+  /**
+   * Same as above, but with the given landmarks.
+   *
+   * @return CG_OK on success, CG_INVALID_VALUE if landmarks is empty, or
+   *    CG_INVALID_COORDS if any landmark is not part of the node_group.
+   **/
+  error_t compute(traversal_traitsT const & traversal_traits,
+      std::vector<vector_t> const & landmarks, std::size_t num_threads = 0);
+
+  /**
+   * Saves the tables to the given file. The file can only be loaded on
+   * platforms with the same byte order and unit_t size.
+   *
+   * @return CG_OK on success, or CG_IO_ERROR if the file could not be written.
+   **/
+  error_t save(std::string const & filename) const;
+
+  /**
+   * Loads tables saved with save() above. The node_group's bounds must be the
+   * same as when the tables were computed. If loading fails, the table is left
+   * unchanged.
+   *
+   * @return CG_OK on success, CG_IO_ERROR if the file could not be read, or
+   *    CG_INVALID_VALUE if it does not contain tables for this node_group.
+   **/
+  error_t load(std::string const & filename);
+
+  /**
+   * Returns the landmarks, in the order in which they're stored in the tables.
+   **/
+  std::vector<vector_t> const & landmarks() const;
+
+  /**
+   * Returns the costs of the cheapest path from the given landmark to the given
+   * node, or from the node to the landmark respectively. Returns invalid_unit
+   * if there is no such path, or the node is not covered by the tables.
+   **/
+  unit_t cost_from(std::size_t landmark, vector_t const & coords) const;
+  unit_t cost_to(std::size_t landmark, vector_t const & coords) const;
+
+  /**
+   * Returns the costs for all landmarks in the order of landmarks() for the
+   * given node, or a null pointer if the node is not covered by the tables.
+   * Intended for the landmark_heuristic, which needs them for each node it's
+   * called for.
+   **/
+  unit_t const * costs_from(vector_t const & coords) const;
+  unit_t const * costs_to(vector_t const & coords) const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+
+  // State shared by the threads computing the tables.
+  struct build_state
+  {
+    build_state();
+
+    // The next search to run; searches with odd numbers compute costs to a
+    // landmark, the others costs from a landmark.
+    std::size_t   m_next;
+    boost::mutex  m_mutex;
+  };
+
+  void pick_landmarks(traversal_traitsT & traversal_traits,
+      std::size_t num_landmarks, std::vector<vector_t> & landmarks) const;
+  bool is_enterable(traversal_traitsT & traversal_traits,
+      join_t const & join_types, vector_t const & coords) const;
+
+  void build(traversal_traitsT traversal_traits, build_state & state);
+  void sweep(traversal_traitsT & traversal_traits,
+      detail::search_workspace & workspace, std::size_t landmark,
+      bool reverse);
+
+  std::size_t index_of(vector_t const & coords) const;
+
+  node_groupT const &   m_group;
+
+  std::vector<vector_t> m_landmarks;
+
+  // Bounds of the node_group when the tables were computed; see
+  // node_group::min_coords() and max_coords().
+  vector_t              m_min;
+  vector_t              m_max;
+
+  // For each position within the bounds, the costs for each landmark.
+  std::vector<unit_t>   m_from;
+  std::vector<unit_t>   m_to;
+};
+
+
+
+namespace heuristics {
+
+/**
+ * The ALT heuristic, using a landmark_table (see above) computed for the same
+ * node_group and traversal traits. The table must outlive the heuristic.
+ *
+ * For any landmark L, the costs of the cheapest path from a node to the end
+ * node can't be lower than cost(L, end) - cost(L, node), nor lower than
+ * cost(node, L) - cost(end, L); the heuristic uses the highest such bound.
+ * Nodes not covered by the table are estimated at zero, as are all nodes if
+ * the table has no costs for the end node; see landmark_table.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class landmark_heuristic
+  : public prepared_heuristic<
+      landmark_heuristic<node_groupT, traversal_traitsT>,
+      node_groupT,
+      traversal_traitsT
+    >
+{
+public:
+  using prepared_heuristic<
+    landmark_heuristic<node_groupT, traversal_traitsT>,
+    node_groupT,
+    traversal_traitsT
+  >::operator();
+
+  explicit landmark_heuristic(
+      landmark_table<node_groupT, traversal_traitsT> const & table);
+
+  void prepare(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits);
+
+  unit_t operator()(vector_t const & current) const;
+
+private:
+  landmark_table<node_groupT, traversal_traitsT> const *  m_table;
+
+  // The end node's costs from and to each landmark; empty if any are
+  // missing.
+  std::vector<unit_t> m_end_from;
+  std::vector<unit_t> m_end_to;
+};
+
+} // namespace heuristics
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/landmarks.tcc>
+
+#endif // guard
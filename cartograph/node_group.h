@@ -29,6 +29,9 @@
 
 #include <cartograph/types.h>
 #include <cartograph/tile_traits.h>
+#include <cartograph/node_storage.h>
+#include <cartograph/detail/coords_bounds.h>
+#include <cartograph/detail/region_versions.h>
 
 #ifndef CG_DISABLE_CONCEPT_CHECKS
 // Include concepts
@@ -102,7 +105,10 @@ template <
   typename tile_traitsT,
   // ID generator, defaulting to the simple_id_generator above. Must conform to
   // the IDGeneratorConcept in node_group_concepts.
-  typename id_generatorT = simple_id_generator
+  typename id_generatorT = simple_id_generator,
+  // Storage policy, defaulting to map_storage. Predefined policies are located
+  // in cartograph/node_storage.h.
+  typename storageT = map_storage
 >
 class node_group
 {
@@ -123,11 +129,25 @@ public:
   // relocated.
   typedef typename id_generatorT::node_id_t node_id_t;
 
+  // See version() below.
+  typedef uint64_t version_t;
+
+  // Regions are squares of REGION_SIZE by REGION_SIZE positions.
+  enum
+  {
+    REGION_BITS = 4,
+    REGION_SIZE = 1 << REGION_BITS,
+  };
+
   /**
    * The node class represents each position in the node_group. Technically, a
    * node instance is only a facade for a node_group-internal data structure,
    * which means that all node instances that refer to the same node id
    * reference the exact same node, not copies of each other.
+   *
+   * Node instances remember where the node's data was last found, so that
+   * dereferencing them again is cheap as long as the node_group's version()
+   * stays the same.
    **/
   class node
   {
@@ -217,12 +237,21 @@ public:
     node(node_group * group, node_id_t const & id,
         vector_t const & coords);
 
+    // Returns the node's data, looking it up only if the node_group changed
+    // since it was last looked up.
+    node_dataT * lookup() const;
+
     // Owning node_group
     node_group *  m_group;
     // Id this node represents.
     node_id_t     m_id;
     // Coordinates of this node.
     vector_t      m_coords;
+
+    // The node's data as last looked up, and the node_group's version at the
+    // time; no version is ever ~version_t(0).
+    mutable node_dataT *  m_data;
+    mutable version_t     m_data_version;
   };
 
 
@@ -262,6 +291,29 @@ public:
   bool is_empty(unit_t const & x, unit_t const & y) const;
   bool is_empty(vector_t const & coords) const;
 
+  /**
+   * Returns the node data stored for the given position, or a null pointer if
+   * there is none, or if the coordinates are invalid.
+   *
+   * Unlike operator(), this neither generates ids for empty positions nor
+   * throws, and doesn't construct a node instance; use it for reading node
+   * data in hot paths, such as traversal traits' is_impassable().
+   **/
+  node_dataT const * try_get(unit_t const & x, unit_t const & y) const;
+  node_dataT const * try_get(vector_t const & coords) const;
+  node_dataT * try_get(unit_t const & x, unit_t const & y);
+  node_dataT * try_get(vector_t const & coords);
+
+  /**
+   * As try_get(), but for the position next to the given coordinates in the
+   * given direction, as with node::get_relative(). Returns a null pointer for
+   * directions the tile traits don't support at the given coordinates.
+   **/
+  node_dataT const * try_get_relative(vector_t const & coords,
+      directions_t const & dir) const;
+  node_dataT * try_get_relative(vector_t const & coords,
+      directions_t const & dir);
+
   /**
    * min_coords() returns a vector_t with the lowest m_x of any node in the
    * group, and the lowest m_y of any node in the group.
@@ -277,6 +329,9 @@ public:
    * Note though that there doesn't actually have to be a node in the group at
    * either position. It pays to check each position via is_empty() before
    * attempting to retrieve the corresponding node from the map.
+   *
+   * The bounding box is kept up to date as nodes are added, moved and erased,
+   * so both functions take constant time.
    **/
   vector_t min_coords() const;
   vector_t max_coords() const;
@@ -306,10 +361,37 @@ public:
    **/
   bool erase(unit_t const & x, unit_t const & y);
   bool erase(vector_t const & coords);
+
+  /**
+   * Each change to the node_group - assigning node data, move(), erase() or
+   * clear() - increments the node_group's version, and records the new
+   * version for the region(s) the change affects. Data derived from the
+   * node_group, such as cached paths, is still current if none of the regions
+   * it was derived from has a higher version than the node_group had at the
+   * time; see path_cache.
+   *
+   * Modifying node data in place, through node::operator->() or node::get(),
+   * goes unnoticed; call touch() for the node afterwards.
+   **/
+  version_t version() const;
+  version_t region_version(vector_t const & region) const;
+
+  /**
+   * Returns the region containing the given coordinates, which is what
+   * region_version() expects.
+   **/
+  static vector_t region_of(vector_t const & coords);
+
+  /**
+   * Records a change to the node at the given coordinates, as described for
+   * version() above.
+   **/
+  void touch(vector_t const & coords);
 private:
 
-  // Retreive an user-defined node data for the given node id.
-  node_data_ptr get(node_id_t const & id) const;
+  // Retreive an user-defined node data for the given node id. The coordinates
+  // are where the node was last seen, and merely speed up the search.
+  node_dataT * get(node_id_t const & id, vector_t const & coords) const;
 
   // Set user defined node-data for the given node id. Also anchor the node at
   // the specified position in the group.
@@ -318,21 +400,27 @@ private:
   void set(node_id_t const & id, vector_t const & coords,
       node_dataT const & data);
 
-  // Map coordinates to node ids.
-  typedef std::map<vector_t, node_id_t> coordinate_map_t;
-  coordinate_map_t m_nodes;
+  // Node ids and user-defined node data, by coordinates and ids.
+  typedef typename storageT::template rebind<
+    node_id_t,
+    node_dataT
+  >::type storage_t;
+#ifndef CG_DISABLE_CONCEPT_CHECKS
+  BOOST_CLASS_REQUIRE(storage_t, concepts, NodeStorageConcept);
+#endif
+  storage_t m_storage;
 
-  // Map node ids to user-defined node data.
-  struct node_data_wrapper
-  {
-    vector_t  m_coords;
-    node_data_ptr m_data;
-  };
-  typedef std::map<node_id_t, node_data_wrapper> node_data_map_t;
-  node_data_map_t m_node_data;
+  // Bounding box of all nodes.
+  detail::coords_bounds m_bounds;
 
   // Id generator
   mutable boost::scoped_ptr<id_generatorT> m_id_generator;
+
+  // Current version, version at the last clear(), and the version of each
+  // region changed since.
+  version_t                 m_version;
+  version_t                 m_clear_version;
+  detail::region_versions   m_region_versions;
 };
 
 } // namespace cartograph
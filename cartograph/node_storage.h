@@ -0,0 +1,147 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_NODE_STORAGE_H
+#define CG_NODE_STORAGE_H
+
+#include <cartograph/types.h>
+
+namespace cartograph {
+
+namespace detail {
+
+// See detail/node_storage.tcc
+template <typename node_idT, typename node_dataT>
+class map_node_storage;
+
+template <typename node_idT, typename node_dataT>
+class chunked_node_storage;
+
+template <typename node_idT, typename node_dataT>
+class hash_node_storage;
+
+} // namespace detail
+
+
+/**
+ * Storage policies determine how a node_group stores it's nodes. A policy is a
+ * class with a nested template rebind<node_idT, node_dataT>, whose type member
+ * is the class the node_group actually uses to store it's nodes, much like
+ * allocators in the STL. That class must conform to the NodeStorageConcept in
+ * node_group_concepts.h.
+ *
+ * Node data is stored under the node's id as well as it's coordinates. As
+ * node instances refer to nodes by id, the storage also needs to find nodes by
+ * their id; node instances pass the coordinates at which they last saw the
+ * node along, so that storage can look there first.
+ **/
+
+
+/**
+ * The default storage policy keeps a std::map of coordinates to node ids, and
+ * another of node ids to node data. Node data is stored by value in the
+ * latter map's nodes, so it stays in place when the node is moved.
+ *
+ * Lookups require walking the maps, but memory is only required for the nodes
+ * that exist, wherever they are; use it for small or very sparse node_groups.
+ **/
+struct map_storage
+{
+  template <
+    typename node_idT,
+    typename node_dataT
+  >
+  struct rebind
+  {
+    typedef detail::map_node_storage<node_idT, node_dataT> type;
+  };
+};
+
+
+/**
+ * Stores nodes in square chunks of CHUNK_SIZE by CHUNK_SIZE positions, each
+ * holding the node ids and node data of all positions within it in arrays.
+ * Chunks are allocated when the first node is added to them, and found via a
+ * small hash table of their coordinates.
+ *
+ * Lookups take a hash table probe and an array access, and node data of
+ * neighbouring nodes lies next to each other in memory. But each chunk
+ * requires memory for all of it's positions, whether or not there are nodes
+ * at them, and chunks are only released by clear(); use it for densely
+ * populated node_groups.
+ *
+ * Node data is stored by value, without an allocation per node, so it moves in
+ * memory when the node is moved.
+ **/
+struct chunked_storage
+{
+  enum
+  {
+    CHUNK_BITS = 5,
+    CHUNK_SIZE = 1 << CHUNK_BITS,
+  };
+
+  template <
+    typename node_idT,
+    typename node_dataT
+  >
+  struct rebind
+  {
+    typedef detail::chunked_node_storage<node_idT, node_dataT> type;
+  };
+};
+
+
+/**
+ * Stores node ids and node data in a flat hash table, keyed by the node's
+ * coordinates packed into 64 bits, using open addressing with linear probing.
+ *
+ * Lookups take a single hash table probe, and memory is only required for the
+ * nodes that exist (plus the table's slack), wherever they are; use it for
+ * sparse node_groups that can't be confined to a region, or are too large for
+ * the map_storage to be fast.
+ *
+ * Coordinates must be representable as 32 bit integers, and not be the
+ * smallest 32 bit integer; creating nodes elsewhere throws an exception with
+ * CG_INVALID_COORDS.
+ *
+ * Node data is stored by value, so it moves in memory when the node is moved,
+ * erased or the table grows.
+ **/
+struct hash_storage
+{
+  template <
+    typename node_idT,
+    typename node_dataT
+  >
+  struct rebind
+  {
+    typedef detail::hash_node_storage<node_idT, node_dataT> type;
+  };
+};
+
+} // namespace cartograph
+
+
+// Include implementation
+#include <cartograph/detail/node_storage.tcc>
+
+#endif // guard
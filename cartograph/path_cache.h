@@ -0,0 +1,145 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_PATH_CACHE_H
+#define CG_PATH_CACHE_H
+
+#include <deque>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <cartograph/pathfinding.h>
+
+namespace cartograph {
+namespace pathfinding {
+
+/**
+ * A path_cache sits in front of a_star() and remembers the results of the
+ * most recent searches, so that repeated searches for the same start and end
+ * node - e.g. patrol routes - don't need to be run again. When the cache is
+ * full, the least recently used result is dropped.
+ *
+ * Cached results are dropped when the node_group changes in any of the regions
+ * (see node_group::version()) the search that produced them considered; other
+ * changes to the node_group leave them alone. Results are cached separately
+ * for each traversal traits object, identified by it's address. If the
+ * traversal traits change in ways the node_group doesn't reflect, call
+ * clear(). Paths also depend on the heuristic, so use a separate path_cache
+ * for each heuristic.
+ *
+ * Only successful searches and searches that found there is no path are
+ * cached.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+class path_cache
+  : private boost::noncopyable
+{
+public:
+  /**
+   * Creates a cache for up to capacity paths within the given node_group,
+   * which must remain valid for as long as the path_cache exists.
+   **/
+  explicit path_cache(node_groupT const & group, std::size_t capacity = 256);
+
+  /**
+   * Returns the cached result for the given start and end node and traversal
+   * traits if it is still current, and otherwise runs a_star() and caches
+   * it's result. See a_star() for details on the parameters and return
+   * values; unlike a_star(), the path replaces the contents of result.
+   **/
+  template <typename heuristicT>
+  error_t find_path(std::deque<vector_t> & result, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic);
+
+  /**
+   * Drops all cached results.
+   **/
+  void clear();
+
+  /**
+   * Returns the number of cached results, and the maximum number.
+   **/
+  std::size_t size() const;
+  std::size_t capacity() const;
+
+  /**
+   * Returns how many calls to find_path() used a cached result, and how many
+   * ran a_star().
+   **/
+  std::size_t hits() const;
+  std::size_t misses() const;
+
+private:
+  typedef typename node_groupT::tile_traits_t tile_traits_t;
+  typedef typename node_groupT::version_t     version_t;
+
+  struct key_t
+  {
+    vector_t                  m_start;
+    vector_t                  m_end;
+    traversal_traitsT const * m_traversal_traits;
+
+    bool operator<(key_t const & other) const;
+  };
+
+  struct entry_t
+  {
+    key_t                 m_key;
+    error_t               m_error;
+    std::deque<vector_t>  m_path;
+    // Version of the node_group when the search ran, and the regions the
+    // search considered.
+    version_t             m_version;
+    std::vector<vector_t> m_regions;
+  };
+
+  // Most recently used entries first.
+  typedef std::list<entry_t>                              entry_list_t;
+  typedef std::map<key_t, typename entry_list_t::iterator> entry_map_t;
+
+  bool is_current(entry_t const & entry) const;
+  void collect_regions(std::vector<vector_t> & regions,
+      join_t const & join_types);
+
+  node_groupT const & m_group;
+  std::size_t         m_capacity;
+
+  entry_list_t        m_entries;
+  entry_map_t         m_index;
+
+  std::size_t         m_hits;
+  std::size_t         m_misses;
+
+  search_context      m_context;
+};
+
+}} // namespace cartograph::pathfinding
+
+#include <cartograph/detail/path_cache.tcc>
+
+#endif // guard
@@ -23,8 +23,17 @@
 #define CG_PATHFINDING_H
 
 #include <deque>
+#include <vector>
 
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+
+#include <cartograph/error.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/detail/search_nodes.h>
 
 #ifndef CG_DISABLE_CONCEPT_CHECKS
 // Include concepts
@@ -34,6 +43,127 @@
 namespace cartograph {
 namespace pathfinding {
 
+namespace detail {
+
+// See detail/pathfinding.tcc
+template <
+  typename traversal_traitsT,
+  typename node_groupT,
+  typename open_listT,
+  typename node_lookupT,
+  typename heuristicT
+>
+struct pathfinder;
+
+template <
+  typename traversal_traitsT,
+  typename node_groupT,
+  typename open_listT,
+  typename node_lookupT,
+  typename heuristicT
+>
+struct anytime_pathfinder;
+
+} // namespace detail
+
+
+/**
+ * The pathfinding functions accept any heuristic that can be called like the
+ * functions in heuristics.h, or any prepared heuristic (see heuristics.h), and
+ * call it directly; the function objects in heuristics.h can therefore be
+ * inlined. If you need to choose a heuristic at runtime, pass an instance of
+ * heuristic_function<...>::type instead.
+ *
+ * The same goes for the classes below that take the heuristic's type as
+ * their heuristicT template parameter, such as resumable_search: they store
+ * the heuristic as a heuristicT, and prepare it once per search as a_star()
+ * does. Use heuristic_function<...>::type as heuristicT to choose the
+ * heuristic at runtime.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT
+>
+struct heuristic_function
+{
+  typedef boost::function<
+    unit_t (node_groupT const &, vector_t const &, vector_t const &,
+        vector_t const &, traversal_traitsT &)
+  > type;
+};
+
+
+/**
+ * A search_context holds the memory pathfinding functions need for keeping
+ * track of nodes. Each call to a_star() without a search_context allocates and
+ * releases that memory again; if you run many searches, create a
+ * search_context once and pass it to each call instead. The memory is then
+ * kept between calls, and resetting it for the next call is cheap.
+ *
+ * A search_context must not be used by several searches at the same time.
+ **/
+class search_context
+  : private boost::noncopyable
+{
+public:
+  search_context();
+
+  /**
+   * For use by the pathfinding functions in this library. The reverse
+   * workspace is only needed by bidirectional searches, and therefore
+   * allocated on first use.
+   **/
+  detail::search_workspace & workspace();
+  detail::search_workspace & reverse_workspace();
+
+private:
+  detail::search_workspace                    m_workspace;
+  boost::scoped_ptr<detail::search_workspace> m_reverse_workspace;
+};
+
+
+
+/**
+ * State of a search that can be run in several steps; see resumable_search
+ * below.
+ **/
+enum search_state_t
+{
+  SEARCH_IN_PROGRESS  = 0,
+  SEARCH_FOUND        = 1,
+  SEARCH_FAILED       = 2,
+};
+
+
+
+/**
+ * Limits for a single search, to bound the worst-case time and memory a search
+ * may take - e.g. when the end node is unreachable, a search would otherwise
+ * process every node reachable from the start node before giving up.
+ *
+ * A value of zero means no limit; that's also the default for all limits.
+ **/
+struct search_limits
+{
+  search_limits();
+
+  // Maximum number of nodes to process, i.e. to move to the closed list.
+  std::size_t m_max_expansions;
+
+  // Nodes that can only be reached at a higher cost than this are ignored.
+  unit_t      m_max_g_cost;
+
+  // Maximum number of nodes on the open list.
+  std::size_t m_max_open_list_size;
+
+  // If true, and no path to the end node is found, the result is filled with
+  // the path to the node the search deemed closest to the end node, i.e. the
+  // one with the lowest heuristic value.
+  bool        m_return_partial_path;
+};
+
+
+
 /**
  * Implements A* pathfinding. Given a node_group, a start node (coordinates)
  * and end node (coordinates), the function returns a deque of coordinates of
@@ -55,6 +185,45 @@ namespace pathfinding {
  *    is in terms of getting closer to the goal. To turn A* into Dijkstra's
  *    algorithm, always use a heuristic value of 0 - the dijkstra function in
  *    heuristics.h does just that.
+ *
+ * @return CG_OK if a path was found, CG_INVALID_COORDS if start or end are not
+ *    valid coordinates, CG_NO_PATH if the end node cannot be reached from the
+ *    start node, or CG_BUDGET_EXCEEDED if search limits were exceeded (see
+ *    below).
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic);
+
+
+/**
+ * Same as above, but keeps the memory used for the search in the given
+ * search_context for reuse by subsequent calls.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context);
+
+
+/**
+ * Same as above, but the search gives up with CG_BUDGET_EXCEEDED if it exceeds
+ * the given limits. Nodes beyond the maximum g_cost are ignored; if that means
+ * the end node cannot be reached, CG_BUDGET_EXCEEDED is returned rather than
+ * CG_NO_PATH, as a path might well exist.
  **/
 template <
   typename node_groupT,
@@ -65,8 +234,437 @@ error_t
 a_star(std::deque<vector_t> & result, node_groupT const & group,
     vector_t const & start, vector_t const & end,
     traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits,
+    search_context & context);
+
+
+
+/**
+ * Same as the a_star() functions above, but finds the cheapest path to any of
+ * the given end nodes. The heuristic is applied to each end node, and the
+ * lowest estimate used, so the effort per node grows with the number of end
+ * nodes; for large sets of end nodes, Dijkstra's algorithm may well be faster.
+ *
+ * Unlike a single end node, the end nodes must be passable.
+ *
+ * @return CG_OK if a path was found, CG_INVALID_COORDS if start or any of the
+ *    end nodes are not valid coordinates or no end nodes are given, CG_NO_PATH
+ *    if none of the end nodes can be reached from the start node, or
+ *    CG_BUDGET_EXCEEDED if search limits were exceeded.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
     heuristicT const & heuristic);
 
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, std::vector<vector_t> const & ends,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_limits const & limits,
+    search_context & context);
+
+
+
+/**
+ * Implements weighted A* pathfinding, which orders nodes by their G cost plus
+ * the heuristic value multiplied by the given weight. With weights above 1,
+ * the search is drawn towards the end node more greedily and processes fewer
+ * nodes, but the path found may be more expensive than the cheapest path.
+ *
+ * Parameters and return values are the same as for a_star(), plus:
+ *
+ * @param weight Factor for the heuristic value; must be at least 1. If the
+ *    heuristic is admissible, i.e. never overestimates, the path found costs
+ *    at most weight times as much as the cheapest path, which makes the weight
+ *    the suboptimality bound for the result. A weight of 1 is the same as
+ *    calling a_star().
+ *
+ * @return As for a_star(), or CG_INVALID_VALUE if the weight is below 1.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_context & context);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_limits const & limits);
+
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+weighted_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, double weight, search_limits const & limits,
+    search_context & context);
+
+
+
+/**
+ * Implements bidirectional A* pathfinding: one search runs forward from the
+ * start node, another backward from the end node, until the two meet. On large
+ * open maps, this processes considerably fewer nodes than a_star().
+ *
+ * Parameters and return values are the same as for a_star(), with the
+ * following differences:
+ *  - The heuristic is also used with start and end swapped, to estimate the
+ *    costs from the start node to a node.
+ *  - The backward search determines the costs of moving into a node by asking
+ *    the traversal traits about the move from the neighbour node into the
+ *    node, i.e. the traversal traits need not be symmetric.
+ *  - The path found is only guaranteed to be the shortest path if the
+ *    heuristic is consistent, i.e. never estimates more than the costs of
+ *    moving to a neighbour plus the estimate for that neighbour.
+ *  - Unlike a_star(), the move into the end node is checked for
+ *    impassability, too.
+ *  - There is no support for search_limits.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+bidirectional_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic);
+
+
+/**
+ * Same as above, but keeps the memory used for the search in the given
+ * search_context for reuse by subsequent calls.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+error_t
+bidirectional_a_star(std::deque<vector_t> & result, node_groupT const & group,
+    vector_t const & start, vector_t const & end,
+    traversal_traitsT & traversal_traits,
+    heuristicT const & heuristic, search_context & context);
+
+
+
+/**
+ * A resumable_search performs the same search as a_star(), but lets you split
+ * the work over several calls to step(), each of which processes at most a
+ * given number of nodes. That way you can spread searches over several frames,
+ * and interleave several searches without any one of them exceeding your time
+ * budget.
+ *
+ * The node_group and traversal traits passed to the constructor must remain
+ * valid - and should remain unchanged - until the search is finished.
+ *
+ * If you pass a search_context to the constructor, it's used for the duration
+ * of the search, and must not be used for any other search in the meantime.
+ * Otherwise the resumable_search uses a search_context of it's own.
+ *
+ * See heuristic_function for the heuristicT parameter.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class resumable_search
+  : private boost::noncopyable
+{
+public:
+  /**
+   * See a_star() for details on the parameters. The search is set up, but no
+   * nodes are processed until step() is called.
+   **/
+  resumable_search(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic,
+      search_limits const & limits = search_limits());
+
+  resumable_search(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, search_limits const & limits,
+      search_context & context);
+
+  ~resumable_search();
+
+  /**
+   * Processes up to max_expansions nodes, or runs the search to completion if
+   * max_expansions is zero.
+   *
+   * @return SEARCH_IN_PROGRESS if the search needs further steps, otherwise
+   *    SEARCH_FOUND or SEARCH_FAILED. Once the search is finished, further
+   *    calls to step() do nothing but return the same value again.
+   **/
+  search_state_t step(std::size_t max_expansions);
+
+  /**
+   * The current state of the search, i.e. the return value of the last call
+   * to step().
+   **/
+  search_state_t state() const;
+
+  /**
+   * Once the search is finished, returns the same value a_star() would have
+   * returned; CG_OK while the search is in progress.
+   **/
+  error_t error() const;
+
+  /**
+   * Once the search is finished, returns the same path a_star() would have
+   * returned; an empty path while the search is in progress.
+   **/
+  std::deque<vector_t> const & path() const;
+
+private:
+  typedef detail::pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::dense_node_lookup,
+    heuristicT
+  > dense_pathfinder_t;
+
+  typedef detail::pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::map_node_lookup,
+    heuristicT
+  > map_pathfinder_t;
+
+  void init(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, search_limits const & limits);
+
+  boost::scoped_ptr<search_context>     m_own_context;
+  search_context &                      m_context;
+
+  // Only one of these is used, depending on which node lookup is suitable for
+  // the node_group.
+  boost::scoped_ptr<dense_pathfinder_t> m_dense_pathfinder;
+  boost::scoped_ptr<map_pathfinder_t>   m_map_pathfinder;
+
+  search_state_t                        m_state;
+  error_t                               m_error;
+  std::deque<vector_t>                  m_path;
+};
+
+
+
+/**
+ * An anytime_search implements anytime repairing A* (ARA*): it runs weighted
+ * A* (see weighted_a_star() above) with a high weight first, so a path is
+ * found quickly, and then repeatedly lowers the weight and repairs the search
+ * to find cheaper paths, for as long as you keep calling step(). Nodes and
+ * costs are kept between those iterations, so each iteration only processes
+ * the nodes whose costs changed.
+ *
+ * With each path found, the search reports a bound on how much more expensive
+ * that path can be than the cheapest path; once that bound reaches 1, the
+ * path is the cheapest path and the search is finished. The bound only holds
+ * if the heuristic is admissible, i.e. never overestimates.
+ *
+ * As for a resumable_search, the node_group and traversal traits passed to the
+ * constructor must remain valid until the search is finished, and a
+ * search_context passed to the constructor must not be used for any other
+ * search in the meantime.
+ *
+ * Unlike a_star(), the search only finishes once the end node is processed
+ * rather than when it's first encountered, and there is no support for
+ * search_limits; use the number of expansions per step() instead.
+ *
+ * The heuristic is prepared once, and reused for all iterations; see
+ * heuristic_function.
+ **/
+template <
+  typename node_groupT,
+  typename traversal_traitsT,
+  typename heuristicT
+>
+class anytime_search
+  : private boost::noncopyable
+{
+public:
+  /**
+   * See a_star() for details on the parameters. The first iteration uses the
+   * initial_weight, and each further iteration a weight lower by weight_step,
+   * but no lower than 1. The initial_weight must be at least 1, and the
+   * weight_step above 0; otherwise the search fails with CG_INVALID_VALUE.
+   *
+   * The search is set up, but no nodes are processed until step() is called.
+   **/
+  anytime_search(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, double initial_weight = 3.0,
+      double weight_step = 0.5);
+
+  anytime_search(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, double initial_weight,
+      double weight_step, search_context & context);
+
+  ~anytime_search();
+
+  /**
+   * Processes up to max_expansions nodes, or runs the current iteration to
+   * completion if max_expansions is zero. Either way, step() returns as soon
+   * as an iteration finishes, so that the improved path can be used.
+   *
+   * @return SEARCH_IN_PROGRESS if further steps may improve the path found so
+   *    far (if any), SEARCH_FOUND once the cheapest path is found, and
+   *    SEARCH_FAILED if there is no path. Once the search is finished, further
+   *    calls to step() do nothing but return the same value again.
+   **/
+  search_state_t step(std::size_t max_expansions);
+
+  /**
+   * The current state of the search, i.e. the return value of the last call
+   * to step().
+   **/
+  search_state_t state() const;
+
+  /**
+   * CG_OK unless the search failed; then CG_INVALID_COORDS, CG_INVALID_VALUE
+   * or CG_NO_PATH as for weighted_a_star().
+   **/
+  error_t error() const;
+
+  /**
+   * The cheapest path found so far, or an empty path if none was found yet.
+   **/
+  std::deque<vector_t> const & path() const;
+
+  /**
+   * The costs of the path returned by path(), or invalid_unit if no path was
+   * found yet.
+   **/
+  unit_t path_cost() const;
+
+  /**
+   * The proven suboptimality bound for the path returned by path(): the path
+   * costs at most bound() times as much as the cheapest path. Zero while no
+   * path was found yet, and 1 once the search is finished.
+   **/
+  double bound() const;
+
+  /**
+   * The weight the current iteration uses.
+   **/
+  double weight() const;
+
+private:
+  typedef detail::anytime_pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::dense_node_lookup,
+    heuristicT
+  > dense_pathfinder_t;
+
+  typedef detail::anytime_pathfinder<
+    traversal_traitsT,
+    node_groupT,
+    detail::open_list_t,
+    detail::map_node_lookup,
+    heuristicT
+  > map_pathfinder_t;
+
+  void init(node_groupT const & group, vector_t const & start,
+      vector_t const & end, traversal_traitsT & traversal_traits,
+      heuristicT const & heuristic, double initial_weight,
+      double weight_step);
+
+  boost::scoped_ptr<search_context>     m_own_context;
+  search_context &                      m_context;
+
+  // Only one of these is used, depending on which node lookup is suitable for
+  // the node_group.
+  boost::scoped_ptr<dense_pathfinder_t> m_dense_pathfinder;
+  boost::scoped_ptr<map_pathfinder_t>   m_map_pathfinder;
+
+  search_state_t                        m_state;
+  error_t                               m_error;
+  std::deque<vector_t>                  m_path;
+  unit_t                                m_path_cost;
+  double                                m_bound;
+  double                                m_weight;
+};
+
 }} // namespace cartograph::pathfinding
 
 #include <cartograph/detail/pathfinding.tcc>
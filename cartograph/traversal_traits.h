@@ -22,6 +22,8 @@
 #ifndef CG_TRAVERSAL_TRAITS_H
 #define CG_TRAVERSAL_TRAITS_H
 
+#include <boost/type_traits/integral_constant.hpp>
+
 #include <cartograph/directions.h>
 
 namespace cartograph {
@@ -114,6 +116,34 @@ struct default_costs
   static unit_t traversal_cost(vector_t const & coords, directions_t const & d);
 };
 
+
+/**
+ * Some pathfinding algorithms, such as jump_point_search(), only work if
+ *  - traversal costs depend on the direction only, i.e. all edge neighbours
+ *    cost the same to reach, as do all corner neighbours, and
+ *  - whether traversal into a given direction is impassable depends on the
+ *    node being moved into only, not on the node being moved from.
+ *
+ * Traversal traits declare that they meet these requirements by specializing
+ * has_uniform_costs to derive from boost::true_type; the simple_traversal_traits
+ * above do.
+ **/
+template <
+  typename traversal_traitsT
+>
+struct has_uniform_costs
+  : public boost::false_type
+{
+};
+
+template <
+  typename node_groupT
+>
+struct has_uniform_costs<simple_traversal_traits<node_groupT> >
+  : public boost::true_type
+{
+};
+
 }} // namespace cartograph::pathfinding
 
 #include <cartograph/detail/traversal_traits.tcc>
@@ -25,6 +25,8 @@
 
 #include <boost/integer_traits.hpp>
 
+#include <cartograph/detail/coords_hash.h>
+
 namespace cartograph {
 
 /**
@@ -129,6 +131,14 @@ operator<<(std::ostream & os, vector_t const & vec)
 }
 
 
+
+std::size_t
+hash_value(vector_t const & vec)
+{
+  return detail::mix_coords_key(detail::coords_key(vec));
+}
+
+
 } // namespace cartograph
 
 
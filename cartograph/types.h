@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 
+#include <cstddef>
 #include <ostream>
 
 #include <cartograph/cg-config.h>
@@ -115,6 +116,11 @@ extern const vector_t invalid_vector;
 
 std::ostream & operator<<(std::ostream & os, vector_t const & vec);
 
+/**
+ * Hash function for vector_t, as found by boost::hash.
+ **/
+std::size_t hash_value(vector_t const & vec);
+
 
 } // namespace cartograph
 
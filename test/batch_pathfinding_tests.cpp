@@ -0,0 +1,204 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/batch_pathfinding.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+
+template <
+  typename tile_traitsT
+>
+class BatchPathfindingTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(BatchPathfindingTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testBatch);
+    CPPUNIT_TEST(testErrors);
+    CPPUNIT_TEST(testExceptions);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef lookup_traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::heuristics::diagonal_heuristic<
+    test_map_t,
+    traits_t
+  > heuristic_t;
+  typedef cartograph::pathfinding::batch_pathfinder<
+    test_map_t,
+    traits_t,
+    heuristic_t
+  > batch_pathfinder_t;
+
+  test_map_t test_map;
+
+  // Throws a cartograph::exception left of the wall, and something else to the
+  // right of it.
+  struct throwing_traits
+    : public traits_t
+  {
+    throwing_traits(test_map_t const & m)
+      : traits_t(m)
+    {
+    }
+
+    bool
+    is_impassable(cartograph::vector_t const & coords,
+        cartograph::directions_t const & /* d */)
+    {
+      if (coords.m_x < 25) {
+        throw cartograph::exception(cartograph::CG_INVALID_COORDS);
+      }
+      throw 42;
+    }
+  };
+
+private:
+
+  void testBatch()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // Queries between pseudo-random passable nodes.
+    std::vector<cgp::path_query> queries;
+    uint32_t random = 42;
+    while (queries.size() < 100) {
+      cg::vector_t coords[2];
+      for (int i = 0 ; i < 2 ; ++i) {
+        do {
+          random = random * 1103515245 + 12345;
+          coords[i] = cg::vector_t((random >> 8) % 50, (random >> 20) % 50);
+        } while (!test_map.is_valid(coords[i])
+            || test_map(coords[i])->m_blocked);
+      }
+      queries.push_back(cgp::path_query(coords[0], coords[1]));
+    }
+
+    traits_t tt(test_map);
+    batch_pathfinder_t pathfinder(test_map, tt, heuristic_t(), 4);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), pathfinder.num_threads());
+
+    // Run the batch twice, to make sure the workers pick up the second one.
+    for (int i = 0 ; i < 2 ; ++i) {
+      pathfinder.find_paths(queries);
+
+      for (std::size_t j = 0 ; j < queries.size() ; ++j) {
+        std::deque<cg::vector_t> expected;
+        cg::error_t err = cgp::a_star(expected, test_map,
+            queries[j].m_start, queries[j].m_end, tt,
+            &cgph::diagonal<test_map_t, traits_t>);
+        CPPUNIT_ASSERT_EQUAL(err, queries[j].m_error);
+        CPPUNIT_ASSERT(expected == queries[j].m_result);
+      }
+    }
+  }
+
+
+  void testErrors()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    std::vector<cgp::path_query> queries;
+    queries.push_back(cgp::path_query(cg::vector_t(4, 4),
+          cg::invalid_vector));
+    queries.push_back(cgp::path_query(cg::vector_t(4, 4),
+          cg::vector_t(200, 200)));
+
+    traits_t tt(test_map);
+    batch_pathfinder_t pathfinder(test_map, tt, heuristic_t());
+    CPPUNIT_ASSERT(pathfinder.num_threads() > 0);
+
+    pathfinder.find_paths(queries);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, queries[0].m_error);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, queries[1].m_error);
+
+    // Empty batches return immediately.
+    queries.clear();
+    pathfinder.find_paths(queries);
+  }
+
+
+  void testExceptions()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    std::vector<cgp::path_query> queries;
+    for (int i = 0 ; i < 10 ; ++i) {
+      queries.push_back(cgp::path_query(cg::vector_t(4, 4),
+            cg::vector_t(6, 6)));
+      queries.push_back(cgp::path_query(cg::vector_t(40, 4),
+            cg::vector_t(42, 6)));
+    }
+
+    typedef cgph::diagonal_heuristic<test_map_t, throwing_traits> heuristic_t;
+    typedef cgp::batch_pathfinder<
+      test_map_t,
+      throwing_traits,
+      heuristic_t
+    > throwing_pathfinder_t;
+
+    throwing_traits tt(test_map);
+    throwing_pathfinder_t pathfinder(test_map, tt, heuristic_t(), 2);
+
+    // Exceptions are reported per query, and don't stop the workers.
+    for (int i = 0 ; i < 2 ; ++i) {
+      pathfinder.find_paths(queries);
+
+      for (std::size_t j = 0 ; j < queries.size() ; j += 2) {
+        CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, queries[j].m_error);
+        CPPUNIT_ASSERT(queries[j].m_result.empty());
+        CPPUNIT_ASSERT_EQUAL(cg::CG_UNEXPECTED, queries[j + 1].m_error);
+        CPPUNIT_ASSERT(queries[j + 1].m_result.empty());
+      }
+    }
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BatchPathfindingTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(BatchPathfindingTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(BatchPathfindingTest<cartograph::hexagonal_tile_traits>);
@@ -0,0 +1,284 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/contraction_hierarchy.h>
+#include <cartograph/flow_field.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+namespace
+{
+
+char const * const TEST_FILE = "contraction_hierarchy_tests.tmp";
+
+} // anonymous namespace
+
+
+template <
+  typename tile_traitsT
+>
+class ContractionHierarchyTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(ContractionHierarchyTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testCosts);
+    CPPUNIT_TEST(testFindPath);
+    CPPUNIT_TEST(testSaveLoad);
+    CPPUNIT_TEST(testInvalid);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+    std::remove(TEST_FILE);
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::contraction_hierarchy<
+    test_map_t,
+    traits_t
+  > hierarchy_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  /**
+   * Checks that the hierarchy's costs from every node to the given goal match
+   * those of a flow field computed for the goal.
+   **/
+  void
+  check_costs(hierarchy_t & hierarchy, traits_t & traits,
+      cartograph::vector_t const & goal)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    cgp::flow_field<test_map_t, traits_t> field(test_map, traits);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, field.compute(goal));
+
+    for (cg::unit_t y = 0 ; y < 50 ; ++y) {
+      for (cg::unit_t x = 0 ; x < 50 ; ++x) {
+        cg::vector_t coords(x, y);
+        if (test_map.is_valid(x, y)) {
+          CPPUNIT_ASSERT_EQUAL(field.cost(coords),
+              hierarchy.path_cost(coords, goal));
+        }
+      }
+    }
+  }
+
+public:
+
+  void testCosts()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    hierarchy_t hierarchy(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.compute(tt, 3));
+    CPPUNIT_ASSERT_EQUAL(test_map.size(), hierarchy.node_count());
+    CPPUNIT_ASSERT(hierarchy.edge_count() > 0);
+
+    check_costs(hierarchy, tt, end);
+    check_costs(hierarchy, tt, start);
+    check_costs(hierarchy, tt, cg::vector_t(26, 24));
+
+    // The wall can't be entered.
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit,
+        hierarchy.path_cost(start, cg::vector_t(25, 24)));
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), hierarchy.path_cost(start, start));
+  }
+
+
+  void testFindPath()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    hierarchy_t hierarchy(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.compute(tt));
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.find_path(path, start, end));
+    CPPUNIT_ASSERT_EQUAL(start, path.front());
+    CPPUNIT_ASSERT_EQUAL(end, path.back());
+    CPPUNIT_ASSERT_EQUAL(hierarchy.path_cost(start, end),
+        path_cost<tile_traitsT>(path, tt));
+
+    // Same in reverse, and between all kinds of nodes.
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.find_path(path, end, start));
+    CPPUNIT_ASSERT_EQUAL(end, path.front());
+    CPPUNIT_ASSERT_EQUAL(start, path.back());
+    CPPUNIT_ASSERT_EQUAL(hierarchy.path_cost(end, start),
+        path_cost<tile_traitsT>(path, tt));
+
+    for (cg::unit_t i = 0 ; i < 50 ; i += 7) {
+      cg::vector_t from(i, 49 - i);
+      cg::vector_t to(49 - i, (i * 3) % 50);
+      if (!test_map.is_valid(from.m_x, from.m_y)
+          || !test_map.is_valid(to.m_x, to.m_y))
+      {
+        continue;
+      }
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.find_path(path, from, to));
+      CPPUNIT_ASSERT_EQUAL(from, path.front());
+      CPPUNIT_ASSERT_EQUAL(to, path.back());
+      CPPUNIT_ASSERT_EQUAL(hierarchy.path_cost(from, to),
+          path_cost<tile_traitsT>(path, tt));
+    }
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.find_path(path, start, start));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), path.size());
+    CPPUNIT_ASSERT_EQUAL(start, path.front());
+  }
+
+
+  void testSaveLoad()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    hierarchy_t hierarchy(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.compute(tt));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.save(TEST_FILE));
+
+    hierarchy_t loaded(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, loaded.load(TEST_FILE));
+    CPPUNIT_ASSERT_EQUAL(hierarchy.node_count(), loaded.node_count());
+    CPPUNIT_ASSERT_EQUAL(hierarchy.edge_count(), loaded.edge_count());
+
+    std::deque<cg::vector_t> expected;
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.find_path(expected, start, end));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, loaded.find_path(path, start, end));
+    CPPUNIT_ASSERT(expected == path);
+    check_costs(loaded, tt, end);
+
+    // Shortcuts that skip edges which don't exist are refused; make the first
+    // upward shortcut skip its own end node.
+    std::vector<char> data;
+    {
+      std::ifstream is(TEST_FILE, std::ios::in | std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(is),
+          std::istreambuf_iterator<char>());
+    }
+    std::size_t pos = 16 + 4 * sizeof(cg::unit_t);
+    uint64_t count = 0;
+    std::memcpy(&count, &data[pos], sizeof(count));
+    pos += sizeof(count) + count * 2 * sizeof(cg::unit_t);
+    uint64_t edges = 0;
+    std::memcpy(&edges, &data[pos], sizeof(edges));
+    pos += sizeof(edges) + (count + 1) * sizeof(uint32_t);
+    bool corrupted = false;
+    for (uint64_t i = 0 ; i < edges && !corrupted ; ++i) {
+      std::size_t middle = pos + sizeof(uint32_t) + sizeof(cg::unit_t);
+      if (std::memcmp(&data[middle], "\xff\xff\xff\xff", 4)) {
+        std::memcpy(&data[middle], &data[pos], sizeof(uint32_t));
+        corrupted = true;
+      }
+      pos += 2 * sizeof(uint32_t) + sizeof(cg::unit_t);
+    }
+    CPPUNIT_ASSERT(corrupted);
+    {
+      std::ofstream os(TEST_FILE,
+          std::ios::out | std::ios::binary | std::ios::trunc);
+      os.write(&data[0], data.size());
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, loaded.load(TEST_FILE));
+    CPPUNIT_ASSERT_EQUAL(hierarchy.node_count(), loaded.node_count());
+
+    // Hierarchies for a map with different bounds are refused.
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.save(TEST_FILE));
+    test_map(60, 60) = test_node();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, loaded.load(TEST_FILE));
+    CPPUNIT_ASSERT_EQUAL(hierarchy.node_count(), loaded.node_count());
+
+    std::remove(TEST_FILE);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_IO_ERROR, loaded.load(TEST_FILE));
+  }
+
+
+  void testInvalid()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    hierarchy_t hierarchy(test_map);
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS,
+        hierarchy.find_path(path, start, end));
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hierarchy.compute(tt, 1));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS,
+        hierarchy.find_path(path, start, cg::vector_t(200, 200)));
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit,
+        hierarchy.path_cost(cg::vector_t(-1, 0), end));
+
+    // Nothing leads into the wall.
+    cg::vector_t wall(25, 24);
+    while (!test_map.is_valid(wall.m_x, wall.m_y)) {
+      ++wall.m_y;
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH,
+        hierarchy.find_path(path, start, wall));
+
+    test_map_t empty;
+    hierarchy_t empty_hierarchy(empty);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, empty_hierarchy.compute(
+          traits_t(empty)));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ContractionHierarchyTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(ContractionHierarchyTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(ContractionHierarchyTest<cartograph::hexagonal_tile_traits>);
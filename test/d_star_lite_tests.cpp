@@ -0,0 +1,243 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/d_star_lite.h>
+#include <cartograph/flow_field.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+
+template <
+  typename tile_traitsT
+>
+class DStarLiteTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(DStarLiteTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testCompute);
+    CPPUNIT_TEST(testReplan);
+    CPPUNIT_TEST(testNoPath);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::heuristics::diagonal_heuristic<
+    test_map_t,
+    traits_t
+  > heuristic_t;
+  typedef cartograph::pathfinding::d_star_lite<
+    test_map_t,
+    traits_t,
+    heuristic_t
+  > planner_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  /**
+   * Sets whether the nodes in the given column between the given rows
+   * (inclusive) are blocked, and invalidates them in the planner.
+   **/
+  void
+  set_blocked(planner_t & planner, cartograph::unit_t x,
+      cartograph::unit_t min_y, cartograph::unit_t max_y, bool blocked)
+  {
+    for (cartograph::unit_t y = min_y ; y <= max_y ; ++y) {
+      if (test_map.is_valid(x, y)) {
+        test_map(x, y) = test_node(blocked);
+        planner.invalidate(cartograph::vector_t(x, y));
+      }
+    }
+  }
+
+
+  /**
+   * Checks that the planner's path is a cheapest path from it's start node,
+   * by comparing against a flow field computed from scratch.
+   **/
+  void
+  check_path(planner_t const & planner, traits_t & traits)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    cgp::flow_field<test_map_t, traits_t> field(test_map, traits);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, field.compute(planner.goal()));
+    CPPUNIT_ASSERT_EQUAL(field.cost(planner.start()), planner.cost());
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.path(path));
+    CPPUNIT_ASSERT_EQUAL(planner.start(), path.front());
+    CPPUNIT_ASSERT_EQUAL(planner.goal(), path.back());
+    if (path.size() > 1) {
+      CPPUNIT_ASSERT_EQUAL(path[1], planner.next());
+    }
+
+    CPPUNIT_ASSERT_EQUAL(planner.cost(),
+        path_cost<tile_traitsT>(path, traits));
+  }
+
+public:
+
+  void testCompute()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    planner_t planner(test_map, tt, heuristic_t());
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_vector, planner.goal());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, planner.update());
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.compute(start, end));
+    CPPUNIT_ASSERT_EQUAL(start, planner.start());
+    CPPUNIT_ASSERT_EQUAL(end, planner.goal());
+    check_path(planner, tt);
+
+    // Nothing changed, so updating must yield the same.
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+
+    // Starting at the goal yields just that node.
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.compute(end, end));
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), planner.cost());
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_vector, planner.next());
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS,
+        planner.compute(start, cg::vector_t(200, 200)));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS,
+        planner.move_start(cg::vector_t(200, 200)));
+  }
+
+
+  void testReplan()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    planner_t planner(test_map, tt, heuristic_t());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.compute(start, end));
+
+    // Follow the path for a bit, then close the gap at the top; the path
+    // has to go around the bottom.
+    for (int i = 0 ; i < 5 ; ++i) {
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.move_start(planner.next()));
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+
+    set_blocked(planner, 25, 0, 5, true);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+
+    // Move on, and open a gap in the middle of the wall, which makes the path
+    // cheaper.
+    for (int i = 0 ; i < 5 ; ++i) {
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.move_start(planner.next()));
+    }
+    set_blocked(planner, 25, 20, 30, false);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+
+    // Regions work just the same.
+    for (cg::unit_t y = 20 ; y <= 30 ; ++y) {
+      if (test_map.is_valid(25, y)) {
+        test_map(25, y) = test_node(true);
+      }
+    }
+    planner.invalidate(cg::vector_t(25, 20), cg::vector_t(26, 31));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+
+    // Follow the path all the way.
+    std::size_t steps = 0;
+    while (planner.start() != end && steps++ < 2500) {
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.move_start(planner.next()));
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    }
+    CPPUNIT_ASSERT_EQUAL(end, planner.start());
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), planner.cost());
+  }
+
+
+  void testNoPath()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    planner_t planner(test_map, tt, heuristic_t());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.compute(start, end));
+
+    // Make the wall impenetrable; the left half of the map can't reach the
+    // end. Triangular tiles can cross a wall only one node thick via corner
+    // neighbours, so we need a thicker wall.
+    for (cg::unit_t x = 24 ; x <= 26 ; ++x) {
+      set_blocked(planner, x, 0, 49, true);
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, planner.update());
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, planner.cost());
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_vector, planner.next());
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, planner.path(path));
+    CPPUNIT_ASSERT(path.empty());
+
+    // Opening it again restores the path.
+    for (cg::unit_t x = 24 ; x <= 26 ; ++x) {
+      set_blocked(planner, x, 40, 45, false);
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, planner.update());
+    check_path(planner, tt);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DStarLiteTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(DStarLiteTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(DStarLiteTest<cartograph::hexagonal_tile_traits>);
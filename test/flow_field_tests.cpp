@@ -0,0 +1,228 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/flow_field.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+
+template <
+  typename tile_traitsT
+>
+class FlowFieldTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(FlowFieldTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testFollow);
+    CPPUNIT_TEST(testUpdate);
+    CPPUNIT_TEST(testNoPath);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::flow_field<
+    test_map_t,
+    traits_t
+  > flow_field_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  /**
+   * Sets whether the nodes in the given column between the given rows
+   * (inclusive) are blocked, and invalidates them in the flow field.
+   **/
+  void
+  set_blocked(flow_field_t & field, cartograph::unit_t x,
+      cartograph::unit_t min_y, cartograph::unit_t max_y, bool blocked)
+  {
+    for (cartograph::unit_t y = min_y ; y <= max_y ; ++y) {
+      if (test_map.is_valid(x, y)) {
+        test_map(x, y) = test_node(blocked);
+        field.invalidate(cartograph::vector_t(x, y));
+      }
+    }
+  }
+
+
+  /**
+   * Checks that the given flow field matches one computed from scratch.
+   **/
+  void
+  check_field(flow_field_t const & field, traits_t & traits)
+  {
+    namespace cg = cartograph;
+
+    flow_field_t expected(test_map, traits);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, expected.compute(field.goal()));
+
+    for (cg::unit_t y = 0 ; y < 50 ; ++y) {
+      for (cg::unit_t x = 0 ; x < 50 ; ++x) {
+        cg::vector_t coords(x, y);
+        CPPUNIT_ASSERT_EQUAL(expected.cost(coords), field.cost(coords));
+
+        // Directions may differ between paths of equal costs, but must lead
+        // to a node that's the step's costs closer to the goal.
+        cg::directions_t dir = field.direction(coords);
+        CPPUNIT_ASSERT_EQUAL(cg::DIR_END == dir,
+            cg::DIR_END == expected.direction(coords));
+        if (cg::DIR_END != dir) {
+          CPPUNIT_ASSERT(!traits.is_impassable(coords, dir));
+          CPPUNIT_ASSERT_EQUAL(field.cost(coords),
+              field.cost(field.next(coords))
+              + traits.traversal_cost(coords, dir));
+        }
+      }
+    }
+  }
+
+public:
+
+  void testFollow()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    flow_field_t field(test_map, tt);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, field.compute(end));
+    CPPUNIT_ASSERT_EQUAL(end, field.goal());
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), field.cost(end));
+    CPPUNIT_ASSERT_EQUAL(cg::DIR_END, field.direction(end));
+
+    // Following the directions from the start must lead to the end, at the
+    // costs the flow field predicts - which can't be more than the costs of
+    // the path a_star() finds.
+    cg::unit_t cost = 0;
+    cg::vector_t current = start;
+    std::size_t steps = 0;
+    while (current != end && steps++ < 2500) {
+      cg::directions_t dir = field.direction(current);
+      CPPUNIT_ASSERT(cg::DIR_END != dir);
+      CPPUNIT_ASSERT(!tt.is_impassable(current, dir));
+      cost += tt.traversal_cost(current, dir);
+      current = field.next(current);
+    }
+    CPPUNIT_ASSERT_EQUAL(end, current);
+    CPPUNIT_ASSERT_EQUAL(field.cost(start), cost);
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(path, test_map, start, end,
+          tt, &cgph::dijkstra<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(cost <= path_cost<tile_traitsT>(path, tt));
+
+    // The wall can't be entered, but it can be left.
+    cg::vector_t wall(25, test_map.is_valid(25, 24) ? 24 : 25);
+    CPPUNIT_ASSERT(cg::invalid_unit != field.cost(wall));
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, field.cost(cg::vector_t(200, 200)));
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS,
+        field.compute(cg::vector_t(200, 200)));
+  }
+
+
+  void testUpdate()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    flow_field_t field(test_map, tt);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, field.compute(end));
+
+    // Close the gap at the top; paths have to go around the bottom.
+    set_blocked(field, 25, 0, 5, true);
+    field.update();
+    check_field(field, tt);
+
+    // Open a gap in the middle of the wall, which makes paths cheaper.
+    set_blocked(field, 25, 20, 30, false);
+    field.update();
+    check_field(field, tt);
+
+    // Regions work just the same.
+    for (cg::unit_t y = 20 ; y <= 30 ; ++y) {
+      if (test_map.is_valid(25, y)) {
+        test_map(25, y) = test_node(true);
+      }
+    }
+    field.invalidate(cg::vector_t(25, 20), cg::vector_t(26, 31));
+    field.update();
+    check_field(field, tt);
+  }
+
+
+  void testNoPath()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    flow_field_t field(test_map, tt);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, field.compute(end));
+
+    // Make the wall impenetrable; the left half of the map can't reach the
+    // end. Triangular tiles can cross a wall only one node thick via corner
+    // neighbours, so we need a thicker wall.
+    for (cg::unit_t x = 24 ; x <= 26 ; ++x) {
+      set_blocked(field, x, 0, 49, true);
+    }
+    field.update();
+    check_field(field, tt);
+
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, field.cost(start));
+    CPPUNIT_ASSERT_EQUAL(cg::DIR_END, field.direction(start));
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_vector, field.next(start));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FlowFieldTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(FlowFieldTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(FlowFieldTest<cartograph::hexagonal_tile_traits>);
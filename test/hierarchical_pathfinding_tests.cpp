@@ -0,0 +1,243 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/hierarchical_pathfinding.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+
+template <
+  typename tile_traitsT
+>
+class HierarchicalPathfindingTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(HierarchicalPathfindingTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testFindPath);
+    CPPUNIT_TEST(testRefineLazily);
+    CPPUNIT_TEST(testSameCluster);
+    CPPUNIT_TEST(testInvalidate);
+    CPPUNIT_TEST(testNoPath);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::heuristics::diagonal_heuristic<
+    test_map_t,
+    traits_t
+  > heuristic_t;
+  typedef cartograph::pathfinding::hierarchical_map<
+    test_map_t,
+    traits_t,
+    heuristic_t
+  > hierarchical_map_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  /**
+   * Finds a path with the given hierarchical_map and checks that it's valid,
+   * and not a lot more expensive than the one a_star() finds.
+   **/
+  void
+  check_path(hierarchical_map_t & hmap, traits_t & tt,
+      cartograph::vector_t const & from, cartograph::vector_t const & to)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, test_map, from,
+          to, tt, &cgph::dijkstra<test_map_t, traits_t>));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.find_path(result, from, to));
+    CPPUNIT_ASSERT_EQUAL(from, result.front());
+    CPPUNIT_ASSERT_EQUAL(to, result.back());
+
+    cg::unit_t cost = path_cost<tile_traitsT>(result, tt);
+    CPPUNIT_ASSERT(cost >= 0);
+    CPPUNIT_ASSERT(cost * 4 <= path_cost<tile_traitsT>(expected, tt) * 5);
+  }
+
+
+  void testFindPath()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(test_map);
+    hierarchical_map_t hmap(test_map, tt, heuristic_t(), 8);
+    CPPUNIT_ASSERT(hmap.abstract_node_count() > 0);
+
+    check_path(hmap, tt, start, end);
+    check_path(hmap, tt, end, start);
+    check_path(hmap, tt, cg::vector_t(4, 44), cg::vector_t(44, 44));
+
+    // Same with clusters that don't align with the map's bounds.
+    hierarchical_map_t hmap2(test_map, tt, heuristic_t(), 7);
+    check_path(hmap2, tt, start, end);
+  }
+
+
+  void testRefineLazily()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(test_map);
+    hierarchical_map_t hmap(test_map, tt, heuristic_t(), 8);
+
+    std::deque<cg::vector_t> waypoints;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.find_abstract_path(waypoints, start,
+          end));
+    CPPUNIT_ASSERT(waypoints.size() > 2);
+    CPPUNIT_ASSERT_EQUAL(start, waypoints.front());
+    CPPUNIT_ASSERT_EQUAL(end, waypoints.back());
+
+    // Refining all segments yields the same as find_path().
+    std::deque<cg::vector_t> refined;
+    for (std::size_t i = 1 ; i < waypoints.size() ; ++i) {
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.refine_segment(refined,
+            waypoints[i - 1], waypoints[i]));
+    }
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.find_path(result, start, end));
+    CPPUNIT_ASSERT(result == refined);
+
+    // Nodes too far apart can't be refined.
+    refined.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, hmap.refine_segment(refined,
+          start, end));
+  }
+
+
+  void testSameCluster()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(test_map);
+    hierarchical_map_t hmap(test_map, tt, heuristic_t(), 16);
+
+    check_path(hmap, tt, cg::vector_t(2, 2), cg::vector_t(12, 10));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.find_path(result, start, start));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), result.size());
+  }
+
+
+  void testInvalidate()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(test_map);
+    hierarchical_map_t hmap(test_map, tt, heuristic_t(), 8);
+    check_path(hmap, tt, start, end);
+
+    // Close the gap the path went through.
+    for (uint32_t y = 0 ; y < 6 ; ++y) {
+      if (test_map.is_valid(25, y)) {
+        test_map(25, y) = test_node(true);
+        hmap.invalidate(cg::vector_t(25, y));
+      }
+    }
+    check_path(hmap, tt, start, end);
+
+    // The incrementally updated map must yield the same results as one built
+    // from scratch.
+    hierarchical_map_t fresh(test_map, tt, heuristic_t(), 8);
+    CPPUNIT_ASSERT_EQUAL(fresh.abstract_node_count(),
+        hmap.abstract_node_count());
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, fresh.find_path(expected, start, end));
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, hmap.find_path(result, start, end));
+    CPPUNIT_ASSERT(expected == result);
+  }
+
+
+  void testNoPath()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(test_map);
+    hierarchical_map_t hmap(test_map, tt, heuristic_t(), 8);
+
+    // Replace the wall with one that's thick enough to block moves to corner
+    // neighbours of triangular tiles, too.
+    for (uint32_t x = 24 ; x <= 26 ; ++x) {
+      for (uint32_t y = 0 ; y < 50 ; ++y) {
+        if (test_map.is_valid(x, y)) {
+          test_map(x, y) = test_node(true);
+          hmap.invalidate(cg::vector_t(x, y));
+        }
+      }
+    }
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, hmap.find_path(result, start, end));
+    CPPUNIT_ASSERT(result.empty());
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, hmap.find_path(result, start,
+          cg::invalid_vector));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HierarchicalPathfindingTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(HierarchicalPathfindingTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(HierarchicalPathfindingTest<cartograph::hexagonal_tile_traits>);
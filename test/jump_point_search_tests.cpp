@@ -0,0 +1,281 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/jump_point_search.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+namespace
+{
+
+typedef cartograph::node_group<
+  test_node,
+  cartograph::rectangular_tile_traits
+> test_map_t;
+
+typedef traversal_traits<test_map_t> traits_t;
+
+} // anonymous namespace
+
+
+namespace cartograph {
+namespace pathfinding {
+
+template <>
+struct has_uniform_costs<traits_t>
+  : public boost::true_type
+{
+};
+
+}} // namespace cartograph::pathfinding
+
+
+
+class JumpPointSearchTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(JumpPointSearchTest);
+
+    CPPUNIT_TEST(testOpenMap);
+    CPPUNIT_TEST(testObstacles);
+    CPPUNIT_TEST(testJumpPointsOnly);
+    CPPUNIT_TEST(testNoPath);
+    CPPUNIT_TEST(testEdgesOnly);
+    CPPUNIT_TEST(testOffMapEnd);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+
+    // A few walls with gaps, and some scattered obstacles.
+    uint32_t random = 42;
+    for (uint32_t x = 0 ; x < 50 ; ++x) {
+      for (uint32_t y = 0 ; y < 50 ; ++y) {
+        random = random * 1103515245 + 12345;
+        bool blocked = ((random >> 16) % 7 == 0)
+          || (x == 15 && y != 3 && y != 40)
+          || (x == 35 && y > 10)
+          || (y == 25 && x > 20 && x < 45);
+        test_map(x, y) = test_node(blocked && x != 4 && y != 4);
+      }
+    }
+    test_map(45, 37) = test_node();
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+  test_map_t test_map;
+
+private:
+
+  /**
+   * Checks that jump_point_search() finds a path as short as the one found
+   * by bidirectional_a_star() without heuristic, i.e. a shortest path.
+   **/
+  void
+  check_shortest(cartograph::vector_t const & start,
+      cartograph::vector_t const & end)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(expected,
+          test_map, start, end, tt,
+          &cgph::dijkstra<test_map_t, traits_t>));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::jump_point_search(result, test_map,
+          start, end, tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(start, result.front());
+    CPPUNIT_ASSERT_EQUAL(end, result.back());
+    CPPUNIT_ASSERT_EQUAL(path_cost<cg::rectangular_tile_traits>(expected, tt),
+        path_cost<cg::rectangular_tile_traits>(result, tt));
+  }
+
+
+  void testOpenMap()
+  {
+    namespace cg = cartograph;
+
+    for (uint32_t x = 0 ; x < 50 ; ++x) {
+      for (uint32_t y = 0 ; y < 50 ; ++y) {
+        test_map(x, y) = test_node();
+      }
+    }
+
+    check_shortest(cg::vector_t(4, 4), cg::vector_t(45, 37));
+    check_shortest(cg::vector_t(45, 37), cg::vector_t(4, 4));
+    check_shortest(cg::vector_t(0, 49), cg::vector_t(49, 0));
+    check_shortest(cg::vector_t(10, 10), cg::vector_t(10, 10));
+  }
+
+
+  void testObstacles()
+  {
+    namespace cg = cartograph;
+
+    check_shortest(cg::vector_t(4, 4), cg::vector_t(45, 37));
+    check_shortest(cg::vector_t(45, 37), cg::vector_t(4, 4));
+    check_shortest(cg::vector_t(4, 45), cg::vector_t(45, 37));
+    check_shortest(cg::vector_t(40, 4), cg::vector_t(4, 30));
+  }
+
+
+  void testJumpPointsOnly()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    cgp::search_context context;
+
+    std::deque<cg::vector_t> full;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::jump_point_search(full, test_map,
+          cg::vector_t(4, 4), cg::vector_t(45, 37), tt,
+          &cgph::diagonal<test_map_t, traits_t>, context));
+
+    std::deque<cg::vector_t> jump_points;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::jump_point_search(jump_points,
+          test_map, cg::vector_t(4, 4), cg::vector_t(45, 37), tt,
+          &cgph::diagonal<test_map_t, traits_t>, context, false));
+
+    // The jump points are a subset of the full path, and lie on straight or
+    // diagonal lines.
+    CPPUNIT_ASSERT(jump_points.size() < full.size());
+    CPPUNIT_ASSERT_EQUAL(full.front(), jump_points.front());
+    CPPUNIT_ASSERT_EQUAL(full.back(), jump_points.back());
+
+    std::deque<cg::vector_t>::iterator iter = full.begin();
+    for (std::size_t i = 0 ; i < jump_points.size() ; ++i) {
+      iter = std::find(iter, full.end(), jump_points[i]);
+      CPPUNIT_ASSERT(iter != full.end());
+
+      if (i > 0) {
+        cg::vector_t diff = jump_points[i] - jump_points[i - 1];
+        CPPUNIT_ASSERT(diff.m_x == 0 || diff.m_y == 0
+            || std::abs(diff.m_x) == std::abs(diff.m_y));
+      }
+    }
+  }
+
+
+  void testNoPath()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // Wall in the end node.
+    for (cg::unit_t x = 44 ; x <= 46 ; ++x) {
+      for (cg::unit_t y = 36 ; y <= 38 ; ++y) {
+        test_map(x, y) = test_node(true);
+      }
+    }
+    test_map(45, 37) = test_node();
+
+    traits_t tt(test_map);
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cgp::jump_point_search(result,
+          test_map, cg::vector_t(4, 4), cg::vector_t(45, 37), tt,
+          &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(result.empty());
+  }
+
+
+  void testEdgesOnly()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // Without corner neighbours, we get the same results as from a_star().
+    traits_t tt(test_map, true);
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, test_map,
+          cg::vector_t(4, 4), cg::vector_t(45, 37), tt,
+          &cgph::diagonal<test_map_t, traits_t>));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::jump_point_search(result, test_map,
+          cg::vector_t(4, 4), cg::vector_t(45, 37), tt,
+          &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(expected == result);
+  }
+
+  void testOffMapEnd()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef cgp::simple_traversal_traits<test_map_t> simple_traits_t;
+
+    // The end node need not be part of the node_group, as long as it's next
+    // to a node that is; as for a_star(), it's reached from there.
+    test_map_t small_map;
+    for (uint32_t x = 0 ; x < 5 ; ++x) {
+      for (uint32_t y = 0 ; y < 5 ; ++y) {
+        small_map(x, y) = test_node();
+      }
+    }
+
+    cg::vector_t start(4, 4);
+    cg::vector_t end(0, -1);
+    simple_traits_t stt;
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, small_map, start,
+          end, stt, &cgph::diagonal<test_map_t, simple_traits_t>));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::jump_point_search(result, small_map,
+          start, end, stt, &cgph::diagonal<test_map_t, simple_traits_t>));
+    CPPUNIT_ASSERT_EQUAL(start, result.front());
+    CPPUNIT_ASSERT_EQUAL(end, result.back());
+    CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+  }
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JumpPointSearchTest);
@@ -0,0 +1,243 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/landmarks.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+namespace
+{
+
+char const * const TEST_FILE = "landmarks_tests.tmp";
+
+} // anonymous namespace
+
+
+template <
+  typename tile_traitsT
+>
+class LandmarksTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(LandmarksTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testCosts);
+    CPPUNIT_TEST(testFindPath);
+    CPPUNIT_TEST(testSaveLoad);
+    CPPUNIT_TEST(testInvalid);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+    std::remove(TEST_FILE);
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef lookup_traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::landmark_table<
+    test_map_t,
+    traits_t
+  > landmark_table_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  /**
+   * Returns the costs of the cheapest path between the given nodes, or -1 if
+   * there is none.
+   **/
+  cartograph::unit_t
+  cheapest_path(traits_t & traits, cartograph::vector_t const & from,
+      cartograph::vector_t const & to)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    std::deque<cg::vector_t> path;
+    if (cg::CG_OK != cgp::bidirectional_a_star(path, test_map, from, to,
+          traits, &cgph::dijkstra<test_map_t, traits_t>))
+    {
+      return -1;
+    }
+    return path_cost<tile_traitsT>(path, traits);
+  }
+
+public:
+
+  void testCosts()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    landmark_table_t table(test_map);
+
+    std::vector<cg::vector_t> landmarks;
+    landmarks.push_back(cg::vector_t(2, 48));
+    landmarks.push_back(cg::vector_t(26, 24));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, table.compute(tt, landmarks, 3));
+    CPPUNIT_ASSERT(landmarks == table.landmarks());
+
+    for (std::size_t i = 0 ; i < landmarks.size() ; ++i) {
+      CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), table.cost_from(i, landmarks[i]));
+      CPPUNIT_ASSERT_EQUAL(cg::unit_t(0), table.cost_to(i, landmarks[i]));
+
+      CPPUNIT_ASSERT_EQUAL(cheapest_path(tt, landmarks[i], start),
+          table.cost_from(i, start));
+      CPPUNIT_ASSERT_EQUAL(cheapest_path(tt, end, landmarks[i]),
+          table.cost_to(i, end));
+    }
+
+    // The wall can't be entered, so there are no costs from a landmark to it;
+    // and there are no costs outside the map.
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, table.cost_from(0,
+          cg::vector_t(25, 24)));
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, table.cost_from(0,
+          cg::vector_t(200, 200)));
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, table.cost_from(2, start));
+  }
+
+
+  void testFindPath()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    landmark_table_t table(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, table.compute(tt, 4));
+    CPPUNIT_ASSERT(!table.landmarks().empty());
+    CPPUNIT_ASSERT(table.landmarks().size() <= 4);
+
+    // The estimate can't exceed the real costs.
+    cgph::landmark_heuristic<test_map_t, traits_t> heuristic(table);
+    cg::unit_t cost = cheapest_path(tt, start, end);
+    CPPUNIT_ASSERT(cost > 0);
+    CPPUNIT_ASSERT(heuristic(test_map, start, start, end, tt) <= cost);
+    CPPUNIT_ASSERT(heuristic(test_map, start, start, end, tt) > 0);
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, test_map, start, end,
+          tt, heuristic));
+    CPPUNIT_ASSERT_EQUAL(start, result.front());
+    CPPUNIT_ASSERT_EQUAL(end, result.back());
+
+    // a_star() enters the end node even if the traversal traits don't allow
+    // it, but the table has no costs for such nodes; the estimate falls back
+    // to zero.
+    cg::vector_t wall(25, 24);
+    while (!test_map.is_valid(wall)) {
+      ++wall.m_y;
+    }
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, table.cost_from(0, wall));
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0),
+        heuristic(test_map, start, start, wall, tt));
+    CPPUNIT_ASSERT_EQUAL(cg::unit_t(0),
+        heuristic(test_map, start, cg::vector_t(24, 24), wall, tt));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, test_map, start, wall,
+          tt, heuristic));
+    CPPUNIT_ASSERT_EQUAL(wall, result.back());
+  }
+
+
+  void testSaveLoad()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    landmark_table_t table(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, table.compute(tt, 3));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, table.save(TEST_FILE));
+
+    landmark_table_t loaded(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, loaded.load(TEST_FILE));
+    CPPUNIT_ASSERT(table.landmarks() == loaded.landmarks());
+
+    for (cg::unit_t y = 0 ; y < 50 ; ++y) {
+      for (cg::unit_t x = 0 ; x < 50 ; ++x) {
+        cg::vector_t coords(x, y);
+        for (std::size_t i = 0 ; i < table.landmarks().size() ; ++i) {
+          CPPUNIT_ASSERT_EQUAL(table.cost_from(i, coords),
+              loaded.cost_from(i, coords));
+          CPPUNIT_ASSERT_EQUAL(table.cost_to(i, coords),
+              loaded.cost_to(i, coords));
+        }
+      }
+    }
+
+    // Tables for a map with different bounds are refused.
+    test_map(60, 60) = test_node();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, loaded.load(TEST_FILE));
+    CPPUNIT_ASSERT(table.landmarks() == loaded.landmarks());
+
+    std::remove(TEST_FILE);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_IO_ERROR, loaded.load(TEST_FILE));
+  }
+
+
+  void testInvalid()
+  {
+    namespace cg = cartograph;
+
+    traits_t tt(test_map);
+    landmark_table_t table(test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, table.compute(tt, 0));
+
+    std::vector<cg::vector_t> landmarks;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, table.compute(tt, landmarks));
+
+    landmarks.push_back(cg::vector_t(200, 200));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, table.compute(tt, landmarks));
+    CPPUNIT_ASSERT(table.landmarks().empty());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LandmarksTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(LandmarksTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(LandmarksTest<cartograph::hexagonal_tile_traits>);
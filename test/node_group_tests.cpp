@@ -19,6 +19,7 @@
  * author with your specific requirements.
  **/
 
+#include <algorithm>
 #include <sstream>
 #include <set>
 
@@ -90,6 +91,9 @@ public:
     CPPUNIT_TEST(testBoundary);
     CPPUNIT_TEST(testMoving);
     CPPUNIT_TEST(testErase);
+    CPPUNIT_TEST(testShrinking);
+    CPPUNIT_TEST(testTryGet);
+    CPPUNIT_TEST(testVersions);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -284,6 +288,167 @@ private:
   }
 
 
+  void testShrinking()
+  {
+    namespace cg = cartograph;
+
+    // Peel off the outermost rows and columns of nodes, alternating between
+    // the bottom left and the top right; the boundary must always enclose
+    // the remaining nodes tightly.
+    for (cg::unit_t i = 0 ; i < 25 ; ++i) {
+      for (cg::unit_t j = 0 ; j < 50 ; ++j) {
+        empty_test_map.erase(i, j);
+        empty_test_map.erase(j, i);
+      }
+      assertTightBounds();
+
+      for (cg::unit_t j = 0 ; j < 50 ; ++j) {
+        empty_test_map.erase(49 - i, j);
+        empty_test_map.erase(j, 49 - i);
+      }
+      assertTightBounds();
+    }
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), empty_test_map.size());
+    CPPUNIT_ASSERT_EQUAL(empty_test_map_t().min_coords(),
+        empty_test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(empty_test_map_t().max_coords(),
+        empty_test_map.max_coords());
+  }
+
+
+  void testTryGet()
+  {
+    namespace cg = cartograph;
+
+    empty_test_map_t const & const_map = empty_test_map;
+
+    // Nodes are found with the same data node instances refer to.
+    typename empty_test_map_t::node n = empty_test_map(5, 5);
+    CPPUNIT_ASSERT(const_map.try_get(5, 5));
+    CPPUNIT_ASSERT(n.get() == const_map.try_get(cg::vector_t(5, 5)));
+    CPPUNIT_ASSERT_EQUAL(n.get(), empty_test_map.try_get(5, 5));
+
+    cg::directions_t const * d = n.available_dirs(cg::ALL_JOIN_TYPES);
+    for ( ; *d != cg::DIR_END ; ++d) {
+      CPPUNIT_ASSERT_EQUAL(n.get_relative(*d).get(),
+          empty_test_map.try_get_relative(n.coordinates(), *d));
+      CPPUNIT_ASSERT(n.get_relative(*d).get()
+          == const_map.try_get_relative(n.coordinates(), *d));
+    }
+    CPPUNIT_ASSERT(!const_map.try_get_relative(n.coordinates(), cg::DIR_END));
+
+    // Neighbours that aren't part of the map yield no data either.
+    typename empty_test_map_t::node lone = empty_test_map(300, 300);
+    d = lone.available_dirs(cg::ALL_JOIN_TYPES);
+    for ( ; *d != cg::DIR_END ; ++d) {
+      CPPUNIT_ASSERT(!const_map.try_get_relative(lone.coordinates(), *d));
+    }
+
+    // Empty positions and invalid coordinates yield no data, but don't use up
+    // ids, or throw.
+    typename empty_test_map_t::node_id_t id = empty_test_map(100, 100).id();
+    for (cg::unit_t x = 102 ; x < 200 ; x += 2) {
+      CPPUNIT_ASSERT(!const_map.try_get(x, 100));
+    }
+    CPPUNIT_ASSERT(!const_map.try_get(cg::invalid_vector));
+    CPPUNIT_ASSERT_EQUAL(id + 1, empty_test_map(102, 102).id());
+  }
+
+
+  void assertTightBounds()
+  {
+    namespace cg = cartograph;
+
+    cg::vector_t min;
+    cg::vector_t max;
+    for (cg::unit_t x = 0 ; x < 50 ; ++x) {
+      for (cg::unit_t y = 0 ; y < 50 ; ++y) {
+        if (empty_test_map.is_empty(x, y)) {
+          continue;
+        }
+        if (min == cg::invalid_vector) {
+          min = max = cg::vector_t(x, y);
+          continue;
+        }
+        min.m_x = std::min(min.m_x, x);
+        min.m_y = std::min(min.m_y, y);
+        max.m_x = std::max(max.m_x, x);
+        max.m_y = std::max(max.m_y, y);
+      }
+    }
+
+    if (min == cg::invalid_vector) {
+      return;
+    }
+    CPPUNIT_ASSERT_EQUAL(min, empty_test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(max + cg::vector_t(1, 1),
+        empty_test_map.max_coords());
+  }
+
+
+  void testVersions()
+  {
+    namespace cg = cartograph;
+
+    typedef typename empty_test_map_t::version_t version_t;
+    cg::vector_t region = empty_test_map_t::region_of(cg::vector_t(0, 0));
+    cg::vector_t other = empty_test_map_t::region_of(cg::vector_t(49, 49));
+    CPPUNIT_ASSERT(region != other);
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(-1, -1),
+        empty_test_map_t::region_of(cg::vector_t(-1, -1)));
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(-1, 0), empty_test_map_t::region_of(
+          cg::vector_t(-empty_test_map_t::REGION_SIZE, 0)));
+
+    // Every change bumps the version, but only for the affected regions.
+    version_t version = empty_test_map.version();
+    version_t other_version = empty_test_map.region_version(other);
+    CPPUNIT_ASSERT(version > 0);
+    CPPUNIT_ASSERT(other_version <= version);
+
+    CPPUNIT_ASSERT_EQUAL(true, empty_test_map.erase(0, 0));
+    CPPUNIT_ASSERT(empty_test_map.version() > version);
+    CPPUNIT_ASSERT_EQUAL(empty_test_map.version(),
+        empty_test_map.region_version(region));
+    CPPUNIT_ASSERT_EQUAL(other_version, empty_test_map.region_version(other));
+
+    version = empty_test_map.version();
+    CPPUNIT_ASSERT_EQUAL(true, empty_test_map.move(cg::vector_t(49, 49),
+          cg::vector_t(0, 0)));
+    CPPUNIT_ASSERT(empty_test_map.version() > version);
+    CPPUNIT_ASSERT(empty_test_map.region_version(region) > version);
+    CPPUNIT_ASSERT(empty_test_map.region_version(other) > version);
+
+    version = empty_test_map.version();
+    empty_test_map(49, 49) = empty_test_node();
+    CPPUNIT_ASSERT(empty_test_map.version() > version);
+    empty_test_map.touch(cg::vector_t(49, 49));
+    CPPUNIT_ASSERT(empty_test_map.version() > version + 1);
+
+    // Failed changes don't count.
+    version = empty_test_map.version();
+    CPPUNIT_ASSERT_EQUAL(false, empty_test_map.erase(200, 200));
+    CPPUNIT_ASSERT_EQUAL(version, empty_test_map.version());
+
+    // Clearing affects all regions, even those without nodes.
+    empty_test_map.clear();
+    CPPUNIT_ASSERT(empty_test_map.version() > version);
+    CPPUNIT_ASSERT_EQUAL(empty_test_map.version(),
+        empty_test_map.region_version(cg::vector_t(100, 100)));
+
+    // Each region keeps its own version, however many regions change.
+    cg::unit_t const size = empty_test_map_t::REGION_SIZE;
+    for (cg::unit_t i = -20 ; i < 20 ; ++i) {
+      empty_test_map.touch(cg::vector_t(i * size, -i * size));
+    }
+    version = empty_test_map.version();
+    for (cg::unit_t i = -20 ; i < 20 ; ++i) {
+      CPPUNIT_ASSERT_EQUAL(version_t(version + i - 19),
+          empty_test_map.region_version(cg::vector_t(i, -i)));
+    }
+  }
+
+
 };
 
 
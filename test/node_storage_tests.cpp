@@ -0,0 +1,360 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <deque>
+#include <set>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/node_storage.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/pathfinding.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+namespace
+{
+
+struct test_node
+{
+  test_node(int value = 0, bool blocked = false)
+    : m_value(value)
+    , m_blocked(blocked)
+  {
+  }
+
+  int   m_value;
+  bool  m_blocked;
+};
+
+
+
+template <typename mapT>
+struct traversal_traits
+  : public cartograph::pathfinding::simple_traversal_traits<mapT>
+{
+  traversal_traits(mapT const & m)
+    : m_map(m)
+  {
+  }
+
+  bool
+  is_impassable(cartograph::vector_t const & coords,
+      cartograph::directions_t const & d)
+  {
+    return m_map(coords).get_relative(d)->m_blocked;
+  }
+
+
+  mapT const & m_map;
+};
+
+} // anonymous namespace
+
+
+template <
+  typename storageT
+>
+class NodeStorageTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(NodeStorageTest<storageT>);
+
+    CPPUNIT_TEST(testData);
+    CPPUNIT_TEST(testBoundary);
+    CPPUNIT_TEST(testMoving);
+    CPPUNIT_TEST(testErase);
+    CPPUNIT_TEST(testChurn);
+    CPPUNIT_TEST(testCachedData);
+    CPPUNIT_TEST(testPathfinding);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  typedef cartograph::node_group<
+    test_node,
+    cartograph::rectangular_tile_traits,
+    cartograph::simple_id_generator,
+    storageT
+  > test_map_t;
+
+  // Reference node_group with the default storage.
+  typedef cartograph::node_group<
+    test_node,
+    cartograph::rectangular_tile_traits
+  > reference_map_t;
+
+  void setUp()
+  {
+    // Span several chunks, including some at negative coordinates.
+    for (int x = -40 ; x < 40 ; ++x) {
+      for (int y = -40 ; y < 40 ; ++y) {
+        test_node data((x * 100) + y, x == 0 && y > -35 && y < 35);
+        test_map(x, y) = data;
+        reference_map(x, y) = data;
+      }
+    }
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+    reference_map.clear();
+  }
+
+
+  test_map_t      test_map;
+  reference_map_t reference_map;
+
+private:
+
+  void testData()
+  {
+    namespace cg = cartograph;
+
+    CPPUNIT_ASSERT_EQUAL(std::size_t(80 * 80), test_map.size());
+
+    std::set<typename test_map_t::node_id_t> ids;
+    for (int x = -40 ; x < 40 ; ++x) {
+      for (int y = -40 ; y < 40 ; ++y) {
+        CPPUNIT_ASSERT(!test_map.is_empty(x, y));
+        typename test_map_t::node n = test_map(x, y);
+        CPPUNIT_ASSERT(n);
+        CPPUNIT_ASSERT_EQUAL((x * 100) + y, n->m_value);
+        ids.insert(n.id());
+      }
+    }
+    CPPUNIT_ASSERT_EQUAL(test_map.size(), ids.size());
+
+    // Empty positions have no data, until some is assigned.
+    CPPUNIT_ASSERT(test_map.is_empty(100, -100));
+    typename test_map_t::node n = test_map(100, -100);
+    CPPUNIT_ASSERT(!n);
+    CPPUNIT_ASSERT(!n.get());
+    n = test_node(42);
+    CPPUNIT_ASSERT(n);
+    CPPUNIT_ASSERT_EQUAL(42, n->m_value);
+    CPPUNIT_ASSERT(!test_map.is_empty(100, -100));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(80 * 80 + 1), test_map.size());
+
+    // Assigning again overwrites the data.
+    n = test_node(43);
+    CPPUNIT_ASSERT_EQUAL(43, test_map(100, -100)->m_value);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(80 * 80 + 1), test_map.size());
+
+    // Data can be modified in place.
+    test_map(-1, -1)->m_value = 7;
+    CPPUNIT_ASSERT_EQUAL(7, test_map(-1, -1)->m_value);
+  }
+
+
+  void testBoundary()
+  {
+    namespace cg = cartograph;
+
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(-40, -40), test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(40, 40), test_map.max_coords());
+
+    test_map(-100, 3) = test_node();
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(-100, -40), test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(40, 40), test_map.max_coords());
+
+    test_map.clear();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), test_map.size());
+    CPPUNIT_ASSERT_EQUAL(reference_map_t().min_coords(),
+        test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(reference_map_t().max_coords(),
+        test_map.max_coords());
+  }
+
+
+  void testMoving()
+  {
+    namespace cg = cartograph;
+
+    // Moving keeps the node's data and id.
+    typename test_map_t::node n = test_map(1, 1);
+    typename test_map_t::node_id_t id = n.id();
+    CPPUNIT_ASSERT_EQUAL(true, n.move_to(100, 100));
+    CPPUNIT_ASSERT(test_map.is_empty(1, 1));
+    CPPUNIT_ASSERT_EQUAL(101, n->m_value);
+    CPPUNIT_ASSERT_EQUAL(id, test_map(100, 100).id());
+    CPPUNIT_ASSERT_EQUAL(101, test_map(100, 100)->m_value);
+    CPPUNIT_ASSERT_EQUAL(cg::vector_t(101, 101), test_map.max_coords());
+
+    // Other node instances still find the node after it was moved through
+    // the node_group.
+    typename test_map_t::node other = test_map(100, 100);
+    CPPUNIT_ASSERT_EQUAL(true, test_map.move(cg::vector_t(100, 100),
+          cg::vector_t(-50, 2)));
+    CPPUNIT_ASSERT(other);
+    CPPUNIT_ASSERT_EQUAL(101, other->m_value);
+    CPPUNIT_ASSERT_EQUAL(101, n->m_value);
+
+    // Moves to occupied positions or from empty ones fail.
+    CPPUNIT_ASSERT_EQUAL(false, test_map.move(cg::vector_t(-50, 2),
+          cg::vector_t(2, 2)));
+    CPPUNIT_ASSERT_EQUAL(false, test_map.move(cg::vector_t(1, 1),
+          cg::vector_t(1, 2)));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(80 * 80), test_map.size());
+
+    // A new node at the old position is a different node.
+    test_map(100, 100) = test_node(5);
+    CPPUNIT_ASSERT_EQUAL(101, other->m_value);
+    CPPUNIT_ASSERT_EQUAL(5, test_map(100, 100)->m_value);
+  }
+
+
+  void testErase()
+  {
+    namespace cg = cartograph;
+
+    typename test_map_t::node n = test_map(-39, 39);
+    CPPUNIT_ASSERT_EQUAL(true, test_map.erase(-39, 39));
+    CPPUNIT_ASSERT_EQUAL(false, test_map.erase(-39, 39));
+    CPPUNIT_ASSERT(test_map.is_empty(-39, 39));
+    CPPUNIT_ASSERT(!n);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(80 * 80 - 1), test_map.size());
+
+    // Erasing a moved node leaves no trace of it.
+    typename test_map_t::node m = test_map(3, 3);
+    CPPUNIT_ASSERT_EQUAL(true, test_map.move(cg::vector_t(3, 3),
+          cg::vector_t(60, 60)));
+    CPPUNIT_ASSERT_EQUAL(true, test_map.erase(60, 60));
+    CPPUNIT_ASSERT(!m);
+    CPPUNIT_ASSERT(!test_map(60, 60));
+  }
+
+
+  void testChurn()
+  {
+    namespace cg = cartograph;
+
+    // Mix inserts, moves and erases at pseudo-random positions, and compare
+    // the result with the reference map.
+    unsigned int seed = 12345;
+    for (int i = 0 ; i < 20000 ; ++i) {
+      seed = seed * 1103515245 + 12345;
+      cg::vector_t from(int((seed >> 8) % 120) - 60,
+          int((seed >> 16) % 120) - 60);
+      seed = seed * 1103515245 + 12345;
+      cg::vector_t to(int((seed >> 8) % 120) - 60,
+          int((seed >> 16) % 120) - 60);
+
+      switch ((seed >> 24) % 3) {
+        case 0:
+          test_map(from) = test_node(i);
+          reference_map(from) = test_node(i);
+          break;
+
+        case 1:
+          CPPUNIT_ASSERT_EQUAL(reference_map.move(from, to),
+              test_map.move(from, to));
+          break;
+
+        default:
+          CPPUNIT_ASSERT_EQUAL(reference_map.erase(from.m_x, from.m_y),
+              test_map.erase(from.m_x, from.m_y));
+          break;
+      }
+    }
+
+    CPPUNIT_ASSERT_EQUAL(reference_map.size(), test_map.size());
+    CPPUNIT_ASSERT_EQUAL(reference_map.min_coords(), test_map.min_coords());
+    CPPUNIT_ASSERT_EQUAL(reference_map.max_coords(), test_map.max_coords());
+    for (int x = -60 ; x < 60 ; ++x) {
+      for (int y = -60 ; y < 60 ; ++y) {
+        CPPUNIT_ASSERT_EQUAL(reference_map.is_empty(x, y),
+            test_map.is_empty(x, y));
+        if (!reference_map.is_empty(x, y)) {
+          CPPUNIT_ASSERT_EQUAL(reference_map(x, y)->m_value,
+              test_map(x, y)->m_value);
+        }
+      }
+    }
+  }
+
+
+  void testCachedData()
+  {
+    namespace cg = cartograph;
+
+    // Node instances see changes made through other node instances, or
+    // the node_group, after they last looked at the node's data.
+    typename test_map_t::node n = test_map(5, 5);
+    typename test_map_t::node other = test_map(5, 5);
+    CPPUNIT_ASSERT_EQUAL(505, n->m_value);
+    other = test_node(6);
+    CPPUNIT_ASSERT_EQUAL(6, n->m_value);
+
+    // Adding lots of nodes may relocate the data of existing ones.
+    for (int x = 100 ; x < 200 ; ++x) {
+      for (int y = 100 ; y < 200 ; ++y) {
+        test_map(x, y) = test_node(x);
+      }
+    }
+    CPPUNIT_ASSERT_EQUAL(6, n->m_value);
+    CPPUNIT_ASSERT_EQUAL(n.get(), other.get());
+
+    CPPUNIT_ASSERT_EQUAL(true, test_map.move(cg::vector_t(5, 5),
+          cg::vector_t(-60, -60)));
+    CPPUNIT_ASSERT_EQUAL(6, n->m_value);
+
+    CPPUNIT_ASSERT_EQUAL(true, test_map.erase(-60, -60));
+    CPPUNIT_ASSERT(!n);
+    CPPUNIT_ASSERT(!other.get());
+
+    test_map.clear();
+    CPPUNIT_ASSERT(!test_map(-1, -1));
+  }
+
+
+  void testPathfinding()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    typedef traversal_traits<reference_map_t> reference_traits_t;
+    traits_t tt(test_map);
+    reference_traits_t reference_tt(reference_map);
+
+    cg::vector_t start(-20, 10);
+    cg::vector_t end(30, -5);
+
+    std::deque<cg::vector_t> result;
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, test_map, start, end,
+          tt, cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, reference_map,
+          start, end, reference_tt,
+          cgph::diagonal_heuristic<reference_map_t, reference_traits_t>()));
+    CPPUNIT_ASSERT(expected == result);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeStorageTest<cartograph::map_storage>);
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeStorageTest<cartograph::chunked_storage>);
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeStorageTest<cartograph::hash_storage>);
@@ -0,0 +1,231 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#include <algorithm>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cartograph/node_group.h>
+#include <cartograph/tile_traits.h>
+#include <cartograph/path_cache.h>
+#include <cartograph/heuristics.h>
+#include <cartograph/traversal_traits.h>
+
+#include "test_maps.h"
+
+
+template <
+  typename tile_traitsT
+>
+class PathCacheTest
+  : public CppUnit::TestFixture
+{
+public:
+  CPPUNIT_TEST_SUITE(PathCacheTest<tile_traitsT>);
+
+    CPPUNIT_TEST(testHits);
+    CPPUNIT_TEST(testInvalidation);
+    CPPUNIT_TEST(testEviction);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp()
+  {
+    namespace cg = cartograph;
+    start = cg::vector_t(4, 4);
+    end = cg::vector_t(45, 37);
+
+    make_wall_map(test_map);
+  }
+
+
+  void tearDown()
+  {
+    test_map.clear();
+  }
+
+
+  typedef cartograph::node_group<test_node, tile_traitsT> test_map_t;
+  typedef traversal_traits<test_map_t> traits_t;
+  typedef cartograph::pathfinding::path_cache<
+    test_map_t,
+    traits_t
+  > cache_t;
+
+  test_map_t test_map;
+
+  cartograph::vector_t start;
+  cartograph::vector_t end;
+
+private:
+
+  void testHits()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    cache_t cache(test_map);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.size());
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, test_map, start,
+          end, tt, &cgph::diagonal<test_map_t, traits_t>));
+
+    // The second search must be answered from the cache, with the same
+    // result.
+    for (std::size_t i = 1 ; i <= 2 ; ++i) {
+      std::deque<cg::vector_t> result;
+      result.push_back(end);
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, end, tt,
+            &cgph::diagonal<test_map_t, traits_t>));
+      CPPUNIT_ASSERT(expected == result);
+      CPPUNIT_ASSERT_EQUAL(i - 1, cache.hits());
+      CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.misses());
+      CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.size());
+    }
+
+    // Other traversal traits, or another end node, are cached separately.
+    traits_t other_tt(test_map);
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, end,
+          other_tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.misses());
+
+    // Failures to find a path are cached, too; invalid coordinates are not.
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cache.find_path(result, start,
+          cg::vector_t(200, 200), tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(result.empty());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cache.find_path(result, start,
+          cg::vector_t(200, 200), tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.hits());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), cache.size());
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, cache.find_path(result, start,
+          cg::invalid_vector, tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), cache.size());
+
+    cache.clear();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.size());
+  }
+
+
+  void testInvalidation()
+  {
+    namespace cg = cartograph;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    cache_t cache(test_map);
+
+    // A short path in one corner of the map...
+    cg::vector_t near(10, 4);
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+
+    // ... is unaffected by changes in the opposite corner.
+    test_map(48, 48) = test_node(true);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.hits());
+
+    // Blocking a node on the path makes it stale, and the new path must avoid
+    // that node.
+    cg::vector_t blocked = result[result.size() / 2];
+    test_map(blocked) = test_node(true);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.hits());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.misses());
+    CPPUNIT_ASSERT(std::find(result.begin(), result.end(), blocked)
+        == result.end());
+
+    // So does erasing one, or moving one.
+    cg::vector_t erased = result[result.size() / 2];
+    CPPUNIT_ASSERT(test_map.erase(erased));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), cache.misses());
+    CPPUNIT_ASSERT(std::find(result.begin(), result.end(), erased)
+        == result.end());
+
+    CPPUNIT_ASSERT(test_map.move(cg::vector_t(48, 48), erased));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), cache.misses());
+    CPPUNIT_ASSERT(std::find(result.begin(), result.end(), erased)
+        == result.end());
+
+    // In-place modifications need to be reported.
+    cg::vector_t modified = result[result.size() / 2];
+    test_map(modified)->m_blocked = true;
+    test_map.touch(modified);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cache.find_path(result, start, near, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>()));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(5), cache.misses());
+    CPPUNIT_ASSERT(std::find(result.begin(), result.end(), modified)
+        == result.end());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.hits());
+  }
+
+
+  void testEviction()
+  {
+    namespace cg = cartograph;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    traits_t tt(test_map);
+    cache_t cache(test_map, 2);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.capacity());
+
+    // Using the first path keeps it in the cache, so the second one is
+    // dropped when the third is cached.
+    std::deque<cg::vector_t> result;
+    cg::vector_t ends[] = {
+      cg::vector_t(10, 4),
+      cg::vector_t(4, 10),
+      cg::vector_t(10, 10),
+    };
+    for (std::size_t i = 0 ; i < 3 ; ++i) {
+      cache.find_path(result, start, ends[i], tt,
+          &cgph::diagonal<test_map_t, traits_t>);
+      cache.find_path(result, start, ends[0], tt,
+          &cgph::diagonal<test_map_t, traits_t>);
+    }
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), cache.misses());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), cache.hits());
+
+    cache.find_path(result, start, ends[2], tt,
+        &cgph::diagonal<test_map_t, traits_t>);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), cache.hits());
+    cache.find_path(result, start, ends[1], tt,
+        &cgph::diagonal<test_map_t, traits_t>);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), cache.misses());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PathCacheTest<cartograph::triangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(PathCacheTest<cartograph::rectangular_tile_traits>);
+CPPUNIT_TEST_SUITE_REGISTRATION(PathCacheTest<cartograph::hexagonal_tile_traits>);
@@ -19,6 +19,7 @@
  * author with your specific requirements.
  **/
 
+#include <algorithm>
 #include <sstream>
 #include <set>
 
@@ -30,53 +31,10 @@
 #include <cartograph/heuristics.h>
 #include <cartograph/traversal_traits.h>
 
-namespace
-{
-
-struct test_node
-{
-  test_node(bool blocked = false)
-    : m_blocked(blocked)
-  {
-  }
+#include "test_maps.h"
 
-  bool m_blocked;
-};
-
-
-
-template <typename mapT>
-struct traversal_traits
-  : public cartograph::pathfinding::simple_traversal_traits<mapT>
+namespace
 {
-  traversal_traits(mapT const & m, bool edges_only = false)
-    : m_map(m)
-    , m_edges_only(edges_only)
-  {
-  }
-
-  bool
-  is_impassable(cartograph::vector_t const & coords,
-      cartograph::directions_t const & d)
-  {
-    return m_map(coords).get_relative(d)->m_blocked;
-  }
-
-
-  cartograph::join_t
-  join_types()
-  {
-    return (m_edges_only ? cartograph::EDGES : cartograph::PATHFINDING_DEFAULT);
-  }
-
-
-  mapT const & m_map;
-  bool m_edges_only;
-};
-
-
-
-
 
 template <
   typename tile_traitsT
@@ -639,6 +597,17 @@ public:
     CPPUNIT_TEST(testDijkstra);
     CPPUNIT_TEST(testDijkstraBlocked);
     CPPUNIT_TEST(testDijkstraBlockedEdgesOnly);
+    CPPUNIT_TEST(testOpenLists);
+    CPPUNIT_TEST(testNodeLookups);
+    CPPUNIT_TEST(testSearchContext);
+    CPPUNIT_TEST(testNoPath);
+    CPPUNIT_TEST(testLimits);
+    CPPUNIT_TEST(testResumableSearch);
+    CPPUNIT_TEST(testBidirectional);
+    CPPUNIT_TEST(testHeuristicFunctors);
+    CPPUNIT_TEST(testMultipleGoals);
+    CPPUNIT_TEST(testWeighted);
+    CPPUNIT_TEST(testAnytime);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -736,6 +705,16 @@ private:
     CPPUNIT_ASSERT(expected.blocked_results == result);
 
     CPPUNIT_ASSERT(expected.unblocked_results.size() < result.size());
+
+    // Looking nodes up via try_get_relative() finds the same path.
+    std::deque<cg::vector_t> lookup_result;
+    lookup_traversal_traits<test_map_t> ltt(blocked_test_map);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(lookup_result,
+          blocked_test_map, start, end, ltt, &cgph::dijkstra<
+                  test_map_t,
+                  lookup_traversal_traits<test_map_t>
+               >));
+    CPPUNIT_ASSERT(expected.blocked_results == lookup_result);
   }
 
 
@@ -763,6 +742,636 @@ private:
   }
 
 
+  template <
+    typename open_listT,
+    typename node_lookupT
+  >
+  cartograph::error_t
+  find_path_with(std::deque<cartograph::vector_t> & result)
+  {
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    traits_t stt(blocked_test_map);
+
+    cgp::detail::node_arena arena;
+    open_listT open_list(arena);
+    node_lookupT nodes;
+    nodes.reset(blocked_test_map.min_coords(), blocked_test_map.max_coords());
+
+    cgp::detail::pathfinder<
+      traits_t, test_map_t, open_listT, node_lookupT
+    > pathfinder(blocked_test_map, start, end, stt,
+        &cgph::diagonal<test_map_t, traits_t>, cgp::search_limits(),
+        arena, open_list, nodes);
+    return pathfinder.find_path(result);
+  }
+
+
+  void testOpenLists()
+  {
+    namespace cg = cartograph;
+    namespace cgpd = cartograph::pathfinding::detail;
+
+    // All open list implementations must yield the same paths.
+    std::deque<cg::vector_t> heap_result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, (find_path_with<
+          cgpd::heap_open_list<>, cgpd::map_node_lookup
+        >(heap_result)));
+
+    std::deque<cg::vector_t> binary_result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, (find_path_with<
+          cgpd::heap_open_list<2>, cgpd::map_node_lookup
+        >(binary_result)));
+
+    std::deque<cg::vector_t> mi_result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, (find_path_with<
+          cgpd::multi_index_open_list, cgpd::map_node_lookup
+        >(mi_result)));
+
+    CPPUNIT_ASSERT(!heap_result.empty());
+    CPPUNIT_ASSERT(heap_result == binary_result);
+    CPPUNIT_ASSERT(heap_result == mi_result);
+  }
+
+
+  void testNodeLookups()
+  {
+    namespace cg = cartograph;
+    namespace cgpd = cartograph::pathfinding::detail;
+
+    // The test maps are dense enough for the dense node lookup.
+    cg::vector_t min = blocked_test_map.min_coords();
+    cg::vector_t max = blocked_test_map.max_coords();
+    CPPUNIT_ASSERT(cgpd::dense_node_lookup::suitable(min, max,
+          blocked_test_map.size(), start));
+    CPPUNIT_ASSERT(!cgpd::dense_node_lookup::suitable(min, max,
+          blocked_test_map.size(), cg::vector_t(-1, 4)));
+    CPPUNIT_ASSERT(!cgpd::dense_node_lookup::suitable(min, max,
+          10, start));
+
+    // Both lookups must yield the same paths.
+    std::deque<cg::vector_t> map_result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, (find_path_with<
+          cgpd::open_list_t, cgpd::map_node_lookup
+        >(map_result)));
+
+    std::deque<cg::vector_t> dense_result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, (find_path_with<
+          cgpd::open_list_t, cgpd::dense_node_lookup
+        >(dense_result)));
+
+    CPPUNIT_ASSERT(map_result == dense_result);
+  }
+
+
+  void testSearchContext()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // Alternate between maps with the same context; each search must yield
+    // the same results as with a fresh context.
+    cgp::search_context context;
+    expected_results<tile_traitsT> expected;
+
+    for (int i = 0 ; i < 3 ; ++i) {
+      std::deque<cg::vector_t> result;
+      cgp::simple_traversal_traits<test_map_t> stt;
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, test_map, start,
+            end, stt, &cgph::dijkstra<
+                    test_map_t,
+                    cgp::simple_traversal_traits<test_map_t>
+                 >, context));
+      CPPUNIT_ASSERT(expected.unblocked_results == result);
+
+      result.clear();
+      traversal_traits<test_map_t> tt(blocked_test_map);
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+            start, end, tt, &cgph::dijkstra<
+                    test_map_t,
+                    traversal_traits<test_map_t>
+                 >, context));
+      CPPUNIT_ASSERT(expected.blocked_results == result);
+    }
+  }
+
+
+  void testNoPath()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // An end node far outside of the map can't be reached; the search must
+    // terminate once it's run out of nodes.
+    std::deque<cg::vector_t> result;
+    cgp::simple_traversal_traits<test_map_t> stt;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cgp::a_star(result, test_map, start,
+          cg::vector_t(200, 200), stt, &cgph::diagonal<
+                  test_map_t,
+                  cgp::simple_traversal_traits<test_map_t>
+               >));
+    CPPUNIT_ASSERT(result.empty());
+  }
+
+
+  void testLimits()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef cgp::simple_traversal_traits<test_map_t> traits_t;
+    traits_t stt;
+
+    // Generous limits must not change the result.
+    cgp::search_limits limits;
+    limits.m_max_expansions = 100000;
+    limits.m_max_open_list_size = 100000;
+    limits.m_max_g_cost = 1000000;
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, test_map, start, end,
+          stt, &cgph::dijkstra<test_map_t, traits_t>, limits));
+    expected_results<tile_traitsT> expected;
+    CPPUNIT_ASSERT(expected.unblocked_results == result);
+
+    // Running out of expansions yields a partial path from the start node
+    // towards the end node, if requested.
+    limits = cgp::search_limits();
+    limits.m_max_expansions = 10;
+    limits.m_return_partial_path = true;
+
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_BUDGET_EXCEEDED, cgp::a_star(result, test_map,
+          start, end, stt, &cgph::diagonal<test_map_t, traits_t>, limits));
+    CPPUNIT_ASSERT(!result.empty());
+    CPPUNIT_ASSERT_EQUAL(start, result.front());
+    CPPUNIT_ASSERT(result.back().distance(end) < start.distance(end));
+
+    // Same for the open list size, but without a partial path.
+    limits = cgp::search_limits();
+    limits.m_max_open_list_size = 10;
+
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_BUDGET_EXCEEDED, cgp::a_star(result, test_map,
+          start, end, stt, &cgph::diagonal<test_map_t, traits_t>, limits));
+    CPPUNIT_ASSERT(result.empty());
+
+    // If the end node is too expensive to reach, the search gives up once it's
+    // processed all cheaper nodes.
+    limits = cgp::search_limits();
+    limits.m_max_g_cost = 5 * stt.average_traversal_cost();
+
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_BUDGET_EXCEEDED, cgp::a_star(result, test_map,
+          start, end, stt, &cgph::diagonal<test_map_t, traits_t>, limits));
+  }
+
+
+  void testResumableSearch()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef cgp::simple_traversal_traits<test_map_t> traits_t;
+    typedef traversal_traits<test_map_t> blocked_traits_t;
+    expected_results<tile_traitsT> expected;
+
+    // Interleave two searches in small steps; both must yield the same result
+    // as a_star().
+    traits_t stt;
+    blocked_traits_t tt(blocked_test_map);
+    cgp::search_context context;
+
+    typedef cgph::dijkstra_heuristic<test_map_t, traits_t> heuristic_t;
+    typedef cgph::dijkstra_heuristic<
+      test_map_t,
+      blocked_traits_t
+    > blocked_heuristic_t;
+
+    cgp::resumable_search<test_map_t, traits_t, heuristic_t> unblocked(
+        test_map, start, end, stt, heuristic_t());
+    cgp::resumable_search<test_map_t, blocked_traits_t, blocked_heuristic_t>
+      blocked(blocked_test_map, start, end, tt, blocked_heuristic_t(),
+          cgp::search_limits(), context);
+
+    std::size_t steps = 0;
+    while (cgp::SEARCH_IN_PROGRESS == unblocked.state()
+        || cgp::SEARCH_IN_PROGRESS == blocked.state())
+    {
+      unblocked.step(7);
+      blocked.step(7);
+      ++steps;
+    }
+    CPPUNIT_ASSERT(steps > 1);
+
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, unblocked.step(7));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, unblocked.error());
+    CPPUNIT_ASSERT(expected.unblocked_results == unblocked.path());
+
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, blocked.state());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, blocked.error());
+    CPPUNIT_ASSERT(expected.blocked_results == blocked.path());
+
+    // Failures are reported the same way as by a_star(). Heuristics chosen
+    // at runtime work, too.
+    typedef typename cgp::heuristic_function<
+      test_map_t,
+      traits_t
+    >::type function_t;
+    cgp::resumable_search<test_map_t, traits_t, function_t> no_path(test_map,
+        start, cg::vector_t(200, 200), stt,
+        function_t(&cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_IN_PROGRESS, no_path.step(1));
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FAILED, no_path.step(0));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, no_path.error());
+    CPPUNIT_ASSERT(no_path.path().empty());
+  }
+
+
+  void testBidirectional()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef cgp::simple_traversal_traits<test_map_t> traits_t;
+    typedef traversal_traits<test_map_t> blocked_traits_t;
+    traits_t stt;
+    blocked_traits_t tt(blocked_test_map);
+
+    // Without a heuristic, both a_star() and bidirectional_a_star() yield a
+    // shortest path - not necessarily the same one.
+    cgp::search_context context;
+    for (int i = 0 ; i < 2 ; ++i) {
+      std::deque<cg::vector_t> expected;
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, test_map, start,
+            end, stt, &cgph::dijkstra<test_map_t, traits_t>));
+
+      std::deque<cg::vector_t> result;
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(result,
+            test_map, start, end, stt, &cgph::dijkstra<test_map_t, traits_t>,
+            context));
+      CPPUNIT_ASSERT_EQUAL(start, result.front());
+      CPPUNIT_ASSERT_EQUAL(end, result.back());
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, stt) >= 0);
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, stt)
+          <= path_cost<tile_traitsT>(expected, stt));
+
+      expected.clear();
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, blocked_test_map,
+            start, end, tt, &cgph::dijkstra<test_map_t, blocked_traits_t>));
+
+      result.clear();
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(result,
+            blocked_test_map, start, end, tt,
+            &cgph::dijkstra<test_map_t, blocked_traits_t>, context));
+      CPPUNIT_ASSERT_EQUAL(start, result.front());
+      CPPUNIT_ASSERT_EQUAL(end, result.back());
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, tt) >= 0);
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, tt)
+          <= path_cost<tile_traitsT>(expected, tt));
+    }
+
+    // Start and end being the same yields a single node path.
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(result,
+          test_map, start, start, stt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), result.size());
+    CPPUNIT_ASSERT_EQUAL(start, result.front());
+
+    // An unreachable end node is detected as soon as the backward search runs
+    // out of nodes.
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cgp::bidirectional_a_star(result,
+          test_map, start, cg::vector_t(200, 200), stt,
+          &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(result.empty());
+  }
+
+
+  template <
+    typename heuristicT,
+    typename functorT
+  >
+  void
+  check_heuristic(heuristicT const & heuristic, functorT const & functor)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    traits_t tt(blocked_test_map);
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, blocked_test_map,
+          start, end, tt, heuristic));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+          start, end, tt, functor));
+    CPPUNIT_ASSERT(expected == result);
+
+    typename cgp::heuristic_function<test_map_t, traits_t>::type erased
+      = functor;
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+          start, end, tt, erased));
+    CPPUNIT_ASSERT(expected == result);
+
+    // Once prepared, the function object must estimate the same values as the
+    // function does.
+    functorT prepared(functor);
+    prepared.prepare(blocked_test_map, start, end, tt);
+    for (cg::unit_t y = 0 ; y < 10 ; ++y) {
+      for (cg::unit_t x = 0 ; x < 10 ; ++x) {
+        cg::vector_t current(x, y);
+        CPPUNIT_ASSERT_EQUAL(heuristic(blocked_test_map, start, current, end,
+              tt), prepared(current));
+      }
+    }
+  }
+
+
+  void testHeuristicFunctors()
+  {
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    // Function pointers, function objects and type-erased heuristics must all
+    // yield the same results.
+    typedef traversal_traits<test_map_t> traits_t;
+    check_heuristic(&cgph::dijkstra<test_map_t, traits_t>,
+        cgph::dijkstra_heuristic<test_map_t, traits_t>());
+    check_heuristic(&cgph::diagonal<test_map_t, traits_t>,
+        cgph::diagonal_heuristic<test_map_t, traits_t>());
+    check_heuristic(&cgph::diagonal_tiebreaker<test_map_t, traits_t>,
+        cgph::diagonal_tiebreaker_heuristic<test_map_t, traits_t>());
+
+    // Functions may also be passed by name, without taking their address.
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+
+    traits_t tt(blocked_test_map);
+
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, blocked_test_map,
+          start, end, tt, &cgph::diagonal<test_map_t, traits_t>));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+          start, end, tt, cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(expected == result);
+
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::weighted_a_star(result,
+          blocked_test_map, start, end, tt,
+          cgph::diagonal<test_map_t, traits_t>, 1.0));
+    CPPUNIT_ASSERT_EQUAL(path_cost<tile_traitsT>(expected, tt),
+        path_cost<tile_traitsT>(result, tt));
+
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(result,
+          blocked_test_map, start, end, tt,
+          cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(path_cost<tile_traitsT>(expected, tt),
+        path_cost<tile_traitsT>(result, tt));
+
+    std::vector<cg::vector_t> goals(1, end);
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+          start, goals, tt, cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(path_cost<tile_traitsT>(expected, tt),
+        path_cost<tile_traitsT>(result, tt));
+  }
+
+
+  void testMultipleGoals()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    traits_t tt(blocked_test_map);
+
+    // The cheapest path to any of the goals must be as cheap as the cheapest
+    // of the paths to each goal.
+    std::vector<cg::vector_t> goals;
+    goals.push_back(end);
+    goals.push_back(cg::vector_t(30, 2));
+    goals.push_back(cg::vector_t(24, 20));
+    goals.push_back(end);
+
+    cg::unit_t cheapest = -1;
+    for (std::size_t i = 0 ; i < goals.size() ; ++i) {
+      std::deque<cg::vector_t> path;
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(path,
+            blocked_test_map, start, goals[i], tt,
+            &cgph::dijkstra<test_map_t, traits_t>));
+      cg::unit_t cost = path_cost<tile_traitsT>(path, tt);
+      if (cheapest < 0 || cost < cheapest) {
+        cheapest = cost;
+      }
+    }
+
+    cgp::search_context context;
+    for (int i = 0 ; i < 2 ; ++i) {
+      std::deque<cg::vector_t> result;
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+            start, goals, tt, cgph::diagonal_heuristic<test_map_t, traits_t>(),
+            context));
+      CPPUNIT_ASSERT_EQUAL(start, result.front());
+      CPPUNIT_ASSERT(std::find(goals.begin(), goals.end(), result.back())
+          != goals.end());
+      CPPUNIT_ASSERT_EQUAL(cheapest, path_cost<tile_traitsT>(result, tt));
+    }
+
+    // Starting at a goal yields just that node.
+    std::deque<cg::vector_t> result;
+    goals.push_back(start);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(result, blocked_test_map,
+          start, goals, tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), result.size());
+
+    // Invalid or no goals.
+    goals.push_back(cg::invalid_vector);
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, cgp::a_star(result,
+          blocked_test_map, start, goals, tt,
+          &cgph::diagonal<test_map_t, traits_t>));
+    goals.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_COORDS, cgp::a_star(result,
+          blocked_test_map, start, goals, tt,
+          &cgph::diagonal<test_map_t, traits_t>));
+
+    // Unreachable goals.
+    goals.push_back(cg::vector_t(200, 200));
+    goals.push_back(cg::vector_t(202, 200));
+    result.clear();
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, cgp::a_star(result, blocked_test_map,
+          start, goals, tt, &cgph::diagonal<test_map_t, traits_t>));
+    CPPUNIT_ASSERT(result.empty());
+  }
+
+
+  template <typename traitsT>
+  cartograph::unit_t
+  cheapest_path_cost(test_map_t const & map, traitsT & traits)
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    std::deque<cg::vector_t> path;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::bidirectional_a_star(path, map,
+          start, end, traits, &cgph::dijkstra<test_map_t, traitsT>));
+    return path_cost<tile_traitsT>(path, traits);
+  }
+
+
+  void testWeighted()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    traits_t tt(blocked_test_map);
+    cg::unit_t cheapest = cheapest_path_cost(blocked_test_map, tt);
+
+    // A weight of 1 is plain A*.
+    std::deque<cg::vector_t> expected;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::a_star(expected, blocked_test_map,
+          start, end, tt, cgph::diagonal_heuristic<test_map_t, traits_t>()));
+
+    std::deque<cg::vector_t> result;
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::weighted_a_star(result,
+          blocked_test_map, start, end, tt,
+          cgph::diagonal_heuristic<test_map_t, traits_t>(), 1.0));
+    CPPUNIT_ASSERT(expected == result);
+
+    // Higher weights yield paths within the bound.
+    cgp::search_context context;
+    for (int weight = 2 ; weight <= 4 ; ++weight) {
+      result.clear();
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, cgp::weighted_a_star(result,
+            blocked_test_map, start, end, tt,
+            &cgph::diagonal<test_map_t, traits_t>, weight, context));
+      CPPUNIT_ASSERT_EQUAL(start, result.front());
+      CPPUNIT_ASSERT_EQUAL(end, result.back());
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, tt) >= cheapest);
+      CPPUNIT_ASSERT(path_cost<tile_traitsT>(result, tt) <= weight * cheapest);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, cgp::weighted_a_star(result,
+          blocked_test_map, start, end, tt,
+          &cgph::diagonal<test_map_t, traits_t>, 0.5));
+  }
+
+
+  void testAnytime()
+  {
+    namespace cg = cartograph;
+    namespace cgp = cartograph::pathfinding;
+    namespace cgph = cartograph::pathfinding::heuristics;
+
+    typedef traversal_traits<test_map_t> traits_t;
+    typedef cgph::diagonal_heuristic<test_map_t, traits_t> heuristic_t;
+    typedef cgp::anytime_search<test_map_t, traits_t, heuristic_t> search_t;
+    traits_t tt(blocked_test_map);
+    cg::unit_t cheapest = cheapest_path_cost(blocked_test_map, tt);
+
+    // Each path found must be within the reported bound, and no worse than
+    // the previous one; the last one must be a cheapest path.
+    cgp::search_context context;
+    search_t search(blocked_test_map, start, end, tt, heuristic_t(), 3.0, 0.5,
+        context);
+    CPPUNIT_ASSERT(search.path().empty());
+    CPPUNIT_ASSERT_EQUAL(cg::invalid_unit, search.path_cost());
+    CPPUNIT_ASSERT_EQUAL(3.0, search.weight());
+
+    double bound = 0;
+    cg::unit_t cost = 0;
+    std::size_t iterations = 0;
+    while (cgp::SEARCH_IN_PROGRESS == search.step(0)) {
+      CPPUNIT_ASSERT_EQUAL(cg::CG_OK, search.error());
+      CPPUNIT_ASSERT_EQUAL(start, search.path().front());
+      CPPUNIT_ASSERT_EQUAL(end, search.path().back());
+      CPPUNIT_ASSERT_EQUAL(search.path_cost(),
+          path_cost<tile_traitsT>(search.path(), tt));
+      CPPUNIT_ASSERT(search.bound() > 1);
+      CPPUNIT_ASSERT(search.path_cost() <= search.bound() * cheapest);
+      if (iterations++) {
+        CPPUNIT_ASSERT(search.bound() <= bound);
+        CPPUNIT_ASSERT(search.path_cost() <= cost);
+      }
+      bound = search.bound();
+      cost = search.path_cost();
+    }
+    CPPUNIT_ASSERT(iterations <= 4);
+
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, search.state());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_OK, search.error());
+    CPPUNIT_ASSERT_EQUAL(1.0, search.bound());
+    CPPUNIT_ASSERT_EQUAL(cheapest, search.path_cost());
+    CPPUNIT_ASSERT_EQUAL(cheapest, path_cost<tile_traitsT>(search.path(), tt));
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, search.step(0));
+
+    // Small steps end up with the same result, as do heuristics chosen at
+    // runtime.
+    typedef typename cgp::heuristic_function<
+      test_map_t,
+      traits_t
+    >::type function_t;
+    cgp::anytime_search<test_map_t, traits_t, function_t> small_steps(
+        blocked_test_map, start, end, tt,
+        function_t(&cgph::diagonal<test_map_t, traits_t>));
+    std::size_t steps = 0;
+    while (cgp::SEARCH_IN_PROGRESS == small_steps.step(7)) {
+      ++steps;
+    }
+    CPPUNIT_ASSERT(steps > 1);
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, small_steps.state());
+    CPPUNIT_ASSERT_EQUAL(cheapest, small_steps.path_cost());
+
+    // As with a_star(), an end node next to the node_group but outside of it's
+    // bounds is reachable.
+    cg::vector_t edge(0, 4);
+    while (!blocked_test_map.is_valid(edge.m_x, edge.m_y)) {
+      ++edge.m_y;
+    }
+    cg::vector_t outside = cg::invalid_vector;
+    for (cg::directions_t const * d = tile_traitsT::available_dirs(edge,
+          cg::PATHFINDING_DEFAULT) ; *d != cg::DIR_END ; ++d)
+    {
+      cg::vector_t n = tile_traitsT::get_relative(edge, *d);
+      if (n.m_x < 0) {
+        outside = n;
+      }
+    }
+    CPPUNIT_ASSERT(outside != cg::invalid_vector);
+
+    search_t off_map(blocked_test_map, start, outside, tt, heuristic_t());
+    while (cgp::SEARCH_IN_PROGRESS == off_map.step(0)) {
+    }
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FOUND, off_map.state());
+    CPPUNIT_ASSERT_EQUAL(outside, off_map.path().back());
+
+    // Failures
+    search_t no_path(blocked_test_map, start, cg::vector_t(200, 200), tt,
+        heuristic_t());
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FAILED, no_path.step(0));
+    CPPUNIT_ASSERT_EQUAL(cg::CG_NO_PATH, no_path.error());
+    CPPUNIT_ASSERT(no_path.path().empty());
+
+    search_t invalid(blocked_test_map, start, end, tt, heuristic_t(), 0.5);
+    CPPUNIT_ASSERT_EQUAL(cgp::SEARCH_FAILED, invalid.state());
+    CPPUNIT_ASSERT_EQUAL(cg::CG_INVALID_VALUE, invalid.error());
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PathfindingTest<cartograph::triangular_tile_traits>);
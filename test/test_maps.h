@@ -0,0 +1,158 @@
+/**
+ * This file is part of cartograph, a library for handling tile-based game maps
+ * Copyright (C) 2008 Jens Finkhaeuser <unwesen@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * If this license is unacceptable to you or your business, please contact the
+ * author with your specific requirements.
+ **/
+
+#ifndef CG_TEST_MAPS_H
+#define CG_TEST_MAPS_H
+
+#include <deque>
+
+#include <cartograph/node_group.h>
+#include <cartograph/traversal_traits.h>
+
+/**
+ * Node type, traversal traits, map and path checks shared by the pathfinding
+ * test suites.
+ **/
+namespace
+{
+
+struct test_node
+{
+  test_node(bool blocked = false)
+    : m_blocked(blocked)
+  {
+  }
+
+  bool m_blocked;
+};
+
+
+
+template <typename mapT>
+struct traversal_traits
+  : public cartograph::pathfinding::simple_traversal_traits<mapT>
+{
+  traversal_traits(mapT const & m, bool edges_only = false)
+    : m_map(m)
+    , m_edges_only(edges_only)
+  {
+  }
+
+  bool
+  is_impassable(cartograph::vector_t const & coords,
+      cartograph::directions_t const & d)
+  {
+    return m_map(coords).get_relative(d)->m_blocked;
+  }
+
+
+  cartograph::join_t
+  join_types()
+  {
+    return (m_edges_only ? cartograph::EDGES : cartograph::PATHFINDING_DEFAULT);
+  }
+
+
+  mapT const & m_map;
+  bool m_edges_only;
+};
+
+
+
+/**
+ * Same as above, but looks nodes up with try_get_relative(), which doesn't
+ * modify the map. Use these where copies run on several threads at once.
+ **/
+template <typename mapT>
+struct lookup_traversal_traits
+  : public traversal_traits<mapT>
+{
+  lookup_traversal_traits(mapT const & m, bool edges_only = false)
+    : traversal_traits<mapT>(m, edges_only)
+  {
+  }
+
+  bool
+  is_impassable(cartograph::vector_t const & coords,
+      cartograph::directions_t const & d)
+  {
+    typename mapT::node_data_t const * data
+      = this->m_map.try_get_relative(coords, d);
+    return !data || data->m_blocked;
+  }
+};
+
+
+
+/**
+ * Fills the given map with the same map as in the pathfinding tests: 50x50
+ * nodes, and a wall with gaps at either end.
+ **/
+template <typename mapT>
+void
+make_wall_map(mapT & map)
+{
+  for (uint32_t x = 0 ; x < 50 ; ++x) {
+    for (uint32_t y = 0 ; y < 50 ; ++y) {
+      if (map.is_valid(x, y)) {
+        map(x, y) = test_node(x == 25 && y > 5 && y < 45);
+      }
+    }
+  }
+}
+
+
+
+
+/**
+ * Returns the costs of walking the given path, or -1 if it's not a valid
+ * path, i.e. if any two consecutive nodes aren't neighbours, or the move
+ * between them is impassable.
+ **/
+template <
+  typename tile_traitsT,
+  typename traitsT
+>
+cartograph::unit_t
+path_cost(std::deque<cartograph::vector_t> const & path, traitsT & traits)
+{
+  namespace cg = cartograph;
+
+  cg::unit_t cost = 0;
+  for (std::size_t i = 1 ; i < path.size() ; ++i) {
+    cg::directions_t const * d = tile_traitsT::available_dirs(path[i - 1],
+        traits.join_types());
+    for ( ; *d != cg::DIR_END ; ++d) {
+      if (tile_traitsT::get_relative(path[i - 1], *d) == path[i]) {
+        break;
+      }
+    }
+    if (*d == cg::DIR_END || traits.is_impassable(path[i - 1], *d)) {
+      return -1;
+    }
+    cost += traits.traversal_cost(path[i - 1], *d);
+  }
+  return cost;
+}
+
+} // anonymous namespace
+
+#endif // guard